@@ -11,8 +11,22 @@
 
 #include "Localization/LandmarkContainer.hpp"
 #include "Localization/ConstPosKalmanFilter.hpp"
-#include "Localization/OdomKalmanFilter.hpp"
+#include "Localization/OdomVelocityKalmanFilter.hpp"
+#include "Localization/FixedLagSmoother.hpp"
+#include "Localization/PoseGraph.hpp"
+#include "Localization/HypothesisBank.hpp"
 #include "Localization/PathController.hpp"
+#include "Localization/PathRecorder.hpp"
+#include "Localization/RangeQualityModel.hpp"
+#include "Localization/FilterTuning.hpp"
+#include "Localization/AnchorCalibrator.hpp"
+#include "Localization/OdometryCalibrator.hpp"
+#include "Localization/LatencyCompensator.hpp"
+#include "Localization/OccupancyGrid.hpp"
+#include "Localization/GridPlanner.hpp"
+#include "Localization/Geofence.hpp"
+#include "Localization/ControlExecutor.hpp"
+#include "Localization/SeqLock.hpp"
 
 #include "WorldGrid.hpp"
 #include "Buffer.hpp"
@@ -30,10 +44,27 @@
 #define DEFAULT_LANDMARK_A_POS {-0.725, 0}
 #define DEFAULT_LANDMARK_B_POS {0.725, 0}
 
+// Raw range = range * scale + bias, calibrated per anchor
+#define DEFAULT_LANDMARK_A_SCALE 0.75
+#define DEFAULT_LANDMARK_A_BIAS 0.375
+#define DEFAULT_LANDMARK_B_SCALE 0.75
+#define DEFAULT_LANDMARK_B_BIAS 0.3
+
 #define KF_DEFAULT_POS {0, 0, 0}
 #define KF_DEFAULT_Q 1e-5 //10e-12//10e-12 //100e-12
 #define KF_DEFAULT_R 10
 
+// Estimator state and operator inputs handed to the control thread once per frame
+struct ControlSnapshot
+{
+    double pose[3] = {0, 0, 0}; // Filter pose at the last encoder packet
+    double velocity[2] = {0, 0}; // [v, omega]
+    double packetTime = -1; // s, -1 before the first packet
+    ControlMode_t mode = MANUAL;
+    double manualCommand[2] = {0, 0}; // Wheel speeds (rad/s) asked for in MANUAL
+    bool bStopped = false;
+};
+
 class Application : public BaseApplication 
 {
 public:
@@ -46,10 +77,21 @@ private:
 
     // These render in the order they are declared
     GridRenderer m_WorldGrid;
+    OccupancyGrid m_OccupancyGrid;
+    GridPlanner m_GridPlanner;
     SerialInterface m_RobotSerial;
     LandmarkContainer m_Landmarks;
     PathController m_PathController;
-    OdomKalmanFilter m_KalmanFilter;
+    PathRecorder m_PathRecorder;
+    OdomVelocityKalmanFilter m_KalmanFilter;
+    HypothesisBank m_HypothesisBank;
+    FixedLagSmoother m_LagSmoother;
+    PoseGraph m_PoseGraph;
+    RangeQualityModel m_RangeQuality;
+    AnchorCalibrator m_AnchorCalibrator;
+    OdometryCalibrator m_OdometryCalibrator;
+    LatencyCompensator m_LatencyCompensator;
+    Geofence m_Geofence;
 
     // UI windows
     std::shared_ptr<InfoBar> m_infoBar;
@@ -60,8 +102,17 @@ private:
 
     std::vector<std::shared_ptr<UIwindow>> m_UIwindows;
 
+    // Control thread, declared last so it stops before anything it uses is destroyed.
+    // m_PathController.mutex covers everything the tick touches, the path and the latency compensator.
+    // m_Geofence.mutex is taken inside it for the footprint check.
+    SeqLock<ControlSnapshot> m_ControlSnapshot;
+    Eigen::Vector2d m_CurrentGoal = {0, -0.5}; // Control thread only
+    ControlExecutor m_ControlExecutor;
+
     void OnEvent(SDL_Event *event) override;
     void Update() override;
+    void m_ResetPose(const Eigen::Vector3d& pose, const Eigen::Matrix3d& P);
+    void m_ControlTick(double now);
     void m_HandleViewportInput();
     void m_CalcFrameTime();
 };
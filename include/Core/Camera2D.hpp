@@ -28,6 +28,10 @@ public:
 
     inline int getScale() const { return scale; };
     inline Eigen::Vector2d getPosition() const { return position; };
+    inline Eigen::Vector2d getScreenSize() const { return screenSize; };
+
+    // World box of everything on screen, grown by margin (m)
+    Eigen::AlignedBox2d getVisibleBox(double margin = 0) const;
 };
 
 
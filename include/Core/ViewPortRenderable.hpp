@@ -2,19 +2,23 @@
 
 #include "ViewPort.hpp"
 
+// Headless builds (tools, benchmarks) never register with the viewport so no window is created
 class ViewPortRenderable
 {
 public:
     ViewPortRenderable()
     {
+#ifndef PROJ300_HEADLESS
         ViewPort::GetInstance().AddRenderable(this);
+#endif
     }
 
     ~ViewPortRenderable()
     {
+#ifndef PROJ300_HEADLESS
         ViewPort::GetInstance().RemoveRenderable(this);
+#endif
     }
 
     virtual void render() = 0;
 };
-
@@ -0,0 +1,59 @@
+#pragma once
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "AnchorTable.hpp"
+#include "Kinematics.hpp"
+
+#define ANCHOR_CAL_STATES 4 // x, y, scale, bias per anchor
+#define ANCHOR_CAL_POS_STDDEV 0.5
+#define ANCHOR_CAL_SCALE_STDDEV 0.2
+#define ANCHOR_CAL_BIAS_STDDEV 0.5
+#define ANCHOR_CAL_DEFAULT_R 0.0025 // Corrected range variance (m^2)
+#define ANCHOR_CAL_GATE 16.0
+
+// EKF over the robot pose and every anchor's position and range calibration.
+// Raw ranges are used directly so scale and bias converge with the anchor positions while the robot drives.
+class AnchorCalibrator : public ViewPortRenderable
+{
+public:
+    Eigen::VectorXd x; // State vector: [x, y, theta, (anchor x, anchor y, scale, bias) per anchor]
+    Eigen::MatrixXd P; // State covariance matrix
+
+    double processNoise;
+    double measurementNoise;
+    double anchorProcessNoise = 0; // Lets the anchors drift slowly, zero for fixed anchors
+    double gateThreshold = ANCHOR_CAL_GATE;
+
+    bool bEnabled = false;
+    size_t acceptedCount = 0;
+    size_t rejectedCount = 0;
+
+    float encoderA = 0;
+    float encoderB = 0;
+
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+public:
+    AnchorCalibrator(double processNoise, double measurementNoise = ANCHOR_CAL_DEFAULT_R);
+
+    // Start from the current pose estimate and anchor table, the table values are used as priors
+    void reset(const Eigen::Vector3d& pose, const Eigen::Matrix3d& poseCovariance, const AnchorTable& anchors);
+    // Forget what is known about one anchor, used after it has been moved
+    void releaseAnchor(int anchor);
+
+    void predict(const Eigen::Vector2d& U, double dt);
+    bool updateRange(int anchor, double rawRange);
+
+    int anchorCount() const { return static_cast<int>((x.size() - 3) / ANCHOR_CAL_STATES); }
+    static int anchorOffset(int anchor) { return 3 + ANCHOR_CAL_STATES * anchor; }
+
+    Eigen::Vector2d anchorPos(int anchor) const { return x.segment<2>(anchorOffset(anchor)); }
+    double anchorScale(int anchor) const { return x(anchorOffset(anchor) + 2); }
+    double anchorBias(int anchor) const { return x(anchorOffset(anchor) + 3); }
+    Eigen::Matrix2d anchorCovariance(int anchor) const { return P.block<2, 2>(anchorOffset(anchor), anchorOffset(anchor)); }
+
+    // Copy the estimated positions and calibrations into an anchor table of the same size
+    void applyTo(AnchorTable& anchors) const;
+
+    void render() override;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <Eigen/Dense>
+#include <cstdint>
+#include <vector>
+
+#define ANCHOR_MIN_RANGE 1e-6
+
+// Indexed UWB anchor table stored as contiguous arrays, anchor i has packet ID 'A' + i
+struct AnchorTable
+{
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> range;     // Latest corrected range (m)
+    std::vector<double> scale;     // Raw range scale factor
+    std::vector<double> bias;      // Raw range offset (m)
+    std::vector<double> timestamp; // Time of the latest range (s)
+
+    size_t size() const { return x.size(); }
+
+    static int indexFromId(uint8_t id) { return static_cast<int>(id) - 'A'; }
+    static char idFromIndex(int index) { return static_cast<char>('A' + index); }
+
+    bool isValid(int index) const { return index >= 0 && index < static_cast<int>(size()); }
+
+    int add(const Eigen::Vector2d& pos, double rangeScale = 1.0, double rangeBias = 0.0)
+    {
+        x.push_back(pos.x());
+        y.push_back(pos.y());
+        range.push_back(0);
+        scale.push_back(rangeScale);
+        bias.push_back(rangeBias);
+        timestamp.push_back(0);
+        return static_cast<int>(size()) - 1;
+    }
+
+    // Only the last anchor can go, removing any other would move every later anchor onto the previous packet ID
+    void removeLast()
+    {
+        if (size() == 0) return;
+        x.pop_back();
+        y.pop_back();
+        range.pop_back();
+        scale.pop_back();
+        bias.pop_back();
+        timestamp.pop_back();
+    }
+
+    Eigen::Vector2d position(int index) const { return {x[index], y[index]}; }
+
+    void setPosition(int index, const Eigen::Vector2d& pos)
+    {
+        x[index] = pos.x();
+        y[index] = pos.y();
+    }
+
+    // Apply the per anchor calibration to a raw range
+    double correctRange(int index, double rawRange) const { return rawRange * scale[index] + bias[index]; }
+
+    // Predicted ranges and range Jacobian rows d(range)/d(x, y) to every anchor from one position
+    void predictRanges(const Eigen::Vector2d& pos, Eigen::VectorXd& ranges, Eigen::Matrix<double, Eigen::Dynamic, 2>& H) const
+    {
+        const Eigen::Index n = static_cast<Eigen::Index>(size());
+        Eigen::Map<const Eigen::ArrayXd> anchorX(x.data(), n);
+        Eigen::Map<const Eigen::ArrayXd> anchorY(y.data(), n);
+
+        H.resize(n, 2);
+        H.col(0).array() = pos.x() - anchorX;
+        H.col(1).array() = pos.y() - anchorY;
+
+        ranges.resize(n);
+        ranges.array() = (H.col(0).array().square() + H.col(1).array().square()).sqrt().max(ANCHOR_MIN_RANGE);
+        H.array().colwise() /= ranges.array();
+    }
+
+    // Predicted ranges only
+    Eigen::VectorXd predictRanges(const Eigen::Vector2d& pos) const
+    {
+        const Eigen::Index n = static_cast<Eigen::Index>(size());
+        Eigen::Map<const Eigen::ArrayXd> anchorX(x.data(), n);
+        Eigen::Map<const Eigen::ArrayXd> anchorY(y.data(), n);
+
+        return ((pos.x() - anchorX).square() + (pos.y() - anchorY).square()).sqrt().matrix();
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <Eigen/Dense>
+#include <cmath>
+#include <vector>
+
+#define CONSISTENCY_WINDOW_SIZE 200
+
+// Mean and variance over the last N samples, O(1) per sample
+class RollingStat
+{
+private:
+    std::vector<double> m_Samples;
+    size_t m_Head = 0;
+    size_t m_Count = 0;
+    double m_Sum = 0;
+    double m_SumSq = 0;
+
+public:
+    RollingStat(size_t windowSize = CONSISTENCY_WINDOW_SIZE) : m_Samples(windowSize, 0.0) {}
+
+    void add(double sample)
+    {
+        if (m_Count == m_Samples.size())
+        {
+            double oldest = m_Samples[m_Head];
+            m_Sum -= oldest;
+            m_SumSq -= oldest * oldest;
+        }
+        else
+        {
+            m_Count++;
+        }
+
+        m_Samples[m_Head] = sample;
+        m_Sum += sample;
+        m_SumSq += sample * sample;
+        m_Head = (m_Head + 1) % m_Samples.size();
+
+        // Re-sum once per lap so rounding errors cannot build up
+        if (m_Head == 0)
+        {
+            m_Sum = 0;
+            m_SumSq = 0;
+            for (size_t i = 0; i < m_Count; i++)
+            {
+                m_Sum += m_Samples[i];
+                m_SumSq += m_Samples[i] * m_Samples[i];
+            }
+        }
+    }
+
+    void reset()
+    {
+        m_Head = 0;
+        m_Count = 0;
+        m_Sum = 0;
+        m_SumSq = 0;
+    }
+
+    size_t count() const { return m_Count; }
+    size_t windowSize() const { return m_Samples.size(); }
+    double mean() const { return (m_Count > 0) ? m_Sum / m_Count : 0.0; }
+    double variance() const { return (m_Count > 1) ? std::max(m_SumSq / m_Count - mean() * mean(), 0.0) : 0.0; }
+};
+
+// Per anchor gating counters and rolling NIS / NEES statistics for a filter
+class ConsistencyMonitor
+{
+public:
+    struct AnchorStats
+    {
+        size_t accepted = 0;
+        size_t rejected = 0;
+        int consecutiveRejects = 0;
+        RollingStat nis;
+    };
+
+    std::vector<AnchorStats> anchors;
+    RollingStat nis;  // Normalised innovation squared of every accepted range (1 DOF)
+    RollingStat nees; // Normalised estimation error squared, only available with ground truth (3 DOF)
+    size_t totalAccepted = 0;
+    size_t totalRejected = 0;
+    double totalNis = 0; // Sum over every accepted range, for offline scoring
+
+    AnchorStats& anchor(int index)
+    {
+        if (index >= static_cast<int>(anchors.size())) anchors.resize(index + 1);
+        return anchors[index];
+    }
+
+    void addAccepted(int index, double nisValue)
+    {
+        AnchorStats& stats = anchor(index);
+        stats.accepted++;
+        stats.consecutiveRejects = 0;
+        stats.nis.add(nisValue);
+        nis.add(nisValue);
+        totalNis += nisValue;
+        totalAccepted++;
+    }
+
+    void addRejected(int index)
+    {
+        AnchorStats& stats = anchor(index);
+        stats.rejected++;
+        stats.consecutiveRejects++;
+        totalRejected++;
+    }
+
+    double meanNis() const { return (totalAccepted > 0) ? totalNis / totalAccepted : 0.0; }
+    double rejectedFraction() const { return (totalAccepted + totalRejected > 0) ? static_cast<double>(totalRejected) / (totalAccepted + totalRejected) : 0.0; }
+
+    void addNees(const Eigen::Vector3d& error, const Eigen::Matrix3d& P)
+    {
+        nees.add(error.dot(P.ldlt().solve(error)));
+    }
+
+    // Two sided 95% bounds on the window mean of a chi-square statistic with the given DOF
+    static void meanBounds(const RollingStat& stat, double dof, double& lower, double& upper)
+    {
+        double spread = 1.96 * std::sqrt(2.0 * dof / std::max<double>(static_cast<double>(stat.count()), 1.0));
+        lower = std::max(dof - spread, 0.0);
+        upper = dof + spread;
+    }
+
+    void reset()
+    {
+        anchors.clear();
+        nis.reset();
+        nees.reset();
+        totalAccepted = 0;
+        totalRejected = 0;
+        totalNis = 0;
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "SeqLock.hpp"
+
+#define CTRL_STATS_WINDOW 500 // Ticks
+
+// Timing of the control thread, all times in us
+struct ControlStats
+{
+    uint64_t ticks = 0;
+    uint64_t overruns = 0; // Releases missed because a tick ran past the next deadline
+    double meanJitter = 0; // Wake up after the deadline
+    double sdJitter = 0;
+    double maxJitter = 0;
+    double meanExec = 0;
+    double maxExec = 0;
+};
+
+// Runs a task at a fixed period on its own thread, independent of the frame rate.
+// Each release is an absolute deadline on the monotonic clock, so a late wake up or a slow tick does not
+// push the following ticks back. A tick that runs past the next deadline skips the missed releases rather
+// than running them back to back, and counts them as overruns.
+class ControlExecutor
+{
+public:
+    // Gets the host time of the tick (s), on the SDL_GetTicksNS clock
+    typedef std::function<void(double now)> Task;
+
+public:
+    ~ControlExecutor();
+
+    void start(double rateHz, Task task);
+    void stop();
+    bool isRunning() const { return m_Worker != nullptr; }
+    double period() const { return m_PeriodNs / 1e9; }
+
+    // Lock free, any thread
+    ControlStats stats() const { return m_Stats.load(); }
+    void resetStats() { m_bResetStats = true; }
+
+private:
+    std::thread* m_Worker = nullptr;
+    std::atomic_bool m_RunThread = false;
+    std::atomic_bool m_bResetStats = false;
+    int64_t m_PeriodNs = 0;
+    Task m_Task;
+    SeqLock<ControlStats> m_Stats;
+
+    void m_ControlTask();
+};
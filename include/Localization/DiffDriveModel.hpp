@@ -0,0 +1,59 @@
+#pragma once
+#include <Eigen/Dense>
+#include <cmath>
+
+// Motion and range models shared by the robot estimators, state is [x, y, theta]
+struct DiffDriveModel
+{
+    // Differential drive odometry step from the distance travelled by each wheel
+    static Eigen::Vector3d motion(const Eigen::Vector3d& state, double dL, double dR, double chassisWidth)
+    {
+        double d = (dL + dR) / 2.0;
+        double dTheta = (dR - dL) / chassisWidth;
+        double heading = state.z() + dTheta / 2.0;
+
+        return {state.x() + d * cos(heading), state.y() + d * sin(heading), state.z() + dTheta};
+    }
+
+    // Jacobian of the motion model wrt the state
+    static Eigen::Matrix3d motionJacobian(const Eigen::Vector3d& state, double dL, double dR, double chassisWidth)
+    {
+        double d = (dL + dR) / 2.0;
+        double dTheta = (dR - dL) / chassisWidth;
+        double heading = state.z() + dTheta / 2.0;
+
+        Eigen::Matrix3d F;
+        F << 1, 0, -d * sin(heading),
+             0, 1,  d * cos(heading),
+             0, 0,  1;
+        return F;
+    }
+
+    // Motion model applied to every column of a fixed size set of states (sigma points)
+    template <int N>
+    static void motionBatch(Eigen::Matrix<double, 3, N>& states, double dL, double dR, double chassisWidth)
+    {
+        double d = (dL + dR) / 2.0;
+        double dTheta = (dR - dL) / chassisWidth;
+        Eigen::Array<double, 1, N> heading = states.row(2).array() + dTheta / 2.0;
+
+        states.row(0).array() += d * heading.cos();
+        states.row(1).array() += d * heading.sin();
+        states.row(2).array() += dTheta;
+    }
+
+    // Expected range from the state to a landmark
+    static double range(const Eigen::Vector3d& state, const Eigen::Vector2d& landmarkPos)
+    {
+        return (state.head<2>() - landmarkPos).norm();
+    }
+
+    // Expected range from every column of a fixed size set of states to a landmark
+    template <int N>
+    static Eigen::Matrix<double, 1, N> rangeBatch(const Eigen::Matrix<double, 3, N>& states, const Eigen::Vector2d& landmarkPos)
+    {
+        Eigen::Array<double, 1, N> dx = states.row(0).array() - landmarkPos.x();
+        Eigen::Array<double, 1, N> dy = states.row(1).array() - landmarkPos.y();
+        return (dx * dx + dy * dy).sqrt().matrix();
+    }
+};
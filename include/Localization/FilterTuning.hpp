@@ -0,0 +1,72 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <fstream>
+#include <string>
+
+#include "OdomKalmanFilter.hpp"
+
+#define TUNING_DEFAULT_FILE "KalmanTuning.cfg"
+
+// Noise parameters for the EKF written by the KalmanTune tool, loaded by the app when present
+struct FilterTuning
+{
+    double processNoise = 0;
+    double measurementNoise = 0;
+    double gateThreshold = KF_DEFAULT_GATE;
+    double score = 0; // Tuner score the values were chosen with, lower is better
+
+    void applyTo(OdomKalmanFilter& filter) const
+    {
+        filter.processNoise = processNoise;
+        filter.measurementNoise = measurementNoise;
+        filter.gateThreshold = gateThreshold;
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if (!file.is_open())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "TUNING ERROR: Unable to open file %s for writing\n", path.c_str());
+            return false;
+        }
+
+        file.precision(9);
+        file << "processNoise " << processNoise << "\n";
+        file << "measurementNoise " << measurementNoise << "\n";
+        file << "gateThreshold " << gateThreshold << "\n";
+        file << "score " << score << "\n";
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "TUNING INFO: Tuning saved to %s\n", path.c_str());
+        return true;
+    }
+
+    bool load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "TUNING INFO: No tuning at %s, using defaults\n", path.c_str());
+            return false;
+        }
+
+        std::string key;
+        double value;
+        while (file >> key >> value)
+        {
+            if (key == "processNoise") processNoise = value;
+            else if (key == "measurementNoise") measurementNoise = value;
+            else if (key == "gateThreshold") gateThreshold = value;
+            else if (key == "score") score = value;
+        }
+
+        if (processNoise <= 0 || measurementNoise <= 0)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "TUNING ERROR: %s is missing the noise values\n", path.c_str());
+            return false;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "TUNING INFO: Tuning loaded from %s\n", path.c_str());
+        return true;
+    }
+};
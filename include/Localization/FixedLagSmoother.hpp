@@ -0,0 +1,66 @@
+#pragma once
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <Eigen/Dense>
+
+#include "Core/ViewPortRenderable.hpp"
+#include "OdomKalmanFilter.hpp"
+#include "RtsSmoother.hpp"
+
+#define FLS_DEFAULT_LAG 0.3 // s
+#define FLS_MAX_STEPS 64 // Bounds the cost of each update, about 0.6 s of encoder packets
+
+// Smoothed pose a fixed time behind the live EKF.
+// The steps of the filter inside the lag window are kept, each accepted range re-runs the RTS backward
+// pass over the window only, so the cost per measurement is bounded by the window length.
+class FixedLagSmoother : public ViewPortRenderable
+{
+public:
+    bool bEnabled = true;
+    double lag = FLS_DEFAULT_LAG;
+    size_t maxSteps = FLS_MAX_STEPS;
+
+    RtsSmoother<3> smoother;
+
+public:
+    FixedLagSmoother() { smoother.angleIndex = 2; }
+
+    void clear() { smoother.clear(); }
+
+    // After every filter predict
+    void addPrediction(double time, const OdomKalmanFilter& filter)
+    {
+        if (!bEnabled) return;
+        smoother.addPrediction(time, filter.x, filter.P, filter.F);
+
+        // Keep one step older than the lag so the lagged estimate is always inside the window
+        while (smoother.size() > maxSteps || (smoother.size() > 2 && smoother.steps[1].time <= time - lag))
+        {
+            smoother.steps.pop_front();
+        }
+    }
+
+    // After every accepted measurement update
+    void addUpdate(const OdomKalmanFilter& filter)
+    {
+        if (!bEnabled || smoother.size() == 0) return;
+        smoother.setPosterior(filter.x, filter.P);
+        smoother.smooth();
+    }
+
+    bool hasEstimate() const { return smoother.size() > 1; }
+
+    // Oldest step in the window, the one closest to the lag behind the newest
+    double laggedTime() const { return hasEstimate() ? smoother.steps.front().time : 0.0; }
+    Eigen::Vector3d laggedPose() const { return hasEstimate() ? smoother.steps.front().xSmooth : Eigen::Vector3d::Zero(); }
+    Eigen::Matrix3d laggedCovariance() const { return hasEstimate() ? smoother.steps.front().PSmooth : Eigen::Matrix3d::Identity(); }
+
+    void render() override
+    {
+        if (!bEnabled || !hasEstimate()) return;
+
+        Eigen::Vector3d pose = laggedPose();
+        double size = KinematicParams::GetShared().trackWidth;
+        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().robotTexture, pose.head(2), {size, size}, -pose.z() + M_PI_2, GREEN, 100);
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <mutex>
+#include <vector>
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "Kinematics.hpp"
+#include "ConsistencyMonitor.hpp"
+
+#define GEOFENCE_DEFAULT_RADIUS 0.1 // m, robot footprint as a disc
+#define GEOFENCE_DEFAULT_HORIZON 0.5 // s, commanded motion is predicted this far ahead
+#define GEOFENCE_STEPS 10 // Footprints checked along the horizon
+#define GEOFENCE_LEAF_EDGES 4
+#define GEOFENCE_STATS_WINDOW 250
+#define GEOFENCE_DEPTH_TOLERANCE 1e-9 // m, turning on the spot outside the fence is not a step deeper
+
+// Keep in and keep out polygons checked against the robot footprint.
+// Every zone edge goes into one bounding volume hierarchy, so a footprint check is a point in polygon
+// ray cast and a nearest edge test that only visit the boxes near the robot.
+// With keep in zones the robot must stay inside one of them, and a footprint touching any zone edge counts
+// as leaving, so overlapping keep in zones are not merged.
+class Geofence : public ViewPortRenderable
+{
+public:
+    struct Zone
+    {
+        std::vector<Eigen::Vector2d> vertices;
+        bool bKeepOut = false;
+    };
+
+    bool bEnabled = true;
+    bool bRender = true;
+    bool bEditing = false;
+    bool bNewKeepOut = true; // Kind of zone the next edited polygon becomes
+
+    double robotRadius = GEOFENCE_DEFAULT_RADIUS;
+    double horizon = GEOFENCE_DEFAULT_HORIZON;
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    // Control thread, time per trajectory check (us)
+    RollingStat checkTime = RollingStat(GEOFENCE_STATS_WINDOW);
+    size_t violations = 0;
+    bool bViolating = false;
+
+    // The control thread holds this for each check, the main thread takes it to edit or read the zones
+    std::mutex mutex;
+
+public:
+    const std::vector<Zone>& zones() const { return m_Zones; }
+    size_t edgeCount() const { return m_Edges.size(); }
+
+    void addZone(const std::vector<Eigen::Vector2d>& vertices, bool bKeepOut);
+    void removeZoneAt(const Eigen::Vector2d& point);
+    void clear();
+
+    // Outline being drawn in the viewport
+    void addPendingVertex(const Eigen::Vector2d& vertex) { m_Pending.push_back(vertex); }
+    size_t pendingCount() const { return m_Pending.size(); }
+    void closePending();
+
+    bool isPointAllowed(const Eigen::Vector2d& point);
+    bool isDiscAllowed(const Eigen::Vector2d& center, double radius);
+
+    // Footprints along the wheel rim speeds (m/s) held for the horizon from pose.
+    // A robot that is already outside may make any motion that never takes its footprint deeper, so it can
+    // always drive back in the way it came. Once a footprint is allowed again the rest must stay allowed.
+    bool isMotionAllowed(const Eigen::Vector3d& pose, double speedL, double speedR);
+
+    void render() override;
+
+private:
+    struct Edge
+    {
+        Eigen::Vector2d a, b;
+        int zone;
+    };
+
+    struct Node
+    {
+        Eigen::AlignedBox2d box;
+        int left = -1;
+        int right = -1;
+        int first = 0; // Leaf edge range
+        int count = 0;
+    };
+
+    std::vector<Zone> m_Zones;
+    std::vector<Edge> m_Edges;
+    std::vector<Node> m_Nodes;
+    std::vector<uint8_t> m_Parity; // Per zone scratch for the ray cast
+    std::vector<int> m_Stack;
+    std::vector<Eigen::Vector2d> m_Pending;
+    std::vector<Eigen::Vector2d> m_LastFootprints; // Drawn while violating
+
+    void m_Rebuild();
+    int m_BuildNode(int first, int count);
+    bool m_EdgeWithin(const Eigen::Vector2d& point, double radius);
+    double m_NearestEdge(const Eigen::Vector2d& point);
+
+    // How far a disallowed footprint reaches past the nearest zone edge (m), the robot radius minus the edge
+    // distance when only the rim is over it and plus it when the centre is out. Overlapping zones make it
+    // an underestimate, an edge inside another zone is not a way out.
+    double m_Penetration(const Eigen::Vector2d& center);
+    void m_CastRay(const Eigen::Vector2d& point);
+};
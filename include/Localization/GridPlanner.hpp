@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "OccupancyGrid.hpp"
+
+#define PLAN_MAX_EXPANSIONS 25000 // Per update, a longer search carries on in the next frame
+#define PLAN_RESTART_RATIO 0.5 // A repair that runs past this share of the last fresh search starts again from scratch
+#define PLAN_MAX_SEGMENT 200 // Cells, longest straight run kept when the cell path is simplified
+
+// D* Lite over the inflated occupancy grid, 8 connected with an octile heuristic.
+// The search runs from the goal back to the robot so the costs to go stay valid as the robot moves,
+// and obstacle edits only reopen the cells around them. Costs are in cells.
+class GridPlanner : public ViewPortRenderable
+{
+public:
+    bool bEnabled = false;
+    bool bRender = true;
+    int maxExpansions = PLAN_MAX_EXPANSIONS;
+
+    // Simplified world path from the robot to the goal, empty when there is none
+    std::vector<Eigen::Vector2d> path;
+    bool bPathFound = false;
+
+    // Last update
+    size_t lastExpansions = 0;
+    double lastPlanTime = 0; // ms
+    bool bSearching = false; // The budget ran out before the search settled
+    size_t restarts = 0; // Repairs abandoned for a fresh search
+
+public:
+    GridPlanner(const OccupancyGrid& grid);
+
+    // Drops all search state, needed after the grid is resized or reinflated
+    void reset();
+
+    void setGoal(const Eigen::Vector2d& goal);
+    bool hasGoal() const { return m_Goal >= 0; }
+    Eigen::Vector2d goal() const { return m_GoalPos; }
+
+    // Cost to go from the robot in cells, infinite when there is no path
+    float startCost() const { return (bPathFound && m_Start >= 0) ? m_Rhs[m_Start] : std::numeric_limits<float>::infinity(); }
+
+    // Cells inside rect changed their blocked state
+    void onGridChanged(const GridRect& rect);
+
+    // Moves the start to the robot, repairs the search and extracts the path
+    void update(const Eigen::Vector2d& start);
+
+    void render() override;
+
+private:
+    struct Key
+    {
+        float k1, k2;
+        bool operator<(const Key& other) const { return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2); }
+    };
+
+    struct Entry
+    {
+        Key key;
+        int cell;
+        bool operator>(const Entry& other) const { return other.key < key; }
+    };
+
+    const OccupancyGrid& m_Grid;
+    int m_Width = 0;
+
+    // Indexed by y * width + x
+    std::vector<float> m_G;
+    std::vector<float> m_Rhs;
+    std::vector<uint8_t> m_bOpen; // Cells on the queue, stale entries are skipped when popped
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> m_Open;
+
+    int m_Start = -1;
+    int m_LastStart = -1;
+    int m_Goal = -1;
+    Eigen::Vector2d m_GoalPos = Eigen::Vector2d::Zero();
+    bool m_bGoalSet = false;
+    float m_Km = 0;
+    size_t m_RepairExpansions = 0; // Since the search last settled
+    size_t m_FreshExpansions = 0; // Taken by the last search from scratch to settle
+    bool m_bFreshSearch = false;
+    bool m_bPathStale = false; // The start, the grid or the costs changed since the path was extracted
+
+    int m_Cell(int x, int y) const { return y * m_Width + x; }
+    int m_X(int cell) const { return cell % m_Width; }
+    int m_Y(int cell) const { return cell / m_Width; }
+
+    float m_Heuristic(int a, int b) const;
+    float m_Cost(int from, int to) const; // Infinite when either end is blocked or the move cuts a corner
+    Key m_Key(int cell) const;
+
+    float m_BestSuccessor(int cell, int* best) const;
+    void m_UpdateVertex(int cell);
+    void m_Requeue(int cell);
+    bool m_ComputeShortestPath();
+    void m_ExtractPath();
+    bool m_LineOfSight(int from, int to) const;
+
+    template <typename F>
+    void m_ForNeighbours(int cell, F&& visit) const
+    {
+        static const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+        static const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+        int x = m_X(cell), y = m_Y(cell);
+        for (int i = 0; i < 8; i++)
+        {
+            if (m_Grid.inBounds(x + dx[i], y + dy[i])) visit(m_Cell(x + dx[i], y + dy[i]));
+        }
+    }
+};
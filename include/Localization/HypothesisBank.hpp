@@ -0,0 +1,64 @@
+#pragma once
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "Multilateration.hpp"
+#include "Kinematics.hpp"
+
+#define MHT_MAX_HYPOTHESES 16
+#define MHT_HEADINGS 4 // Heading hypotheses per position, the heading is unknown at startup
+#define MHT_DEFAULT_R 0.0025 // Range variance (m^2)
+#define MHT_PRUNE_WEIGHT 1e-3 // Hypotheses below this normalised weight are dropped
+#define MHT_MERGE_DISTANCE 1.0 // Squared Mahalanobis distance below which two hypotheses are merged
+#define MHT_CONFIDENCE 0.95 // Weight of the best hypothesis before it is handed to the live filter
+#define MHT_MIN_UPDATES 50
+
+// Bank of EKFs over the pose, one per hypothesis, used to localise without a starting pose.
+// With two anchors the multilateration fix has a mirror solution, each position is seeded with several
+// headings and the odometry separates the mirror as the robot turns. Range likelihoods weight the
+// hypotheses, unlikely ones are pruned and ones that converge onto each other are merged.
+// States and covariances are stored one column per hypothesis so every update runs over contiguous memory.
+class HypothesisBank : public ViewPortRenderable
+{
+public:
+    Eigen::Matrix<double, 3, Eigen::Dynamic> X; // [x, y, theta] per hypothesis
+    Eigen::Matrix<double, 9, Eigen::Dynamic> P; // Column major 3x3 covariance per hypothesis
+    Eigen::RowVectorXd logWeight;               // Normalised so the largest is zero
+
+    double processNoise;
+    double measurementNoise;
+
+    bool bEnabled = true;
+    size_t updateCount = 0;
+
+    float encoderA = 0;
+    float encoderB = 0;
+
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+public:
+    HypothesisBank(double processNoise, double measurementNoise = MHT_DEFAULT_R);
+
+    // Hypotheses at the fix and its mirror, each with MHT_HEADINGS headings
+    void seed(const MultilaterationResult& fix);
+    void reset();
+
+    bool isSeeded() const { return X.cols() > 0; }
+    int size() const { return static_cast<int>(X.cols()); }
+
+    void predict(const Eigen::Vector2d& U);
+    void updateRange(const Eigen::Vector2d& landmarkPos, double range);
+
+    Eigen::RowVectorXd weights() const;
+    int best() const;
+    bool isConverged() const;
+
+    Eigen::Vector3d pose(int i) const { return X.col(i); }
+    Eigen::Matrix3d covariance(int i) const { return Eigen::Map<const Eigen::Matrix3d>(P.col(i).data()); }
+
+    void render() override;
+
+private:
+    void m_Normalise();
+    void m_PruneAndMerge();
+    void m_Remove(int i);
+};
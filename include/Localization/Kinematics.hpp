@@ -0,0 +1,20 @@
+#pragma once
+
+#define KINEMATICS_DEFAULT_WHEEL_RADIUS 0.03 // m
+#define KINEMATICS_DEFAULT_TRACK_WIDTH 0.173 // m
+
+// Wheel geometry of the robot, read by the estimators, the path controller and the robot sprite.
+// Left and right radii are separate so a calibration can take out a constant heading drift.
+struct KinematicParams
+{
+    double wheelRadiusL = KINEMATICS_DEFAULT_WHEEL_RADIUS; // Encoder A
+    double wheelRadiusR = KINEMATICS_DEFAULT_WHEEL_RADIUS; // Encoder B
+    double trackWidth = KINEMATICS_DEFAULT_TRACK_WIDTH;
+
+    // Block used by the application, filters and controllers point here unless given their own
+    static KinematicParams& GetShared()
+    {
+        static KinematicParams shared;
+        return shared;
+    }
+};
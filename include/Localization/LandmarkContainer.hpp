@@ -5,22 +5,21 @@
 #include <vector>
 
 #include "Core/ViewPortRenderable.hpp"
+#include "Localization/AnchorTable.hpp"
+#include "Localization/Multilateration.hpp"
+#include "SerialInterface.hpp"
 
-#define LANDMARK_A_CALIBRATION 0.75f + 0.375f
-#define LANDMARK_B_CALIBRATION 0.75f + 0.3f
+#define LANDMARK_MAX_RANGE 10
 
 class LandmarkContainer : public ViewPortRenderable
 {
 private:
-    Eigen::Vector2d m_LandmarkPosA;
-    Eigen::Vector2d m_LandmarkPosB;
-    Eigen::Vector2d m_posEstimateA;
-    Eigen::Vector2d m_posEstimateB;
+    AnchorTable m_Anchors;
+    Multilateration m_Solver;
+    MultilaterationResult m_Fix;
+    bool m_bFixDirty = true;
 
 public:
-    double rangeA = 0;
-    double rangeB = 0;
-
     int rangeAlpha = 20;
 
     bool bDrawRange = true;
@@ -28,143 +27,156 @@ public:
     bool bDrawRawPos = false;
 
     LandmarkContainer() = default;
-    LandmarkContainer(Eigen::Vector2d m_LandmarkPosA_, Eigen::Vector2d LandmarkPosB_);
+    LandmarkContainer(const std::vector<Eigen::Vector2d>& landmarkPositions);
 
-    void OnNewPacket(LandmarkPacket *packet);
-    void calculatePos(bool printDebug = false);
-    void updateRange(double _rangeA, double _rangeB);
+    bool OnNewPacket(LandmarkPacket *packet, double timestamp);
+    const MultilaterationResult& getFix();
+    void invalidateFix() { m_bFixDirty = true; }
+    void updateRange(const Eigen::VectorXd& ranges);
     void simulateRange(Eigen::Vector2d realPosition, double sttdev);
-    void SetLandmarkPos(char Landmark, Eigen::Vector2d newPos);
-    
-    Eigen::Vector2d getPosEstimate(bool printDebug = false);
-    Eigen::Vector2d getLandmarkPos(char Landmark);
-    double getLandmarkRange(char Landmark);
+    void simulateRange(Eigen::Vector2d realPosition, double sttdev, std::mt19937& gen);
+    int AddLandmark(Eigen::Vector2d pos, double rangeScale = 1.0, double rangeBias = 0.0);
+    void SetLandmarkPos(int landmark, Eigen::Vector2d newPos);
+
+    Eigen::Vector2d getPosEstimate();
+    Eigen::Vector2d getLandmarkPos(int landmark);
+    double getLandmarkRange(int landmark);
+    size_t getLandmarkCount() { return m_Anchors.size(); }
+    AnchorTable& getAnchors() { return m_Anchors; }
 
     void render();
 };
 
-inline LandmarkContainer::LandmarkContainer(Eigen::Vector2d m_LandmarkPosA_, Eigen::Vector2d LandmarkPosB_) 
-    : m_LandmarkPosA(m_LandmarkPosA_), m_LandmarkPosB(LandmarkPosB_) {}
+inline LandmarkContainer::LandmarkContainer(const std::vector<Eigen::Vector2d>& landmarkPositions)
+{
+    for (const Eigen::Vector2d& pos : landmarkPositions)
+    {
+        m_Anchors.add(pos);
+    }
+}
 
-inline Eigen::Vector2d LandmarkContainer::getLandmarkPos(char Landmark)
+inline int LandmarkContainer::AddLandmark(Eigen::Vector2d pos, double rangeScale, double rangeBias)
 {
-    if(Landmark == 'A'){return m_LandmarkPosA;}
-    else if(Landmark == 'B'){return m_LandmarkPosB;}
-    else return {0, 0};
+    m_bFixDirty = true;
+    return m_Anchors.add(pos, rangeScale, rangeBias);
 }
 
-inline double LandmarkContainer::getLandmarkRange(char Landmark)
+inline Eigen::Vector2d LandmarkContainer::getLandmarkPos(int landmark)
 {
-    if(Landmark =='A'){return rangeA;}
-    else if(Landmark == 'B'){return rangeB;}
-    else return 0;
+    return m_Anchors.isValid(landmark) ? m_Anchors.position(landmark) : Eigen::Vector2d(0, 0);
 }
 
-inline void LandmarkContainer::SetLandmarkPos(char Landmark, Eigen::Vector2d newPos)
+inline double LandmarkContainer::getLandmarkRange(int landmark)
 {
-    if(Landmark =='A')
-    {
-        m_LandmarkPosA = newPos;
-    }
-    else if(Landmark == 'B')
+    return m_Anchors.isValid(landmark) ? m_Anchors.range[landmark] : 0;
+}
+
+inline void LandmarkContainer::SetLandmarkPos(int landmark, Eigen::Vector2d newPos)
+{
+    if (m_Anchors.isValid(landmark))
     {
-        m_LandmarkPosB = newPos;
+        m_Anchors.setPosition(landmark, newPos);
+        m_bFixDirty = true;
     }
 }
 
 inline void LandmarkContainer::render()
 {
-    calculatePos();
-    if(bDrawRange)
-    {
-        //Draw Landmark Range
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_LandmarkPosA, Eigen::Vector2d(2.0 * rangeA, 2.0 * rangeA), 0, RED, rangeAlpha);
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_LandmarkPosB, Eigen::Vector2d(2.0 * rangeB, 2.0 * rangeB), 0, GREEN, rangeAlpha);
-    }
+    static const uint8_t palette[][3] = {{RED}, {GREEN}, {BLUE}, {YELLOW}, {WHITE}, {DARK_BLUE}};
+    const size_t paletteSize = sizeof(palette) / sizeof(palette[0]);
 
-    if (bDrawLandmarks)
+    for (size_t i = 0; i < m_Anchors.size(); i++)
     {
-        //Draw Landmarks
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_LandmarkPosA, Eigen::Vector2d(0.1, 0.1), 0, RED, SDL_ALPHA_OPAQUE);
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_LandmarkPosB, Eigen::Vector2d(0.1, 0.1), 0, GREEN, SDL_ALPHA_OPAQUE);
+        const uint8_t* colour = palette[i % paletteSize];
+        Eigen::Vector2d anchorPos = m_Anchors.position(static_cast<int>(i));
+        double range = m_Anchors.range[i];
+
+        if(bDrawRange)
+        {
+            //Draw Landmark Range
+            ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, anchorPos, Eigen::Vector2d(2.0 * range, 2.0 * range), 0, colour[0], colour[1], colour[2], rangeAlpha);
+        }
+
+        if (bDrawLandmarks)
+        {
+            //Draw Landmarks
+            ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, anchorPos, Eigen::Vector2d(0.1, 0.1), 0, colour[0], colour[1], colour[2], SDL_ALPHA_OPAQUE);
+        }
     }
 
-    if (bDrawRawPos)
+    if (bDrawRawPos && getFix().bValid)
     {
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_posEstimateA, Eigen::Vector2d(0.1, 0.1), 0, BLUE, SDL_ALPHA_OPAQUE);
-        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_posEstimateB, Eigen::Vector2d(0.1, 0.1), 0, BLUE, SDL_ALPHA_OPAQUE);
-    }    
+        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_Fix.pos, Eigen::Vector2d(0.1, 0.1), 0, BLUE, SDL_ALPHA_OPAQUE);
+        if (m_Fix.bAmbiguous)
+        {
+            ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, m_Fix.mirrorPos, Eigen::Vector2d(0.1, 0.1), 0, BLUE, SDL_ALPHA_OPAQUE);
+        }
+    }
 }
 
 inline void LandmarkContainer::simulateRange(Eigen::Vector2d realPosition, double sttdev)
 {
     // random number generator
     static std::random_device rd;
-    static std::mt19937 gen(rd()); 
+    static std::mt19937 gen(rd());
 
-    std::normal_distribution<double> gaussianDist(0, sttdev);
+    simulateRange(realPosition, sttdev, gen);
+}
 
-    rangeA = (realPosition - m_LandmarkPosA).norm();
-    rangeB = (realPosition - m_LandmarkPosB).norm();
+// Seeded version for repeatable simulations, each thread passes its own generator
+inline void LandmarkContainer::simulateRange(Eigen::Vector2d realPosition, double sttdev, std::mt19937& gen)
+{
+    std::normal_distribution<double> gaussianDist(0, sttdev);
 
-    rangeA += gaussianDist(gen);
-    rangeB += gaussianDist(gen);
+    Eigen::VectorXd ranges = m_Anchors.predictRanges(realPosition);
+    for (size_t i = 0; i < m_Anchors.size(); i++)
+    {
+        m_Anchors.range[i] = ranges(i) + gaussianDist(gen);
+    }
+    m_bFixDirty = true;
 }
 
-inline void LandmarkContainer::updateRange(double _rangeA, double _rangeB)
+inline void LandmarkContainer::updateRange(const Eigen::VectorXd& ranges)
 {
-    rangeA = _rangeA;
-    rangeB = _rangeB;
+    for (size_t i = 0; i < m_Anchors.size() && i < static_cast<size_t>(ranges.size()); i++)
+    {
+        m_Anchors.range[i] = ranges(i);
+    }
+    m_bFixDirty = true;
 }
 
-inline void LandmarkContainer::OnNewPacket(LandmarkPacket *packet)
+// Apply the anchor calibration to a new range, returns false if the range was rejected
+inline bool LandmarkContainer::OnNewPacket(LandmarkPacket *packet, double timestamp)
 {
-    if (packet->LandmarkID == 'A')
-    {   
-        // Calculate horizontal range if anchor is 75cm above the ground
-        float correctedRange = sqrtf(powf(packet->range * LANDMARK_A_CALIBRATION, 2) - powf(0.0f, 2));
-        if (correctedRange > 0 && correctedRange < 10)
-        {
-            rangeA = correctedRange;
-        }
+    int landmark = AnchorTable::indexFromId(packet->LandmarkID);
+    if (!m_Anchors.isValid(landmark))
+    {
+        return false;
     }
 
-    else if (packet->LandmarkID == 'B')
-    {   
-        // Calculate horizontal range if anchor is 75cm above the ground
-        float correctedRange = sqrtf(powf(packet->range * LANDMARK_B_CALIBRATION, 2) - powf(0.0f, 2));
-        if (correctedRange > 0 && correctedRange < 10)
-        {
-            rangeB = correctedRange;
-        }
+    double correctedRange = m_Anchors.correctRange(landmark, packet->range);
+    if (correctedRange > 0 && correctedRange < LANDMARK_MAX_RANGE)
+    {
+        m_Anchors.range[landmark] = correctedRange;
+        m_Anchors.timestamp[landmark] = timestamp;
+        m_bFixDirty = true;
+        return true;
     }
+    return false;
 }
-inline void LandmarkContainer::calculatePos(bool printDebug)
-{
-    double d = sqrt(pow((m_LandmarkPosB.x() - m_LandmarkPosA.x()), 2.0) + pow((m_LandmarkPosB.y() - m_LandmarkPosA.y()), 2.0));
-    double a = (pow(rangeA, 2.0) - pow(rangeB, 2.0) + pow(d, 2.0)) / (2.0 * d);
-    double h = sqrt(pow(rangeA, 2.0) - pow(a, 2.0));
 
-    double midPointX = m_LandmarkPosA.x() + a * (m_LandmarkPosB.x() - m_LandmarkPosA.x()) / d;
-    double midPointY = m_LandmarkPosA.y() + a * (m_LandmarkPosB.y() - m_LandmarkPosA.y()) / d;
-
-    double posXA = midPointX - h * (m_LandmarkPosB.y() - m_LandmarkPosA.y()) / d;
-    double posYA = midPointY + h * (m_LandmarkPosB.x() - m_LandmarkPosA.x()) / d;
-
-    double posXB = midPointX + h * (m_LandmarkPosB.y() - m_LandmarkPosA.y()) / d;
-    double posYB = midPointY - h * (m_LandmarkPosB.x() - m_LandmarkPosA.x()) / d;
-
-    if(printDebug)
+// Multilateration fix, only solved again when the ranges or anchors have changed
+inline const MultilaterationResult& LandmarkContainer::getFix()
+{
+    if (m_bFixDirty)
     {
-        printf("d: %f, a: %f, h: %f X: %f, Y:, %f\n", d, a, h, midPointX, midPointY);
+        m_Fix = m_Solver.solve(m_Anchors, m_Fix.pos);
+        m_bFixDirty = false;
     }
-
-    m_posEstimateA = {posXA, posYA};
-    m_posEstimateB = {posXB, posYB};
+    return m_Fix;
 }
 
-inline Eigen::Vector2d LandmarkContainer::getPosEstimate(bool printDebug)
+inline Eigen::Vector2d LandmarkContainer::getPosEstimate()
 {
-    calculatePos(printDebug);
-    return m_posEstimateA;
+    return getFix().pos;
 }
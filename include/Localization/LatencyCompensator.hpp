@@ -0,0 +1,82 @@
+#pragma once
+#include <Eigen/Dense>
+#include <algorithm>
+
+#include "Kinematics.hpp"
+#include "DiffDriveModel.hpp"
+#include "ConsistencyMonitor.hpp"
+
+#define LATENCY_HISTORY_SIZE 32
+#define LATENCY_WINDOW_SIZE 50
+#define LATENCY_DEFAULT_ACTUATION 0.02 // Firmware and motor driver delay before a command acts (s)
+#define LATENCY_MAX_PREDICTION 0.5 // s
+
+// Predicts the pose at the time a new command will take effect on the robot.
+// The pose of the last encoder packet is driven forwards with the measured velocity until the first
+// earlier command takes effect, then with each command in turn.
+class LatencyCompensator
+{
+public:
+    struct Command
+    {
+        double time = 0; // Host time the command was sent (s)
+        double omegaL = 0; // Wheel speeds (rad/s)
+        double omegaR = 0;
+    };
+
+    bool bEnabled = true;
+    double actuationDelay = LATENCY_DEFAULT_ACTUATION;
+    double maxPrediction = LATENCY_MAX_PREDICTION;
+
+    RollingStat outboundDelay = RollingStat(LATENCY_WINDOW_SIZE); // Host queue and transmission to the robot (s)
+    RollingStat inboundDelay = RollingStat(LATENCY_WINDOW_SIZE);  // Transmission and event queue from the robot (s)
+
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    void addCommand(double time, double omegaL, double omegaR)
+    {
+        m_History[m_Head] = {time, omegaL, omegaR};
+        m_Head = (m_Head + 1) % LATENCY_HISTORY_SIZE;
+        m_Count = std::min(m_Count + 1, static_cast<size_t>(LATENCY_HISTORY_SIZE));
+    }
+
+    // Delay between sending a command and the robot acting on it
+    double commandLatency() const { return outboundDelay.mean() + actuationDelay; }
+    double applyTime(double now) const { return now + commandLatency(); }
+
+    // pose and velocity [v, omega] are from the encoder packet at fromTime
+    Eigen::Vector3d predict(const Eigen::Vector3d& pose, const Eigen::Vector2d& velocity, double fromTime, double toTime) const
+    {
+        toTime = std::min(toTime, fromTime + maxPrediction);
+        if (toTime <= fromTime) return pose;
+
+        const double halfWidth = kinematics->trackWidth / 2.0;
+        double speedL = velocity.x() - velocity.y() * halfWidth;
+        double speedR = velocity.x() + velocity.y() * halfWidth;
+
+        Eigen::Vector3d predicted = pose;
+        double t = fromTime;
+        const double latency = commandLatency();
+
+        // History is oldest first from the tail of the ring
+        for (size_t i = 0; i < m_Count; i++)
+        {
+            const Command& command = m_History[(m_Head + LATENCY_HISTORY_SIZE - m_Count + i) % LATENCY_HISTORY_SIZE];
+            double effective = command.time + latency;
+            if (effective <= fromTime) continue;
+            if (effective >= toTime) break;
+
+            predicted = DiffDriveModel::motion(predicted, speedL * (effective - t), speedR * (effective - t), kinematics->trackWidth);
+            speedL = command.omegaL * kinematics->wheelRadiusL;
+            speedR = command.omegaR * kinematics->wheelRadiusR;
+            t = effective;
+        }
+
+        return DiffDriveModel::motion(predicted, speedL * (toTime - t), speedR * (toTime - t), kinematics->trackWidth);
+    }
+
+private:
+    Command m_History[LATENCY_HISTORY_SIZE];
+    size_t m_Head = 0;
+    size_t m_Count = 0;
+};
@@ -0,0 +1,155 @@
+#pragma once
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <Eigen/Dense>
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+#include "PacketLog.hpp"
+#include "LandmarkContainer.hpp"
+#include "OdomVelocityKalmanFilter.hpp"
+#include "RtsSmoother.hpp"
+
+#define REPLAY_MAX_GAP 1.0 // A longer gap between packets starts a new segment (s)
+#define REPLAY_MAX_ENCODER_STEP 100.0 // A larger encoder jump is the robot resetting its counters (rad)
+#define REPLAY_HEADING_STDDEV M_PI // Initial heading is unknown
+
+// Offline replay of packet logs through the EKF, shared by the headless tools
+struct LogFile
+{
+    std::string path;
+    std::vector<PacketLogRecord> records;
+    AnchorTable anchors;
+
+    bool load(const std::string& logPath)
+    {
+        path = logPath;
+        if (!PacketLogReader::load(path, records, anchors) || records.empty())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "REPLAY ERROR: Unable to read %s\n", path.c_str());
+            return false;
+        }
+        if (anchors.size() == 0)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "REPLAY ERROR: %s has no anchor records\n", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    double duration() const { return records.empty() ? 0.0 : records.back().timestamp - records.front().timestamp; }
+};
+
+// Records [begin, end) of one log that can be replayed independently
+struct LogSegment
+{
+    const LogFile* log = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Splits a log at gaps and at robot resets, where the encoder counters jump
+inline void splitSegments(const LogFile& log, std::vector<LogSegment>& segments)
+{
+    LogSegment segment = {&log, 0, 0};
+    double lastTime = -1;
+    float lastEncA = 0, lastEncB = 0;
+    bool bHaveEncoder = false;
+
+    for (size_t i = 0; i < log.records.size(); i++)
+    {
+        const PacketLogRecord& record = log.records[i];
+        bool bReset = (lastTime >= 0 && record.timestamp - lastTime > REPLAY_MAX_GAP);
+
+        EncoderDataPacket encoder;
+        if (record.recordID == ENCODER_PACKET_ID && record.as(encoder))
+        {
+            bReset |= bHaveEncoder && (fabs(encoder.encA - lastEncA) > REPLAY_MAX_ENCODER_STEP || fabs(encoder.encB - lastEncB) > REPLAY_MAX_ENCODER_STEP);
+            lastEncA = encoder.encA;
+            lastEncB = encoder.encB;
+            bHaveEncoder = true;
+        }
+
+        if (bReset)
+        {
+            segment.end = i;
+            segments.push_back(segment);
+            segment.begin = i;
+        }
+        lastTime = record.timestamp;
+    }
+
+    segment.end = log.records.size();
+    if (segment.end > segment.begin) segments.push_back(segment);
+}
+
+// Runs the filter the app uses over a segment, recording every step for smoothing or comparison.
+// The filter starts from the given pose, or the first multilateration fix with the heading unknown.
+// Steps only depend on the packets, so replays of a segment with different tunings line up step for step.
+// Residuals, if given, gets measured minus predicted range for every range after the start, taken before its update.
+inline void replaySegment(const LogSegment& segment, OdomVelocityKalmanFilter& filter, RtsSmoother<3>& steps,
+    const Eigen::Vector3d* start = nullptr, std::vector<double>* residuals = nullptr)
+{
+    LandmarkContainer landmarks;
+    landmarks.getAnchors() = segment.log->anchors;
+    filter.setAnchors(segment.log->anchors);
+
+    steps.clear();
+    steps.angleIndex = 2;
+
+    bool bInitialised = false;
+    for (size_t i = segment.begin; i < segment.end; i++)
+    {
+        const PacketLogRecord& record = segment.log->records[i];
+        EncoderDataPacket encoder;
+        LandmarkPacket landmark;
+
+        if (record.recordID == ENCODER_PACKET_ID && record.as(encoder))
+        {
+            // Packets before the filter starts only set the encoder reference
+            if (bInitialised)
+            {
+                filter.onEncoderPacket(encoder, record.timestamp);
+                steps.addPrediction(record.timestamp, filter.x, filter.P, filter.F);
+            }
+            else
+            {
+                filter.encoderA = encoder.encA;
+                filter.encoderB = encoder.encB;
+            }
+        }
+        else if (record.recordID == LANDMARK_PACKET_ID && record.as(landmark))
+        {
+            if (!landmarks.OnNewPacket(&landmark, record.timestamp)) continue;
+
+            if (!bInitialised)
+            {
+                const MultilaterationResult& fix = landmarks.getFix();
+                if (!start && !fix.bValid) continue;
+
+                filter.x = start ? *start : Eigen::Vector3d(fix.pos.x(), fix.pos.y(), 0);
+                filter.P.setIdentity();
+                if (!start)
+                {
+                    filter.P.topLeftCorner<2, 2>() = fix.covariance;
+                    filter.P(2, 2) = REPLAY_HEADING_STDDEV * REPLAY_HEADING_STDDEV;
+                }
+
+                steps.addPrediction(record.timestamp, filter.x, filter.P, Eigen::Matrix3d::Identity());
+                filter.lastPacketTime = record.timestamp; // The first predict runs from the start
+                bInitialised = true;
+            }
+
+            int index = AnchorTable::indexFromId(landmark.LandmarkID);
+            if (residuals && index >= 0)
+            {
+                residuals->push_back(landmarks.getLandmarkRange(index) - (filter.x.head<2>() - landmarks.getLandmarkPos(index)).norm());
+            }
+            if (filter.updateLandmark(index, landmarks.getLandmarkPos(index), landmarks.getLandmarkRange(index)))
+            {
+                steps.setPosterior(filter.x, filter.P);
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Eigen/Dense>
+#include "SplinePath.hpp"
+#include "VelocityProfile.hpp"
+#include "ConsistencyMonitor.hpp"
+#include "Kinematics.hpp"
+
+#define MPC_HORIZON 10 // Steps
+#define MPC_DT 0.05 // s per step, 0.5 s horizon
+#define MPC_DEFAULT_TICK_PERIOD 0.02 // s between solves, the 50 Hz control tick
+#define MPC_ITERATIONS 40 // Fixed, so the solve time does not depend on the state
+#define MPC_DEFAULT_POS_WEIGHT 50.0
+#define MPC_DEFAULT_HEADING_WEIGHT 1.0
+#define MPC_DEFAULT_INPUT_WEIGHT 0.5
+#define MPC_DEFAULT_MAX_WHEEL_SPEED 0.35 // m/s at the wheel rim
+#define MPC_STATS_WINDOW 250
+
+// Linear time varying MPC about a reference run along the spline at the planned speed.
+// The error dynamics of the unicycle are linearised about each reference pose and condensed into a QP over
+// the wheel speed deviations, with the wheel speed limits as box constraints. The QP is solved with a fixed
+// number of accelerated projected gradient (FISTA) iterations, warm started from the previous solution
+// shifted on by the tick period, all in fixed size matrices so each tick costs the same.
+class MpcController
+{
+public:
+    static constexpr int N = MPC_HORIZON;
+    static constexpr int NU = 2 * N;
+
+    typedef Eigen::Matrix<double, NU, 1> InputVector;
+    typedef Eigen::Matrix<double, NU, NU> HessianMatrix;
+
+    struct Reference
+    {
+        Eigen::Matrix<double, 3, N + 1> pose; // Headings unwrapped along the horizon
+        Eigen::Matrix<double, 2, N> wheel;    // Left and right wheel rim speeds (m/s)
+        Eigen::Matrix<double, 1, N> speed;
+    };
+
+    double posWeight = MPC_DEFAULT_POS_WEIGHT;
+    double headingWeight = MPC_DEFAULT_HEADING_WEIGHT;
+    double inputWeight = MPC_DEFAULT_INPUT_WEIGHT;
+    double maxWheelSpeed = MPC_DEFAULT_MAX_WHEEL_SPEED;
+    int iterations = MPC_ITERATIONS;
+    double tickPeriod = MPC_DEFAULT_TICK_PERIOD; // s, time the warm start is moved on by
+
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    // Per tick solve time (us)
+    RollingStat solveTime = RollingStat(MPC_STATS_WINDOW);
+    double maxSolveTime = 0;
+    double lastResidual = 0; // Norm of the projected gradient step at the last iteration
+
+public:
+    MpcController() { reset(); }
+
+    void reset() { m_Warm.setZero(); }
+    void resetStats() { maxSolveTime = 0; }
+
+    Reference reference(const SplinePath& spline, const VelocityProfile& profile, size_t progress) const;
+
+    // Wheel rim speeds (m/s) for the first step of the horizon
+    Eigen::Vector2d solve(const Eigen::Vector3d& state, const Reference& ref);
+
+private:
+    InputVector m_Warm;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <Eigen/Dense>
+#include "AnchorTable.hpp"
+
+#define MULTILAT_DEFAULT_RANGE_STDDEV 0.05
+#define MULTILAT_MAX_ITERATIONS 10
+
+struct MultilaterationResult
+{
+    Eigen::Vector2d pos = {0, 0};
+    Eigen::Vector2d mirrorPos = {0, 0}; // Second solution when only two anchors are in range
+    Eigen::Matrix2d covariance = Eigen::Matrix2d::Identity();
+    double gdop = 0;
+    double residualRms = 0;
+    int anchorsUsed = 0;
+    int iterations = 0;
+    bool bAmbiguous = false;
+    bool bValid = false;
+};
+
+// Levenberg-Marquardt position fix from the ranges in an anchor table
+class Multilateration
+{
+public:
+    double rangeStdDev = MULTILAT_DEFAULT_RANGE_STDDEV;
+    double maxRangeAge = 0.5; // Ranges older than this relative to the newest one are ignored (s)
+    double tolerance = 1e-6;
+    int maxIterations = MULTILAT_MAX_ITERATIONS;
+
+    // hint picks between the two solutions when only two anchors are in range
+    MultilaterationResult solve(const AnchorTable& anchors, const Eigen::Vector2d& hint = {0, 0}) const;
+
+private:
+    template <int N, int MaxN>
+    MultilaterationResult m_Solve(
+        const Eigen::Matrix<double, N, 2, Eigen::ColMajor, MaxN, 2>& anchorPos, 
+        const Eigen::Matrix<double, N, 1, Eigen::ColMajor, MaxN, 1>& ranges, 
+        const Eigen::Vector2d& hint) const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+
+#define OCC_DEFAULT_RESOLUTION 0.01 // m per cell
+#define OCC_DEFAULT_INFLATION 0.08 // m, obstacles grow by this so the planner can treat the robot as a point
+#define OCC_DEFAULT_BRUSH 0.05 // m
+
+// Cell rectangle, x0/y0 inclusive and x1/y1 exclusive
+struct GridRect
+{
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    void merge(const GridRect& other)
+    {
+        if (other.empty()) return;
+        if (empty()) { *this = other; return; }
+        x0 = std::min(x0, other.x0); y0 = std::min(y0, other.y0);
+        x1 = std::max(x1, other.x1); y1 = std::max(y1, other.y1);
+    }
+};
+
+// Occupancy map over the work area, one bit per cell.
+// Rows are packed into 64 bit words. A second layer holds the obstacles grown by the inflation radius,
+// which is what the planner reads. Edits only recompute the inflated layer and the texture around them.
+class OccupancyGrid : public ViewPortRenderable
+{
+public:
+    Eigen::Vector2d origin; // World position of the corner of cell (0, 0)
+    double resolution;
+    int width = 0;
+    int height = 0;
+
+    double inflation = OCC_DEFAULT_INFLATION;
+    double brushRadius = OCC_DEFAULT_BRUSH;
+    bool bRender = true;
+    bool bEditing = false;
+
+public:
+    OccupancyGrid(const Eigen::Vector2d& center, const Eigen::Vector2d& size, double resolution = OCC_DEFAULT_RESOLUTION);
+    ~OccupancyGrid();
+
+    void resize(const Eigen::Vector2d& center, const Eigen::Vector2d& size, double resolution);
+    void clear();
+
+    // Recomputes the inflated layer everywhere, after the inflation radius changes
+    void reinflate();
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+    bool isOccupied(int x, int y) const { return inBounds(x, y) && m_Get(m_Occupied, x, y); }
+    // Inflated, cells off the map count as blocked
+    bool isBlocked(int x, int y) const { return !inBounds(x, y) || m_Get(m_Blocked, x, y); }
+
+    Eigen::Vector2i cellAt(const Eigen::Vector2d& pos) const;
+    Eigen::Vector2d cellCenter(int x, int y) const;
+
+    // Marks or clears a disc, returns the cells whose blocked state may have changed
+    GridRect paint(const Eigen::Vector2d& pos, double radius, bool bOccupied);
+
+    void render() override;
+
+private:
+    int m_Stride = 0; // Words per row
+    std::vector<uint64_t> m_Occupied;
+    std::vector<uint64_t> m_Blocked;
+    std::vector<Eigen::Vector2i> m_InflationDisc; // Offsets within the inflation radius
+
+    SDL_Texture* m_Texture = nullptr;
+    GridRect m_DirtyRect;
+    std::vector<uint32_t> m_Pixels;
+
+    bool m_Get(const std::vector<uint64_t>& bits, int x, int y) const
+    {
+        return (bits[static_cast<size_t>(y) * m_Stride + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void m_Set(std::vector<uint64_t>& bits, int x, int y, bool value)
+    {
+        uint64_t& word = bits[static_cast<size_t>(y) * m_Stride + (x >> 6)];
+        uint64_t mask = uint64_t(1) << (x & 63);
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+    GridRect m_Clip(GridRect rect) const;
+    void m_UpdateBlocked(const GridRect& rect);
+    void m_UpdateTexture();
+};
@@ -1,6 +1,12 @@
 #pragma once
 #include <Eigen/Dense>
 #include "ViewPortRenderable.hpp"
+#include "AnchorTable.hpp"
+#include "Kinematics.hpp"
+#include "ConsistencyMonitor.hpp"
+
+#define KF_DEFAULT_GATE 9.0 // NIS threshold for a 1 DOF range (3 sigma)
+#define KF_DEFAULT_MAX_REJECTS 10 // Consecutive rejections before an anchor is trusted again
 
 class OdomKalmanFilter : public ViewPortRenderable
 {
@@ -8,28 +14,41 @@ public:
     Eigen::Vector3d x;  // State vector: [x, y, theta]
     Eigen::Matrix3d P;  // State covariance matrix
     Eigen::Matrix3d F;  // State transition matrix 
-    Eigen::Matrix<double, 2, 3> H; // Measurement matrix (linearized)
+    Eigen::Matrix<double, Eigen::Dynamic, 3> H; // Measurement matrix (linearized)
     Eigen::Matrix3d Q; // Process noise covariance matrix
-    Eigen::Matrix2d R; // Measurement noise covariance matrix
-    Eigen::Matrix<double, 3, 2> K; // Kalman gain matrix
+    Eigen::MatrixXd R; // Measurement noise covariance matrix
+    Eigen::Matrix<double, 3, Eigen::Dynamic> K; // Kalman gain matrix, one column per anchor
     
-    Eigen::Vector2d anchorA;
-    Eigen::Vector2d anchorB;
+    AnchorTable anchors;
 
     double processNoise;
     double measurementNoise;
 
+    bool bGating = true;
+    double gateThreshold = KF_DEFAULT_GATE;
+    int maxConsecutiveRejects = KF_DEFAULT_MAX_REJECTS;
+    ConsistencyMonitor consistency;
+
     float encoderA = 0;
     float encoderB = 0;
 
-    Eigen::Vector2d h(const Eigen::Vector3d& state);
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    Eigen::VectorXd h(const Eigen::Vector3d& state);
 
 public:
     OdomKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise);
-    void setAnchors(const Eigen::Vector2d& anchorA, const Eigen::Vector2d& anchorB);
+    void setAnchors(const AnchorTable& anchors);
     void predict(const Eigen::Vector2d &U, double dt);
-    void batchUpdate(const Eigen::Vector2d& measurement, double dt);
-    void updateLandmark(char landmark, Eigen::Vector2d landmarkPos, double measurement);
+    void batchUpdate(const Eigen::VectorXd& measurement, double dt);
+    bool updateLandmark(int landmark, Eigen::Vector2d landmarkPos, double measurement);
+    bool updateLandmark(int landmark, Eigen::Vector2d landmarkPos, double measurement, double variance);
+    // Direct measurement of the whole pose, given as its innovation (measured minus filter pose)
+    void updatePose(const Eigen::Vector3d& innovation, const Eigen::Matrix3d& covariance);
     void setPoseEstimate(Eigen::Vector3d initialState);
     void render() override;
+
+protected:
+    // Pose the robot sprite is drawn at
+    virtual Eigen::Vector3d m_RenderPose() { return x; }
 };
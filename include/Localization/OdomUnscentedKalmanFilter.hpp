@@ -0,0 +1,53 @@
+#pragma once
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "AnchorTable.hpp"
+#include "Kinematics.hpp"
+
+#define UKF_STATE_DIM 3
+#define UKF_SIGMA_POINTS (2 * UKF_STATE_DIM + 1)
+
+// Unscented variant of OdomKalmanFilter, same interface and models without the hand linearisation
+class OdomUnscentedKalmanFilter : public ViewPortRenderable
+{
+public:
+    typedef Eigen::Matrix<double, UKF_STATE_DIM, UKF_SIGMA_POINTS> SigmaPoints;
+    typedef Eigen::Matrix<double, 1, UKF_SIGMA_POINTS> SigmaWeights;
+
+    Eigen::Vector3d x;  // State vector: [x, y, theta]
+    Eigen::Matrix3d P;  // State covariance matrix
+    Eigen::Matrix3d Q; // Process noise covariance matrix
+    Eigen::Matrix<double, 3, Eigen::Dynamic> K; // Kalman gain matrix, one column per anchor
+
+    AnchorTable anchors;
+
+    double processNoise;
+    double measurementNoise;
+
+    // Scaled unscented transform parameters
+    double alpha = 1.0;
+    double beta = 2.0;
+    double kappa = 0.0;
+
+    float encoderA = 0;
+    float encoderB = 0;
+
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+public:
+    OdomUnscentedKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise);
+    void setAnchors(const AnchorTable& anchors);
+    void predict(const Eigen::Vector2d &U, double dt);
+    void updateLandmark(int landmark, Eigen::Vector2d landmarkPos, double measurement);
+    void setPoseEstimate(Eigen::Vector3d initialState);
+    void render() override;
+
+private:
+    SigmaPoints m_Sigma;
+    SigmaWeights m_Wm; // Mean weights
+    SigmaWeights m_Wc; // Covariance weights
+    double m_Gamma;
+
+    void m_CalcWeights();
+    void m_GenerateSigmaPoints();
+};
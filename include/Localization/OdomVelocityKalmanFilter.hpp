@@ -0,0 +1,42 @@
+#pragma once
+#include <Eigen/Dense>
+#include "OdomKalmanFilter.hpp"
+#include "SerialInterface.hpp"
+
+#define VKF_DEFAULT_ACCEL_NOISE 0.5 // Linear acceleration std (m/s^2)
+#define VKF_DEFAULT_ALPHA_NOISE 2.0 // Angular acceleration std (rad/s^2)
+#define VKF_DEFAULT_WHEEL_VEL_NOISE 0.5 // Reported wheel speed std (rad/s)
+#define VKF_MAX_EXTRAPOLATION 0.25 // Longest constant velocity prediction past the last packet (s)
+
+// OdomKalmanFilter with the body velocity [v, omega] added to the state.
+// The reported wheel speeds are fused as measurements of the velocity, which is then used
+// to predict the pose forwards from the last encoder packet to the current time.
+class OdomVelocityKalmanFilter : public OdomKalmanFilter
+{
+public:
+    Eigen::Vector2d velocity = Eigen::Vector2d::Zero(); // [v, omega]
+    Eigen::Matrix2d velocityP = Eigen::Matrix2d::Identity(); // Velocity covariance, independent of the pose
+
+    double accelNoise = VKF_DEFAULT_ACCEL_NOISE;
+    double alphaNoise = VKF_DEFAULT_ALPHA_NOISE;
+    double wheelVelNoise = VKF_DEFAULT_WHEEL_VEL_NOISE;
+    double maxExtrapolation = VKF_MAX_EXTRAPOLATION;
+
+    bool bExtrapolate = true;
+    double lastPacketTime = -1; // s, same clock as the timestamps passed in
+
+public:
+    OdomVelocityKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise);
+
+    // Odometry predict from the encoder counts, then fuse the wheel speeds
+    void onEncoderPacket(const EncoderDataPacket& packet, double timestamp);
+    void updateWheelVelocities(double velA, double velB, double dt);
+
+    // Pose predicted forwards at constant velocity to the given time
+    Eigen::Vector3d extrapolate(double now) const;
+    // Pose to use for control and display, the extrapolated pose unless disabled
+    Eigen::Vector3d currentPose(double now) const { return bExtrapolate ? extrapolate(now) : x; }
+
+protected:
+    Eigen::Vector3d m_RenderPose() override;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+#include "Kinematics.hpp"
+#include "AnchorTable.hpp"
+#include "ConsistencyMonitor.hpp"
+
+#define ODOM_CAL_STATE_DIM 6
+#define ODOM_CAL_DEFAULT_R 0.0025 // Corrected range variance (m^2)
+#define ODOM_CAL_ENCODER_STDDEV 0.02 // Relative wheel slip per step
+#define ODOM_CAL_PRIOR_STDDEV 0.1 // Relative to the starting parameters
+#define ODOM_CAL_PARAM_DRIFT 1e-12 // Random walk on the parameters so they keep tracking (m^2 per step)
+#define ODOM_CAL_GATE 16.0
+#define ODOM_CAL_MIN_UPDATES 500
+#define ODOM_CAL_CONVERGED_STDDEV 0.01 // Relative
+
+// EKF over the robot pose and the wheel geometry, state [x, y, theta, wheel radius A, wheel radius B, track width].
+// Ranges correct the pose, and through the motion Jacobian the parameters that moved it.
+class OdometryCalibrator
+{
+public:
+    typedef Eigen::Matrix<double, ODOM_CAL_STATE_DIM, 1> State;
+    typedef Eigen::Matrix<double, ODOM_CAL_STATE_DIM, ODOM_CAL_STATE_DIM> Covariance;
+
+    State x;
+    Covariance P;
+
+    bool bEnabled = false;
+    double measurementNoise = ODOM_CAL_DEFAULT_R;
+    double encoderStdDev = ODOM_CAL_ENCODER_STDDEV;
+    double gateThreshold = ODOM_CAL_GATE;
+
+    size_t acceptedCount = 0;
+    size_t rejectedCount = 0;
+    RollingStat nis;
+
+    float encoderA = 0;
+    float encoderB = 0;
+
+    OdometryCalibrator(const KinematicParams& params = KinematicParams()) { reset({0, 0, 0}, Eigen::Matrix3d::Identity(), params); }
+
+    void reset(const Eigen::Vector3d& pose, const Eigen::Matrix3d& poseCovariance, const KinematicParams& params)
+    {
+        x << pose, params.wheelRadiusL, params.wheelRadiusR, params.trackWidth;
+        P.setZero();
+        P.topLeftCorner<3, 3>() = poseCovariance;
+        P.bottomRightCorner<3, 3>().diagonal() = (x.tail<3>() * ODOM_CAL_PRIOR_STDDEV).array().square().matrix();
+
+        acceptedCount = 0;
+        rejectedCount = 0;
+        nis.reset();
+    }
+
+    void predict(const Eigen::Vector2d& U)
+    {
+        double dEncL = U[0] - encoderA;
+        double dEncR = U[1] - encoderB;
+        encoderA = static_cast<float>(U[0]);
+        encoderB = static_cast<float>(U[1]);
+
+        const double rL = x(3), rR = x(4), width = x(5);
+        double dL = dEncL * rL;
+        double dR = dEncR * rR;
+        double d = (dL + dR) / 2.0;
+        double dTheta = (dR - dL) / width;
+        double heading = x(2) + dTheta / 2.0;
+        double c = cos(heading), s = sin(heading);
+
+        // Pose change wrt d and dTheta
+        Eigen::Matrix<double, 3, 2> G;
+        G << c, -0.5 * d * s,
+             s,  0.5 * d * c,
+             0,  1;
+
+        // d and dTheta wrt the parameters, and wrt the wheel distances
+        Eigen::Matrix<double, 2, 3> dParams;
+        dParams << 0.5 * dEncL, 0.5 * dEncR, 0,
+                   -dEncL / width, dEncR / width, -dTheta / width;
+        Eigen::Matrix2d dWheels;
+        dWheels << 0.5, 0.5,
+                   -1.0 / width, 1.0 / width;
+
+        Covariance F = Covariance::Identity();
+        F(0, 2) = -d * s;
+        F(1, 2) = d * c;
+        F.topRightCorner<3, 3>() = G * dParams;
+
+        x(0) += d * c;
+        x(1) += d * s;
+        x(2) += dTheta;
+
+        // Wheel slip in proportion to the distance each wheel travelled
+        Eigen::Matrix2d slip = Eigen::Vector2d(dL * encoderStdDev, dR * encoderStdDev).array().square().matrix().asDiagonal();
+        Eigen::Matrix<double, 3, 2> GW = G * dWheels;
+
+        P = F * P * F.transpose();
+        P.topLeftCorner<3, 3>() += GW * slip * GW.transpose();
+        P.bottomRightCorner<3, 3>().diagonal().array() += ODOM_CAL_PARAM_DRIFT;
+    }
+
+    // Range to an anchor at a known position, already corrected with the anchor calibration
+    bool updateRange(const Eigen::Vector2d& anchorPos, double range)
+    {
+        Eigen::Vector2d delta = x.head<2>() - anchorPos;
+        double predicted = std::max(delta.norm(), ANCHOR_MIN_RANGE);
+
+        Eigen::Vector2d H = delta / predicted;
+        State PHt = P.leftCols<2>() * H;
+        double S = H.dot(PHt.head<2>()) + measurementNoise;
+        double innovation = range - predicted;
+        double nisValue = innovation * innovation / S;
+
+        if (nisValue > gateThreshold)
+        {
+            rejectedCount++;
+            return false;
+        }
+
+        x += PHt * (innovation / S);
+        P -= PHt * PHt.transpose() / S;
+        nis.add(nisValue);
+        acceptedCount++;
+        return true;
+    }
+
+    KinematicParams estimate() const
+    {
+        KinematicParams params;
+        params.wheelRadiusL = x(3);
+        params.wheelRadiusR = x(4);
+        params.trackWidth = x(5);
+        return params;
+    }
+
+    // Standard deviation of [wheel radius A, wheel radius B, track width] relative to their values
+    Eigen::Vector3d relativeStdDev() const
+    {
+        return P.bottomRightCorner<3, 3>().diagonal().cwiseMax(0.0).cwiseSqrt().cwiseQuotient(x.tail<3>().cwiseAbs());
+    }
+
+    bool isConverged() const
+    {
+        return acceptedCount >= ODOM_CAL_MIN_UPDATES && relativeStdDev().maxCoeff() < ODOM_CAL_CONVERGED_STDDEV;
+    }
+};
@@ -1,19 +1,59 @@
 #pragma once
 #define _USE_MATH_DEFINES
-#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 #include <Eigen/Dense>
 #include <math.h>
 #include "Core/ViewPortRenderable.hpp"
-#include <fstream>
+#include "Localization/Kinematics.hpp"
+#include "Localization/WaypointIndex.hpp"
+#include "Localization/PathFile.hpp"
+#include "Localization/SplinePath.hpp"
+#include "Localization/VelocityProfile.hpp"
+#include "Localization/MpcController.hpp"
+#include "Localization/PathLod.hpp"
+
+#define WAYPOINT_HIT_RADIUS 0.1 // m
+#define WAYPOINT_MAX_MARKERS 2000 // More than this in view and only the lines are drawn
+
+#define PURSUIT_DEFAULT_LOOKAHEAD 0.2 // m
+#define PURSUIT_MAX_OMEGA 2.0 // rad/s
 
 // Class to handle placing waypoints and the selection of the path to follow
 class PathController : public ViewPortRenderable
 {
 private:
     int m_CurrentWaypointIndex = 0; 
+    int m_HoveredWaypoint = -1;
+    WaypointIndex m_Index;
+
+    // Rebuilt by update() on the main thread after an edit and swapped in, the control thread only reads them
+    SplinePath m_Spline;
+    VelocityProfile m_Profile;
+    bool m_bSplineDirty = true;
+    bool m_bProfileDirty = false;
+    size_t m_SplineProgress = 0;
+    Eigen::Vector2d m_LookaheadPoint = {0, 0};
+
+    // Drawing levels, only the main thread uses them so they are built without the lock
+    PathLod m_Lod;
+    bool m_bLodDirty = true;
+    int m_DraggedWaypoint = -1; // The only waypoint that moved since the levels were built, -1 if other edits did
+    bool m_bMovedThisFrame = false;
+    double m_FollowTolerance = 0;
 
 public:
-    std::deque<Eigen::Vector2d> waypoints; 
+    std::vector<Eigen::Vector2d> waypoints; 
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    double lookahead = PURSUIT_DEFAULT_LOOKAHEAD;
+    bool bShowLookahead = false;
+
+    // The control thread holds this for each tick, the main thread takes it to edit or read the path
+    std::mutex mutex;
+
+    MpcController mpc;
 
     Eigen::Vector2d getNextWaypoint()
     {
@@ -36,123 +76,181 @@ public:
     {
         if (index >= 0 && index < waypoints.size())
         {
+            m_Index.move(index, waypoints[index], newPos);
             waypoints[index] = newPos;
+
+            // Dragging one waypoint keeps the old levels until the drag ends
+            m_DraggedWaypoint = (!m_bLodDirty || m_DraggedWaypoint == index) ? index : -1;
+            m_bLodDirty = true;
+            m_bMovedThisFrame = true;
+
+            // A waypoint shapes the two segments either side of it
+            m_SplicePath(index - 2, 4, 4);
             SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Waypoint moved to: %.2f, %.2f\n", newPos.x(), newPos.y());
         }
     }
 
     void addWaypoint(const Eigen::Vector2d& waypoint)
     {
+        m_Index.insert(static_cast<int>(waypoints.size()), waypoint);
         waypoints.push_back(waypoint);
+        m_bSplineDirty = true;
+        m_bLodDirty = true;
+        m_DraggedWaypoint = -1;
         printf("Waypoint added at: %.2f, %.2f\n", waypoint.x(), waypoint.y());
     }
 
-    void removeWaypointNear(Eigen::Vector2d& position)
+    void clearWaypoints()
     {
-        for (auto it = waypoints.begin(); it != waypoints.end(); ++it)
-        {
-            if ((it->head(2) - position).norm() < 0.1) // Check if the waypoint is within 10cm
-            {
-                waypoints.erase(it);
-                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Waypoint removed at: %.2f, %.2f\n", position.x(), position.y());
-                break;
-            }
-        }
+        waypoints.clear();
+        m_Index.clear();
+        m_HoveredWaypoint = -1;
+        m_bSplineDirty = true;
+        m_bLodDirty = true;
+        m_DraggedWaypoint = -1;
     }
-    
-    bool isMouseOverWaypoint(Eigen::Vector2d waypoint)
+
+    // Replaces the whole path, e.g. from a file or the grid planner. Call without the mutex held, the index
+    // is built first and the lock only covers the swap, the old path is freed after it is released.
+    void setWaypoints(std::vector<Eigen::Vector2d> newWaypoints)
     {
-        Eigen::Vector2d mousePosWorld = ViewPort::GetInstance().GetCamera().transform.inverse() * ViewPort::GetInstance().GetViewPortMousePos();
-        return (waypoint.head(2) - mousePosWorld).norm() < 0.1; // Check if the mouse is over a waypoint
+        WaypointIndex index;
+        index.rebuild(newWaypoints);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(waypoints, newWaypoints);
+        std::swap(m_Index, index);
+        m_HoveredWaypoint = -1;
+        m_CurrentWaypointIndex = 0;
+        m_bSplineDirty = true;
+        m_bLodDirty = true;
+        m_DraggedWaypoint = -1;
     }
 
+    // Closest waypoint within radius, -1 if there is none
+    int waypointNear(const Eigen::Vector2d& position, double radius = WAYPOINT_HIT_RADIUS) const
+    {
+        return m_Index.nearest(waypoints, position, radius);
+    }
+
+    void removeWaypointNear(const Eigen::Vector2d& position)
+    {
+        int index = waypointNear(position);
+        if (index < 0) return;
+
+        m_Index.erase(index, waypoints[index]);
+        waypoints.erase(waypoints.begin() + index);
+        m_bLodDirty = true;
+        m_DraggedWaypoint = -1;
+        m_SplicePath(index - 2, 4, 3);
+        if (m_HoveredWaypoint == index) m_HoveredWaypoint = -1;
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Waypoint removed at: %.2f, %.2f\n", position.x(), position.y());
+    }
+
+    // Once per frame with the mouse already in world coordinates, render highlights the result
+    void setMousePos(const Eigen::Vector2d& mousePosWorld)
+    {
+        m_HoveredWaypoint = waypointNear(mousePosWorld);
+    }
+
+    int hoveredWaypoint() const { return m_HoveredWaypoint; }
+
+    // Main thread, the lock is only taken for the lookahead point the control thread writes
     void render() override
     {
+        Eigen::Vector2d lookaheadPoint;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lookaheadPoint = m_LookaheadPoint;
+        }
+
         ViewPort& viewport = ViewPort::GetInstance();
+        Camera2D& camera = viewport.GetCamera();
+
+        // Coarsest level that stays within LOD_PIXEL_TOLERANCE of the full path on screen
+        const std::vector<int>& level = getLod().level(LOD_PIXEL_TOLERANCE / std::max(camera.getScale(), 1));
 
-        //Draw lines between waypoints
-        if (waypoints.size() > 1)
+        // World box of the viewport, grown by a marker so ones on the edge still draw
+        Eigen::AlignedBox2d view = camera.getVisibleBox(0.05);
+
+        // Draw lines between waypoints, closing the loop
+        if (level.size() > 1)
         {
-            for (size_t i = 0; i < waypoints.size() - 1; ++i)
+            for (size_t k = 0; k < level.size(); k++)
             {
-                viewport.RenderLineTexture(waypoints[i], waypoints[i + 1], 0.025, YELLOW, 100); // Render the line between waypoints
+                const Eigen::Vector2d& a = waypoints[level[k]];
+                const Eigen::Vector2d& b = waypoints[level[(k + 1) % level.size()]];
+                if (!view.intersects(Eigen::AlignedBox2d(a.cwiseMin(b), a.cwiseMax(b)))) continue;
+                viewport.RenderLineTexture(a, b, 0.025, YELLOW, 100);
             }
-
-            // Draw line between last a first waypoint
-            viewport.RenderLineTexture(waypoints.back(), waypoints.front(), 0.025, YELLOW, 100); // Render the line between last and first waypoint
         }
 
-        // Render the waypoints as circles
-        for (const auto& waypoint : waypoints)
+        // A dragged waypoint may not be in the old levels, its own segments are drawn on top
+        if (m_DraggedWaypoint >= 0 && waypoints.size() > 1)
         {
-            // Render each waypoint as a circle
-            if (isMouseOverWaypoint(waypoint))
+            size_t n = waypoints.size(), i = static_cast<size_t>(m_DraggedWaypoint);
+            viewport.RenderLineTexture(waypoints[(i + n - 1) % n], waypoints[i], 0.025, YELLOW, 100);
+            viewport.RenderLineTexture(waypoints[i], waypoints[(i + 1) % n], 0.025, YELLOW, 100);
+            if (m_DraggedWaypoint != m_HoveredWaypoint)
             {
-                viewport.RenderTexture(viewport.circleTexture, waypoint, {0.05, 0.05}, 0, WHITE, 255);
+                viewport.RenderTexture(viewport.circleTexture, waypoints[i], {0.05, 0.05}, 0, YELLOW, 255);
             }
-            else
+        }
+
+        // Render the waypoints kept at this level as circles, unless they would cover the lines
+        size_t markers = std::count_if(level.begin(), level.end(), [&](int i) { return view.contains(waypoints[i]); });
+        for (int i : level)
+        {
+            if (markers > WAYPOINT_MAX_MARKERS) break;
+            if (i != m_HoveredWaypoint && view.contains(waypoints[i]))
             {
-                viewport.RenderTexture(viewport.circleTexture, waypoint, {0.05, 0.05}, 0, YELLOW, 255);
-            }    
+                viewport.RenderTexture(viewport.circleTexture, waypoints[i], {0.05, 0.05}, 0, YELLOW, 255);
+            }
+        }
+
+        if (m_HoveredWaypoint >= 0 && m_HoveredWaypoint < waypoints.size())
+        {
+            viewport.RenderTexture(viewport.circleTexture, waypoints[m_HoveredWaypoint], {0.05, 0.05}, 0, WHITE, 255);
+        }
+
+        if (bShowLookahead && !m_Spline.empty())
+        {
+            viewport.RenderTexture(viewport.circleTexture, lookaheadPoint, {0.03, 0.03}, 0, GREEN, 255);
         }
     }
 
     void savePath(const std::string& pathName)
     {
-        // Save to binary file
-        std::ofstream file(pathName, std::ios::binary);
-        if (file.is_open())
+        if (PathFile::save(pathName, waypoints))
         {
-            size_t waypointCount = waypoints.size();
-            file.write(reinterpret_cast<const char*>(&waypointCount), sizeof(waypointCount)); // Write the number of waypoints
-
-            for (const auto& waypoint : waypoints)
-            {
-                file.write(reinterpret_cast<const char*>(&waypoint[0]), sizeof(double)); 
-                file.write(reinterpret_cast<const char*>(&waypoint[1]), sizeof(double)); 
-            }
-
-            file.close();
             SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Path saved to %s\n", pathName.c_str());
         }
         else
         {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL ERROR: Unable to open file %s for writing\n", pathName.c_str());
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL ERROR: Unable to save path to %s\n", pathName.c_str());
         }
     }
 
+    // Without the mutex held, see setWaypoints
     void loadPath(const std::string& pathName)
     {
-        // Load waypoints from file
-        std::ifstream file(pathName, std::ios::binary);
-        if (file.is_open())
+        // Load into a scratch vector so a bad file leaves the current path alone
+        std::vector<Eigen::Vector2d> loaded;
+        if (PathFile::load(pathName, loaded))
         {
-            waypoints.clear(); // Clear existing waypoints
-            size_t waypointCount;
-            file.read(reinterpret_cast<char*>(&waypointCount), sizeof(waypointCount)); // Read number of waypoints
-
-            for (size_t i = 0; i < waypointCount; ++i)
-            {
-                Eigen::Vector2d waypoint;
-                file.read(reinterpret_cast<char*>(&waypoint[0]), sizeof(double)); 
-                file.read(reinterpret_cast<char*>(&waypoint[1]), sizeof(double)); 
-                waypoints.push_back(waypoint);
-            }
-
-            file.close();
-            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Path loaded from %s\n", pathName.c_str());
+            setWaypoints(std::move(loaded));
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL INFO: Loaded %zu waypoints from %s\n", waypoints.size(), pathName.c_str());
         }
         else
         {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL ERROR: Unable to open file %s for reading\n", pathName.c_str());
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHCONTROL ERROR: Unable to load path from %s\n", pathName.c_str());
         }
     }
 
 
     Eigen::Vector2d wheelVelFromGoal(const Eigen::Vector3d& currentState, const Eigen::Vector2d& targetPos) 
     {
-        const double width = 0.173; // Wheel width in meters
-        const double wheelRadius = 0.03; // Wheel radius in meters
+        const double width = kinematics->trackWidth;
 
         double targetTheta = atan2(targetPos.y() - currentState.y(), targetPos.x() - currentState.x()); // Calculate the angle to the target position
         double error = targetTheta - currentState.z(); // Calculate the error in angle
@@ -167,11 +265,147 @@ public:
         double vL = vForwards - (width / 2.0) * omega;
         double vR = vForwards + (width / 2.0) * omega;
 
-        double omegaL = vL / wheelRadius; // Calculate the angular velocity for the left wheel
-        double omegaR = vR / wheelRadius; 
+        double omegaL = vL / kinematics->wheelRadiusL; // Calculate the angular velocity for the left wheel
+        double omegaR = vR / kinematics->wheelRadiusR; 
 
         return {omegaL, omegaR}; 
     }
-};
 
+    // Main thread, once per frame without the mutex held. The main thread is the only one that edits the
+    // path, so it can read it unlocked while the new spline and speeds are built on the side, and the lock
+    // is only taken to swap them in. Until then the control thread keeps following the previous ones.
+    void update()
+    {
+        // The levels are rebuilt once a drag ends rather than on every frame of it
+        if (m_bLodDirty && !m_bMovedThisFrame) m_RebuildLod();
+        m_bMovedThisFrame = false;
+
+        // A simplified path waits for the levels too
+        if (m_bSplineDirty && !(m_FollowTolerance > 0 && m_DraggedWaypoint >= 0))
+        {
+            SplinePath spline;
+            if (m_FollowTolerance > 0) spline.build(getLod().simplify(waypoints, m_FollowTolerance));
+            else spline.build(waypoints);
+
+            VelocityProfile profile;
+            profile.copyLimits(m_Profile);
+            profile.build(spline);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(m_Spline, spline);
+            std::swap(m_Profile, profile);
+            m_SplineProgress = m_Spline.closestSample(m_LookaheadPoint);
+            m_bSplineDirty = false;
+            m_bProfileDirty = false;
+        }
+        else if (m_bProfileDirty)
+        {
+            VelocityProfile profile;
+            profile.copyLimits(m_Profile);
+            profile.build(m_Spline);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(m_Profile, profile);
+            m_bProfileDirty = false;
+        }
+    }
+
+    const SplinePath& getSpline() const { return m_Spline; }
+
+    VelocityProfile& getProfile() { return m_Profile; }
+
+    // Main thread. Rebuilt on first use after an edit, except that while one waypoint is dragged the old
+    // levels are kept, they still index the same waypoints
+    const PathLod& getLod()
+    {
+        if (m_bLodDirty && m_DraggedWaypoint < 0) m_RebuildLod();
+        return m_Lod;
+    }
+
+    // The followers use the path simplified to this (m), 0 follows every waypoint
+    double followTolerance() const { return m_FollowTolerance; }
+    void setFollowTolerance(double tolerance)
+    {
+        m_FollowTolerance = std::max(tolerance, 0.0);
+        m_bSplineDirty = true;
+    }
+
+    // Full replan after the limits change, done by the next update()
+    void replanSpeeds()
+    {
+        m_bProfileDirty = true;
+    }
+
+    // Pure pursuit on the spline through the waypoints, the goal is the point lookahead metres
+    // along the path from the closest point to the robot
+    Eigen::Vector2d wheelVelPurePursuit(const Eigen::Vector3d& currentState)
+    {
+        const SplinePath& spline = getSpline();
+        if (spline.empty()) return {0, 0};
+
+        m_SplineProgress = spline.closestSample(currentState.head<2>(), m_SplineProgress);
+        m_LookaheadPoint = spline.pointAt(spline.distance[m_SplineProgress] + lookahead);
+
+        // Goal in the robot frame, the arc through it has curvature 2y / L^2
+        Eigen::Vector2d delta = m_LookaheadPoint - currentState.head<2>();
+        double c = cos(currentState.z()), s = sin(currentState.z());
+        double xr = c * delta.x() + s * delta.y();
+        double yr = -s * delta.x() + c * delta.y();
+        double L2 = std::max(xr * xr + yr * yr, 1e-6);
+
+        double vForwards = m_Profile.speedAt(m_SplineProgress);
+        double omega = std::clamp(vForwards * 2.0 * yr / L2, -PURSUIT_MAX_OMEGA, PURSUIT_MAX_OMEGA);
 
+        const double width = kinematics->trackWidth;
+        double vL = vForwards - (width / 2.0) * omega;
+        double vR = vForwards + (width / 2.0) * omega;
+
+        return {vL / kinematics->wheelRadiusL, vR / kinematics->wheelRadiusR};
+    }
+
+    // MPC tracking of the spline at the planned speeds
+    Eigen::Vector2d wheelVelMpc(const Eigen::Vector3d& currentState)
+    {
+        const SplinePath& spline = getSpline();
+        if (spline.empty()) return {0, 0};
+
+        m_SplineProgress = spline.closestSample(currentState.head<2>(), m_SplineProgress);
+        Eigen::Vector2d wheelSpeeds = mpc.solve(currentState, mpc.reference(spline, m_Profile, m_SplineProgress));
+
+        return {wheelSpeeds[0] / kinematics->wheelRadiusL, wheelSpeeds[1] / kinematics->wheelRadiusR};
+    }
+
+private:
+    void m_RebuildLod()
+    {
+        m_Lod.build(waypoints);
+        m_bLodDirty = false;
+        m_DraggedWaypoint = -1;
+    }
+
+    // Updates the spline and speeds for an edit in the middle of the path, anything touching the ends of
+    // the loop or made while a full build is pending waits for update()
+    void m_SplicePath(int firstSegment, size_t oldSegments, size_t newSegments)
+    {
+        // Waypoint indices do not match the spline segments of a simplified path.
+        // A splice that wraps past the end of the loop, or onto a path too short to splice, would be a full
+        // build under the mutex.
+        size_t oldCount = waypoints.size() + oldSegments - newSegments;
+        if (m_bSplineDirty || m_bProfileDirty || firstSegment < 0 || m_FollowTolerance > 0 || m_Spline.empty() || waypoints.size() < 4 ||
+            firstSegment + oldSegments > oldCount || firstSegment + newSegments > waypoints.size())
+        {
+            m_bSplineDirty = true;
+            return;
+        }
+
+        size_t firstSample, oldSamples, newSamples;
+        if (m_Spline.splice(waypoints, static_cast<size_t>(firstSegment), oldSegments, newSegments, firstSample, oldSamples, newSamples))
+        {
+            m_Profile.splice(m_Spline, firstSample, oldSamples, newSamples);
+        }
+        else
+        {
+            m_Profile.build(m_Spline);
+        }
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#define PATHFILE_MAGIC 0x48545033 // "3PTH"
+#define PATHFILE_VERSION 1
+#define PATHFILE_BYTE_ORDER 0x0102 // Reads as 0x0201 when the file was written with the other byte order
+#define PATHFILE_CHECKSUM_SEED 0xCBF29CE484222325ull
+#define PATHFILE_STREAM_CHUNK 65536 // Points per read in the streaming loader
+
+// File layout: PathFileHeader, then count points of two little endian doubles (x, y).
+// The points are stored exactly as a std::vector<Eigen::Vector2d> holds them, so loading is a single copy.
+
+#pragma pack(push, 1)
+struct PathFileHeader
+{
+    uint32_t magic = PATHFILE_MAGIC;
+    uint16_t version = PATHFILE_VERSION;
+    uint16_t byteOrder = PATHFILE_BYTE_ORDER;
+    uint64_t count = 0;
+    uint64_t checksum = 0; // Of the point data
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Eigen::Vector2d) == 2 * sizeof(double), "Path points must be two packed doubles");
+
+class PathFile
+{
+public:
+    static bool save(const std::string& path, const std::vector<Eigen::Vector2d>& points);
+
+    // Maps the file and copies the points out in one pass, falls back to the streaming reader when the
+    // file can't be mapped. Files from before the header was added are still read.
+    static bool load(const std::string& path, std::vector<Eigen::Vector2d>& points);
+
+    // FNV-1a over 64 bit words, can be continued across chunks that are a multiple of 8 bytes
+    static uint64_t checksum(const void* data, size_t bytes, uint64_t hash = PATHFILE_CHECKSUM_SEED);
+
+    static bool checkHeader(const PathFileHeader& header, uint64_t fileSize, const std::string& path);
+};
+
+// Reads a path in fixed size chunks, for paths too large to hold twice in memory
+class PathFileReader
+{
+private:
+    std::ifstream m_File;
+    PathFileHeader m_Header;
+    uint64_t m_Read = 0;
+    uint64_t m_Checksum = PATHFILE_CHECKSUM_SEED;
+
+public:
+    bool open(const std::string& path);
+
+    uint64_t count() const { return m_Header.count; }
+    uint64_t remaining() const { return m_Header.count - m_Read; }
+
+    // Returns the number of points read, 0 at the end of the file or on a short read
+    size_t read(Eigen::Vector2d* points, size_t maxPoints);
+
+    // True once every point has been read and the checksum matches
+    bool verify() const { return m_Read == m_Header.count && m_Checksum == m_Header.checksum; }
+};
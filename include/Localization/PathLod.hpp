@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+
+#define LOD_BASE_TOLERANCE 0.0005 // m, tolerance of level 1, each level above doubles it
+#define LOD_MAX_LEVELS 16
+#define LOD_PIXEL_TOLERANCE 1.0 // px, screen error allowed when drawing a simplified level
+
+// Ramer-Douglas-Peucker levels of detail for a closed path, or an open one such as a recording.
+// One pass gives every point the tolerance below which RDP keeps it, clamped to the value of the point
+// that split its span, so keeping the points above any tolerance gives exactly the RDP result for it.
+// Levels at doubling tolerances are stored as index lists for drawing.
+class PathLod
+{
+public:
+    std::vector<double> importance; // Per point, infinite for the two anchors
+
+public:
+    void build(const std::vector<Eigen::Vector2d>& points, bool bClosed = true);
+    void clear();
+    bool empty() const { return m_Levels.empty(); }
+
+    size_t levelCount() const { return m_Levels.size(); }
+    double levelTolerance(size_t level) const { return m_Tolerance[level]; }
+
+    // Indices in path order of the coarsest level whose tolerance is within the one given
+    const std::vector<int>& level(double tolerance) const;
+
+    // The RDP simplification of the points the levels were built from
+    std::vector<Eigen::Vector2d> simplify(const std::vector<Eigen::Vector2d>& points, double tolerance) const;
+
+private:
+    std::vector<std::vector<int>> m_Levels; // Level 0 holds every point
+    std::vector<double> m_Tolerance;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+#include "ViewPortRenderable.hpp"
+#include "PathLod.hpp"
+
+#define RECORD_CAPACITY 200000 // Points kept, recording stops when the buffer is full
+#define RECORD_DEFAULT_SPACING 0.05 // m
+#define RECORD_DEFAULT_HEADING 0.2 // rad
+#define RECORD_MIN_SPACING 0.005 // m, turning on the spot doesn't add points
+#define RECORD_LOOP_GAP 0.25 // m, a route ending further than this from its start is warned about when used as a path
+
+// Teaches a route by driving it. The filter pose is offered on every encoder packet and a point is kept
+// once the robot has moved far enough or turned far enough from the last one kept, so straights are
+// sparse and corners dense. Points go into a buffer reserved up front, nothing allocates while recording.
+// PathController follows every path as a loop, so a route used as a path should end back where it started,
+// otherwise the robot drives straight from the end to the start.
+class PathRecorder : public ViewPortRenderable
+{
+public:
+    bool bRender = true;
+    double spacing = RECORD_DEFAULT_SPACING;
+    double headingThreshold = RECORD_DEFAULT_HEADING;
+
+    size_t samples = 0; // Poses offered since start
+
+public:
+    PathRecorder();
+
+    void start();
+    void stop();
+    void clear();
+    bool isRecording() const { return m_bRecording; }
+
+    // Call at the estimator rate with the filtered pose
+    void addPose(const Eigen::Vector3d& pose);
+
+    const std::vector<Eigen::Vector2d>& points() const { return m_Points; }
+    size_t capacity() const { return m_Points.capacity(); }
+
+    // Distance from the last point back to the first (m), the segment that closes the loop
+    double loopGap() const { return m_Points.size() > 1 ? (m_Points.back() - m_Points.front()).norm() : 0.0; }
+
+    void render() override;
+
+private:
+    bool m_bRecording = false;
+    std::vector<Eigen::Vector2d> m_Points;
+    Eigen::Vector3d m_LastKept = Eigen::Vector3d::Zero();
+    Eigen::Vector3d m_LastPose = Eigen::Vector3d::Zero();
+
+    // Levels of the finished recording for drawing, built once it stops
+    PathLod m_Lod;
+    size_t m_LodPoints = 0;
+
+    void m_Keep(const Eigen::Vector3d& pose);
+};
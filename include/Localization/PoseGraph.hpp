@@ -0,0 +1,115 @@
+#pragma once
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ViewPortRenderable.hpp"
+#include "Kinematics.hpp"
+
+#define PG_DEFAULT_WINDOW 200 // Nodes kept in the sliding window
+#define PG_NODE_DISTANCE 0.02 // Odometry distance that starts a new node (m)
+#define PG_NODE_ANGLE 0.05 // Odometry rotation that starts a new node (rad)
+#define PG_NODE_PERIOD 0.5 // Longest time between nodes when stationary (s)
+#define PG_ODOM_DIST_VAR 1e-4 // Odometry position variance per metre driven (m^2/m)
+#define PG_ODOM_ANGLE_VAR 1e-3 // Odometry heading variance per radian of wheel rotation difference (rad^2/rad)
+#define PG_ODOM_MIN_VAR 1e-8
+#define PG_MAX_ITERATIONS 5
+#define PG_SOLVE_PERIOD_MS 100
+#define PG_DEFAULT_CORRECTION_WEIGHT 0.5
+
+// Sliding window pose graph over odometry and range factors, optimised on a background thread.
+// Nodes are made from the wheel odometry between encoder packets, ranges attach to the newest node.
+// The window is a chain, so the information matrix is block tridiagonal plus unary range terms and the
+// sparse Cholesky factorisation scales linearly with the window size.
+// The newest node is fed back to the live filter as a pose measurement with its marginal covariance.
+// The graph re-uses ranges the filter has already fused, so the two are not independent and taking the
+// covariance at face value would make the filter overconfident. It is divided by correctionWeight first,
+// trading slower pull towards the graph for keeping the filter covariance honest.
+class PoseGraph : public ViewPortRenderable
+{
+public:
+    struct Node
+    {
+        uint64_t id = 0;
+        double time = 0;
+        Eigen::Vector3d pose;     // Current estimate
+        Eigen::Vector3d filtered; // Live filter pose when the node was made
+        Eigen::Matrix3d filteredP; // and its covariance, the prior if this becomes the oldest node
+        Eigen::Matrix3d priorInfo = Eigen::Matrix3d::Zero(); // Prior information, only used on the oldest node
+        Eigen::Vector3d odometry = Eigen::Vector3d::Zero(); // Motion from the previous node in its frame
+        Eigen::Matrix3d odometryInfo = Eigen::Matrix3d::Zero();
+    };
+
+    struct RangeFactor
+    {
+        uint64_t nodeId = 0;
+        Eigen::Vector2d anchor;
+        double range = 0;
+        double info = 0; // Inverse variance
+    };
+
+    size_t windowSize = PG_DEFAULT_WINDOW;
+    double correctionWeight = PG_DEFAULT_CORRECTION_WEIGHT; // (0, 1], scales the graph information
+
+    float encoderA = 0;
+    float encoderB = 0;
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    // Results of the last solve, written by the solver thread
+    std::atomic<double> lastSolveMs = 0;
+    std::atomic<double> lastCost = 0;
+    std::atomic<int> lastIterations = 0;
+
+public:
+    ~PoseGraph();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_Worker != nullptr; }
+    void clear();
+
+    // Main thread, after every encoder packet and accepted range
+    void addOdometry(double time, const Eigen::Vector2d& U, const Eigen::Vector3d& filteredPose, const Eigen::Matrix3d& filteredP);
+    void addRange(const Eigen::Vector2d& anchor, double range, double variance);
+
+    // Innovation (graph minus filter pose) and measurement covariance for the live filter from the newest solve, once per new node
+    bool popCorrection(Eigen::Vector3d& correction, Eigen::Matrix3d& covariance);
+
+    size_t nodeCount();
+    size_t rangeCount();
+
+    void render() override;
+
+private:
+    std::deque<Node> m_Nodes;
+    std::deque<RangeFactor> m_Ranges;
+    uint64_t m_NextId = 0;
+
+    // Odometry since the newest node
+    Eigen::Vector3d m_OdomAccum = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d m_OdomCov = Eigen::Matrix3d::Zero();
+    double m_OdomDistance = 0;
+
+    Eigen::Vector3d m_Correction = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d m_CorrectionCov = Eigen::Matrix3d::Identity();
+    uint64_t m_CorrectionId = 0;
+    uint64_t m_AppliedId = 0;
+    bool m_bNewCorrection = false;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::thread* m_Worker = nullptr;
+    std::atomic_bool m_RunThread = false;
+    bool m_bDirty = false;
+
+    void m_SolverTask();
+    void m_AddNode(double time, const Eigen::Vector3d& filteredPose, const Eigen::Matrix3d& filteredP);
+    // Gauss-Newton on a copy of the window, returns the final cost and the marginal covariance of the newest node
+    static double m_Optimise(std::vector<Node>& nodes, const std::vector<RangeFactor>& ranges, int& iterations, Eigen::Matrix3d& newestCov);
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ConsistencyMonitor.hpp"
+
+#define RQ_DEFAULT_FILE "RangeQuality.cfg"
+#define RQ_DEFAULT_VARIANCE 0.01
+#define RQ_DEFAULT_NLOS_POWER -100.0 // dBm
+#define RQ_DEFAULT_NLOS_BIAS 0.3 // m
+#define RQ_RESIDUAL_WINDOW 20
+#define RQ_MAX_CONSECUTIVE_NLOS 25
+#define RQ_LOG_CHI2_MEAN -1.2704 // E[log(x)] for x ~ chi-square with 1 DOF
+
+struct RangeQuality
+{
+    double variance = RQ_DEFAULT_VARIANCE;
+    bool bNlos = false;
+};
+
+// Maps received power and the recent range residuals of each anchor to a measurement variance and an NLOS flag.
+// log(variance) is modelled as linear in rxPower, weaker signals get noisier ranges.
+class RangeQualityModel
+{
+public:
+    struct AnchorState
+    {
+        RollingStat residuals = RollingStat(RQ_RESIDUAL_WINDOW);
+        RangeQuality last;
+        double lastPower = 0;
+        int consecutiveNlos = 0;
+        size_t nlosCount = 0;
+    };
+
+    bool bEnabled = false;
+    double logVarOffset = std::log(RQ_DEFAULT_VARIANCE);
+    double logVarSlope = 0; // per dBm
+    double minVariance = 1e-4;
+    double maxVariance = 1.0;
+    double nlosPower = RQ_DEFAULT_NLOS_POWER; // Weaker ranges are treated as NLOS
+    double nlosBias = RQ_DEFAULT_NLOS_BIAS;   // A larger mean residual over the window is treated as NLOS
+    int maxConsecutiveNlos = RQ_MAX_CONSECUTIVE_NLOS;
+
+    std::vector<AnchorState> anchors;
+
+    double variance(double rxPower) const
+    {
+        return std::min(std::max(std::exp(logVarOffset + logVarSlope * rxPower), minVariance), maxVariance);
+    }
+
+    // residual is the measured range minus the range predicted from the prior state
+    RangeQuality assess(int anchor, double rxPower, double residual)
+    {
+        if (anchor < 0) return RangeQuality();
+        if (anchor >= static_cast<int>(anchors.size())) anchors.resize(anchor + 1);
+        AnchorState& state = anchors[anchor];
+
+        // NLOS paths are longer than the direct path, so they show up as a positive residual bias
+        state.residuals.add(residual);
+        bool bBiased = state.residuals.count() >= state.residuals.windowSize() / 2 && state.residuals.mean() > nlosBias;
+
+        RangeQuality quality;
+        quality.variance = variance(rxPower);
+        quality.bNlos = rxPower < nlosPower || bBiased;
+
+        // Let a range through now and then so a drifting estimate cannot lock an anchor out
+        if (quality.bNlos && ++state.consecutiveNlos > maxConsecutiveNlos)
+        {
+            quality.bNlos = false;
+        }
+        if (!quality.bNlos) state.consecutiveNlos = 0;
+        if (quality.bNlos) state.nlosCount++;
+
+        state.last = quality;
+        state.lastPower = rxPower;
+        return quality;
+    }
+
+    // Least squares fit of log(residual^2) against rxPower, samples far outside the first fit are dropped before refitting
+    bool fit(const std::vector<double>& rxPower, const std::vector<double>& residuals)
+    {
+        if (rxPower.size() != residuals.size() || rxPower.size() < 10) return false;
+
+        std::vector<bool> bUse(rxPower.size(), true);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            Eigen::Matrix2d AtA = Eigen::Matrix2d::Zero();
+            Eigen::Vector2d Atb = Eigen::Vector2d::Zero();
+
+            for (size_t i = 0; i < rxPower.size(); i++)
+            {
+                if (!bUse[i]) continue;
+                Eigen::Vector2d a(1.0, rxPower[i]);
+                AtA += a * a.transpose();
+                Atb += a * std::log(std::max(residuals[i] * residuals[i], 1e-12));
+            }
+
+            if (std::abs(AtA.determinant()) < 1e-9) return false;
+            Eigen::Vector2d coeffs = AtA.ldlt().solve(Atb);
+
+            logVarOffset = coeffs(0) - RQ_LOG_CHI2_MEAN;
+            logVarSlope = coeffs(1);
+
+            for (size_t i = 0; i < rxPower.size(); i++)
+            {
+                bUse[i] = residuals[i] * residuals[i] < 9.0 * variance(rxPower[i]);
+            }
+        }
+
+        bEnabled = true;
+        return true;
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if (!file.is_open())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "RANGEQUALITY ERROR: Unable to open file %s for writing\n", path.c_str());
+            return false;
+        }
+
+        file << "enabled " << bEnabled << "\n";
+        file << "logVarOffset " << logVarOffset << "\n";
+        file << "logVarSlope " << logVarSlope << "\n";
+        file << "minVariance " << minVariance << "\n";
+        file << "maxVariance " << maxVariance << "\n";
+        file << "nlosPower " << nlosPower << "\n";
+        file << "nlosBias " << nlosBias << "\n";
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RANGEQUALITY INFO: Model saved to %s\n", path.c_str());
+        return true;
+    }
+
+    bool load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RANGEQUALITY INFO: No model at %s, using defaults\n", path.c_str());
+            return false;
+        }
+
+        std::string key;
+        double value;
+        while (file >> key >> value)
+        {
+            if (key == "enabled") bEnabled = value != 0;
+            else if (key == "logVarOffset") logVarOffset = value;
+            else if (key == "logVarSlope") logVarSlope = value;
+            else if (key == "minVariance") minVariance = value;
+            else if (key == "maxVariance") maxVariance = value;
+            else if (key == "nlosPower") nlosPower = value;
+            else if (key == "nlosBias") nlosBias = value;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RANGEQUALITY INFO: Model loaded from %s\n", path.c_str());
+        return true;
+    }
+};
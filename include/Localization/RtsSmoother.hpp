@@ -0,0 +1,90 @@
+#pragma once
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <Eigen/Dense>
+#include <deque>
+
+#define RTS_NO_ANGLE -1
+
+// Rauch-Tung-Striebel backward pass over the steps recorded from a forward EKF.
+// Each step holds the prior from the motion model, the Jacobian of that motion and the posterior
+// after any measurement updates. Smoothing a range of steps only needs the steps in it, so the same
+// core serves whole recordings and the trailing window of a fixed-lag smoother.
+template <int N>
+class RtsSmoother
+{
+public:
+    typedef Eigen::Matrix<double, N, 1> State;
+    typedef Eigen::Matrix<double, N, N> Covariance;
+
+    struct Step
+    {
+        double time = 0;
+        State xPred;      // Prior from the motion model
+        Covariance PPred;
+        Covariance F;     // Jacobian of the motion from the previous step
+        State x;          // Filtered posterior
+        Covariance P;
+        State xSmooth;    // Smoothed estimate, valid after smooth()
+        Covariance PSmooth;
+    };
+
+    int angleIndex = RTS_NO_ANGLE; // State element wrapped to [-pi, pi] when differenced
+    std::deque<Step> steps;
+
+public:
+    void clear() { steps.clear(); }
+    size_t size() const { return steps.size(); }
+
+    // Starts a new step, the posterior is the prior until a measurement updates it
+    void addPrediction(double time, const State& xPred, const Covariance& PPred, const Covariance& F)
+    {
+        Step step;
+        step.time = time;
+        step.xPred = xPred;
+        step.PPred = PPred;
+        step.F = F;
+        step.x = xPred;
+        step.P = PPred;
+        step.xSmooth = xPred;
+        step.PSmooth = PPred;
+        steps.push_back(step);
+    }
+
+    // Posterior of the newest step after a measurement update
+    void setPosterior(const State& x, const Covariance& P)
+    {
+        if (steps.empty()) return;
+        steps.back().x = x;
+        steps.back().P = P;
+        steps.back().xSmooth = x;
+        steps.back().PSmooth = P;
+    }
+
+    void smooth() { smooth(0, steps.size()); }
+
+    // Backward pass over [begin, end), the last step in the range keeps its filtered estimate
+    void smooth(size_t begin, size_t end)
+    {
+        if (end > steps.size() || end - begin < 2 || begin >= end) return;
+
+        Step& last = steps[end - 1];
+        last.xSmooth = last.x;
+        last.PSmooth = last.P;
+
+        for (size_t k = end - 1; k-- > begin;)
+        {
+            Step& step = steps[k];
+            const Step& next = steps[k + 1];
+
+            // C = P F^T PPred^-1, solved rather than inverted as PPred is symmetric
+            Covariance C = next.PPred.ldlt().solve(next.F * step.P).transpose();
+
+            State innovation = next.xSmooth - next.xPred;
+            if (angleIndex >= 0) innovation(angleIndex) = remainder(innovation(angleIndex), 2.0 * M_PI);
+
+            step.xSmooth = step.x + C * innovation;
+            step.PSmooth = step.P + C * (next.PSmooth - next.PPred) * C.transpose();
+        }
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer, many reader snapshot of a small trivially copyable struct.
+// The writer never waits, a reader retries if a write overlapped its copy. The value is kept in relaxed
+// atomic words so an overlapping copy is a retry rather than a data race.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    SeqLock() { store(T{}); }
+
+    // One thread only
+    void store(const T& value)
+    {
+        uint64_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+
+        uint32_t sequence = m_Sequence.load(std::memory_order_relaxed);
+        m_Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) m_Words[i].store(words[i], std::memory_order_relaxed);
+        m_Sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        uint64_t words[WORDS];
+        uint32_t before, after;
+        do
+        {
+            before = m_Sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) words[i] = m_Words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_Sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> m_Sequence{0}; // Odd while a write is in progress
+    std::array<std::atomic<uint64_t>, WORDS> m_Words{};
+};
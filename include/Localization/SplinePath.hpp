@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+
+#define SPLINE_SAMPLE_SPACING 0.01 // m, roughly, each segment gets at least one sample
+#define SPLINE_SEARCH_WINDOW 8 // Samples searched past the point where the distance starts growing
+#define SPLINE_LOST_DISTANCE 0.3 // m, beyond this the closest sample is searched for over the whole path
+
+// Closed Catmull-Rom spline through the waypoints with a precomputed arc length table.
+// Each segment is sampled evenly in its parameter with the count set by its chord length, the table holds
+// the cumulative length at every sample so a point a given distance along the path is a binary search
+// plus a linear interpolation.
+class SplinePath
+{
+public:
+    std::vector<Eigen::Vector2d> points; // Samples along the spline
+    std::vector<double> distance;        // Arc length from the first waypoint to each sample
+    std::vector<size_t> segmentStart;    // First sample of each segment, the last entry is the closing sample
+
+public:
+    void build(const std::vector<Eigen::Vector2d>& waypoints);
+    void clear();
+
+    // Replaces oldSegments segments from firstSegment with newSegments segments resampled from the new waypoints.
+    // Only the replaced segments are evaluated, the sample range that changed is returned for the velocity
+    // profile. Falls back to a full build and returns false when the splice would wrap around the path.
+    bool splice(const std::vector<Eigen::Vector2d>& waypoints, size_t firstSegment, size_t oldSegments, size_t newSegments,
+        size_t& firstSample, size_t& oldSamples, size_t& newSamples);
+
+    bool empty() const { return points.size() < 2; }
+    double length() const { return m_Length; }
+
+    // Point on segment i (from waypoint i to i + 1) at parameter t in [0, 1]
+    Eigen::Vector2d evaluate(size_t segment, double t) const;
+
+    // Point at arc length s, wrapped onto the loop, O(log n)
+    Eigen::Vector2d pointAt(double s) const;
+
+    // Sample at or before arc length s, wrapped onto the loop, O(log n)
+    size_t sampleAt(double s) const;
+
+    // Closest sample to pos, searched forwards from hint so following the path costs the same at any length.
+    // The search walks on while the distance shrinks, so its cost depends on how far the robot moved.
+    size_t closestSample(const Eigen::Vector2d& pos, size_t hint) const;
+    size_t closestSample(const Eigen::Vector2d& pos) const;
+
+private:
+    std::vector<Eigen::Vector2d> m_Waypoints;
+    std::vector<size_t> m_SegmentSamples;
+    double m_Length = 0;
+
+    size_t m_SampleSegment(size_t segment, std::vector<Eigen::Vector2d>& out) const;
+    void m_UpdateTables(size_t fromSample);
+};
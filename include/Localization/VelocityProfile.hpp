@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "SplinePath.hpp"
+#include "Kinematics.hpp"
+
+#define VP_DEFAULT_MAX_SPEED 0.3 // m/s
+#define VP_DEFAULT_MAX_ACCEL 0.25 // m/s^2
+#define VP_DEFAULT_MAX_DECEL 0.35 // m/s^2
+#define VP_DEFAULT_MAX_LATERAL_ACCEL 0.3 // m/s^2
+#define VP_DEFAULT_MAX_WHEEL_SPEED 0.35 // m/s at the wheel rim
+
+// Speed along the spline limited by curvature, wheel speed and acceleration.
+// The usual two pass plan: a per sample limit from the path shape, a forward pass capping acceleration
+// and a backward pass capping deceleration. The path is a loop so both passes wrap around it.
+// After an edit only the changed samples are recomputed and each pass stops as soon as it meets the
+// old profile again, so the work scales with the size of the edit rather than the path.
+class VelocityProfile
+{
+public:
+    double maxSpeed = VP_DEFAULT_MAX_SPEED;
+    double maxAccel = VP_DEFAULT_MAX_ACCEL;
+    double maxDecel = VP_DEFAULT_MAX_DECEL;
+    double maxLateralAccel = VP_DEFAULT_MAX_LATERAL_ACCEL;
+    double maxWheelSpeed = VP_DEFAULT_MAX_WHEEL_SPEED;
+    const KinematicParams* kinematics = &KinematicParams::GetShared();
+
+    std::vector<double> speedLimit; // From curvature and wheel speed only
+    std::vector<double> forward;    // After the acceleration pass
+    std::vector<double> speed;      // Final profile
+
+    size_t lastUpdateSamples = 0; // Samples visited by the last build or update
+
+public:
+    void build(const SplinePath& spline);
+
+    // Limits only, for a profile built on the side
+    void copyLimits(const VelocityProfile& other)
+    {
+        maxSpeed = other.maxSpeed;
+        maxAccel = other.maxAccel;
+        maxDecel = other.maxDecel;
+        maxLateralAccel = other.maxLateralAccel;
+        maxWheelSpeed = other.maxWheelSpeed;
+        kinematics = other.kinematics;
+    }
+
+    // After SplinePath::splice, with the sample range it returned
+    void splice(const SplinePath& spline, size_t firstSample, size_t oldSamples, size_t newSamples);
+
+    double speedAt(size_t sample) const { return sample < speed.size() ? speed[sample] : 0.0; }
+
+private:
+    double m_Limit(const SplinePath& spline, size_t i) const;
+    bool m_Forward(const SplinePath& spline, size_t i);
+    bool m_Backward(const SplinePath& spline, size_t i);
+};
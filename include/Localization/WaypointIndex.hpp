@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <math.h>
+#include <Eigen/Dense>
+
+#define WPI_DEFAULT_CELL_SIZE 0.1 // m, about the hit radius so a query touches at most 3x3 cells
+
+// Uniform grid over the waypoints for hit testing in the editor.
+// Cells hold indices into the path, queries only visit the cells overlapping the search circle so
+// hover and pick cost is independent of the path length.
+class WaypointIndex
+{
+public:
+    WaypointIndex(double cellSize = WPI_DEFAULT_CELL_SIZE) : m_CellSize(cellSize) {}
+
+    void clear() { m_Cells.clear(); }
+
+    template <typename Points>
+    void rebuild(const Points& points)
+    {
+        m_Cells.clear();
+        m_Cells.reserve(points.size() / 4 + 1);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            insert(static_cast<int>(i), points[i]);
+        }
+    }
+
+    void insert(int index, const Eigen::Vector2d& pos)
+    {
+        m_Cells[m_Key(pos)].push_back(index);
+    }
+
+    void move(int index, const Eigen::Vector2d& oldPos, const Eigen::Vector2d& newPos)
+    {
+        int64_t oldKey = m_Key(oldPos), newKey = m_Key(newPos);
+        if (oldKey == newKey) return;
+        m_Remove(oldKey, index);
+        m_Cells[newKey].push_back(index);
+    }
+
+    // Removing from the middle of the path shifts the indices after it down by one
+    void erase(int index, const Eigen::Vector2d& pos)
+    {
+        m_Remove(m_Key(pos), index);
+        for (auto& cell : m_Cells)
+        {
+            for (int& i : cell.second)
+            {
+                if (i > index) i--;
+            }
+        }
+    }
+
+    // Index of the closest point within radius, -1 if there is none
+    template <typename Points>
+    int nearest(const Points& points, const Eigen::Vector2d& pos, double radius) const
+    {
+        int best = -1;
+        double bestDist = radius * radius;
+
+        int64_t x0 = m_Cell(pos.x() - radius), x1 = m_Cell(pos.x() + radius);
+        int64_t y0 = m_Cell(pos.y() - radius), y1 = m_Cell(pos.y() + radius);
+        for (int64_t cx = x0; cx <= x1; cx++)
+        {
+            for (int64_t cy = y0; cy <= y1; cy++)
+            {
+                auto it = m_Cells.find(m_Key(cx, cy));
+                if (it == m_Cells.end()) continue;
+
+                for (int i : it->second)
+                {
+                    double dist = (points[i] - pos).squaredNorm();
+                    if (dist < bestDist)
+                    {
+                        bestDist = dist;
+                        best = i;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    double m_CellSize;
+    std::unordered_map<int64_t, std::vector<int>> m_Cells;
+
+    int64_t m_Cell(double v) const { return static_cast<int64_t>(floor(v / m_CellSize)); }
+    static int64_t m_Key(int64_t cx, int64_t cy) { return static_cast<int64_t>((static_cast<uint64_t>(cx) << 32) ^ static_cast<uint32_t>(cy)); }
+    int64_t m_Key(const Eigen::Vector2d& pos) const { return m_Key(m_Cell(pos.x()), m_Cell(pos.y())); }
+
+    void m_Remove(int64_t key, int index)
+    {
+        auto it = m_Cells.find(key);
+        if (it == m_Cells.end()) return;
+
+        std::vector<int>& cell = it->second;
+        cell.erase(std::remove(cell.begin(), cell.end(), index), cell.end());
+        if (cell.empty()) m_Cells.erase(it);
+    }
+};
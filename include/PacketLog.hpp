@@ -0,0 +1,200 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SerialInterface.hpp"
+#include "Localization/AnchorTable.hpp"
+
+#define PACKETLOG_MAGIC 0x474C3350 // "P3LG"
+#define PACKETLOG_VERSION 1
+#define PACKETLOG_MAX_RECORD_SIZE 64
+#define PACKETLOG_ANCHOR_RECORD 0xF0 // Log only record, one per anchor written when recording starts
+
+// File layout: PacketLogHeader, then records of PacketLogRecordHeader followed by size bytes of payload.
+// Packet records hold the raw packet struct and use its packet ID as the record ID.
+
+#pragma pack(push, 1)
+struct PacketLogHeader
+{
+    uint32_t magic = PACKETLOG_MAGIC;
+    uint16_t version = PACKETLOG_VERSION;
+    uint16_t reserved = 0;
+};
+
+struct PacketLogRecordHeader
+{
+    double timestamp = 0; // Seconds since the application started
+    uint8_t recordID = 0;
+    uint8_t size = 0;
+};
+
+struct AnchorLogRecord
+{
+    uint8_t index = 0;
+    double x = 0;
+    double y = 0;
+    double scale = 1;
+    double bias = 0;
+};
+#pragma pack(pop)
+
+struct PacketLogRecord
+{
+    double timestamp = 0;
+    uint8_t recordID = 0;
+    uint8_t size = 0;
+    uint8_t data[PACKETLOG_MAX_RECORD_SIZE] = {};
+
+    template <typename T>
+    bool as(T& out) const
+    {
+        if (size != sizeof(T)) return false;
+        memcpy(&out, data, sizeof(T));
+        return true;
+    }
+};
+
+class PacketLogWriter
+{
+private:
+    std::ofstream m_File;
+    std::string m_Path;
+    size_t m_RecordCount = 0;
+
+public:
+    ~PacketLogWriter() { close(); }
+
+    // Starts a new log, the anchor table is written first so the log can be replayed on its own
+    bool open(const std::string& path, const AnchorTable& anchors, double timestamp)
+    {
+        close();
+        m_File.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_File.is_open())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PACKETLOG ERROR: Unable to open file %s for writing\n", path.c_str());
+            return false;
+        }
+
+        PacketLogHeader header;
+        m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_Path = path;
+        m_RecordCount = 0;
+
+        for (size_t i = 0; i < anchors.size(); i++)
+        {
+            AnchorLogRecord anchor;
+            anchor.index = static_cast<uint8_t>(i);
+            anchor.x = anchors.x[i];
+            anchor.y = anchors.y[i];
+            anchor.scale = anchors.scale[i];
+            anchor.bias = anchors.bias[i];
+            write(timestamp, PACKETLOG_ANCHOR_RECORD, anchor);
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PACKETLOG INFO: Recording to %s\n", path.c_str());
+        return true;
+    }
+
+    void close()
+    {
+        if (m_File.is_open())
+        {
+            m_File.close();
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PACKETLOG INFO: Saved %zu records to %s\n", m_RecordCount, m_Path.c_str());
+        }
+    }
+
+    bool isOpen() const { return m_File.is_open(); }
+    size_t recordCount() const { return m_RecordCount; }
+
+    template <typename T>
+    void write(double timestamp, uint8_t recordID, const T& payload)
+    {
+        static_assert(sizeof(T) <= PACKETLOG_MAX_RECORD_SIZE, "Record payload too large");
+        if (!m_File.is_open()) return;
+
+        PacketLogRecordHeader header;
+        header.timestamp = timestamp;
+        header.recordID = recordID;
+        header.size = static_cast<uint8_t>(sizeof(T));
+
+        m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_File.write(reinterpret_cast<const char*>(&payload), sizeof(T));
+        m_RecordCount++;
+    }
+
+    template <typename PacketType>
+    void writePacket(double timestamp, const PacketType& packet)
+    {
+        write(timestamp, packet.packetID, packet);
+    }
+};
+
+class PacketLogReader
+{
+private:
+    std::ifstream m_File;
+
+public:
+    bool open(const std::string& path)
+    {
+        m_File.open(path, std::ios::binary);
+        if (!m_File.is_open())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PACKETLOG ERROR: Unable to open file %s for reading\n", path.c_str());
+            return false;
+        }
+
+        PacketLogHeader header;
+        m_File.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!m_File || header.magic != PACKETLOG_MAGIC || header.version != PACKETLOG_VERSION)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PACKETLOG ERROR: %s is not a version %d packet log\n", path.c_str(), PACKETLOG_VERSION);
+            m_File.close();
+            return false;
+        }
+        return true;
+    }
+
+    // Returns false at the end of the log or on a truncated record
+    bool next(PacketLogRecord& record)
+    {
+        PacketLogRecordHeader header;
+        if (!m_File.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        if (header.size > PACKETLOG_MAX_RECORD_SIZE) return false;
+
+        record.timestamp = header.timestamp;
+        record.recordID = header.recordID;
+        record.size = header.size;
+        return static_cast<bool>(m_File.read(reinterpret_cast<char*>(record.data), header.size));
+    }
+
+    // Reads a whole log, anchor records are applied to the table instead of being returned
+    static bool load(const std::string& path, std::vector<PacketLogRecord>& records, AnchorTable& anchors)
+    {
+        PacketLogReader reader;
+        if (!reader.open(path)) return false;
+
+        PacketLogRecord record;
+        while (reader.next(record))
+        {
+            AnchorLogRecord anchor;
+            if (record.recordID == PACKETLOG_ANCHOR_RECORD && record.as(anchor))
+            {
+                while (anchors.size() <= anchor.index) anchors.add({0, 0});
+                anchors.setPosition(anchor.index, {anchor.x, anchor.y});
+                anchors.scale[anchor.index] = anchor.scale;
+                anchors.bias[anchor.index] = anchor.bias;
+            }
+            else
+            {
+                records.push_back(record);
+            }
+        }
+        return true;
+    }
+};
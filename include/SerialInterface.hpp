@@ -90,7 +90,7 @@ private:
     std::mutex m_Mutex;
 
     serialib m_SerialPort;
-    unsigned int m_Baudrate;
+    unsigned int m_Baudrate = 0;
     std::string m_PortName; 
 
     std::atomic_bool m_RunThread = false; // Prevent undefined behaviour when stopping thread
@@ -99,6 +99,11 @@ private:
     volatile bool m_NewCommandPacket = false;
     volatile bool m_StatusDataReady = false;
 
+    // Time from SetCommandVel to the command leaving the port (ns)
+    std::atomic<uint64_t> m_CommandQueuedNS = 0;
+    std::atomic<uint64_t> m_CommandDelayNS = 0;
+    std::atomic_bool m_NewCommandDelay = false;
+
     EncoderDataPacket m_LatestEncoderPacket;
     LandmarkPacket m_LatestAnchorPacket;
     RobotCommandPacket m_LatestCommandPacket;
@@ -116,6 +121,11 @@ public:
     bool ClosePort();
     void SetCommandVel(float velA, float velB);
     void PrintRawPacket(uint8_t *bytes, size_t numBytes);
+
+    // Time to clock a number of bytes over the link (s)
+    double TransmissionTime(size_t numBytes) const { return (m_Baudrate > 0) ? numBytes * 10.0 / m_Baudrate : 0.0; }
+    // Returns true with the delay of the last command sent (queue and transmission, s) if there is a new one
+    bool PopCommandDelay(double& delay);
     
     template <typename PacketType>
     void dispatchPacketEvent(PacketType *packet, int eventCode);
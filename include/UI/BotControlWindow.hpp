@@ -8,7 +8,7 @@
 #define RIGHT 2.0f, 0.0f
 #define STOP 0.0f, 0.0f
 
-typedef enum {MANUAL, WAYPOINT, MOUSE} ControlMode_t;
+typedef enum {MANUAL, WAYPOINT, MOUSE, PURSUIT, MPC} ControlMode_t;
 
 class BotControlWindow : public UIwindow
 {
@@ -18,6 +18,10 @@ private:
 public:
 ControlMode_t controlMode = MANUAL;
 
+    // Wheel speeds (rad/s) of the last manual key, held until another one. The control tick checks them
+    // against the geofence before sending, so a stop is not overwritten on the next frame.
+    float manualCommand[2] = {STOP};
+
     BotControlWindow(SerialInterface& serial) : m_serial(serial)
     {
         //m_serial = serial;
@@ -30,17 +34,28 @@ ControlMode_t controlMode = MANUAL;
             ImGui::Text("Control Mode:  ");
 
             ImGui::SameLine();
-            if (ImGui::Button("Manual")) controlMode = MANUAL;
+            if (ImGui::Button("Manual"))
+            {
+                controlMode = MANUAL;
+                m_SetManual(STOP); // Don't carry on with a key from before the followers ran
+            }
 
             ImGui::SameLine();
             if (ImGui::Button("Waypoint")) controlMode = WAYPOINT;
 
+            ImGui::SameLine();
+            if (ImGui::Button("Spline")) controlMode = PURSUIT;
+
+            ImGui::SameLine();
+            if (ImGui::Button("MPC")) controlMode = MPC;
+
             ImGui::SameLine();
             ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(255, 0, 0, 255));
 
             if (ImGui::Button("STOP"))
             {
                 controlMode = MANUAL;
+                m_SetManual(STOP);
                 m_serial.SetCommandVel(0.0f, 0.0f);
             }  
 
@@ -50,26 +65,33 @@ ControlMode_t controlMode = MANUAL;
             {
                 if (ImGui::IsKeyDown(ImGuiKey_W))
                 {
-                    m_serial.SetCommandVel(FORWARD);
+                    m_SetManual(FORWARD);
                 }
                 else if (ImGui::IsKeyDown(ImGuiKey_S))
                 {
-                    m_serial.SetCommandVel(BACKWARD);
+                    m_SetManual(BACKWARD);
                 }
                 else if (ImGui::IsKeyDown(ImGuiKey_A))
                 {
-                    m_serial.SetCommandVel(LEFT);
+                    m_SetManual(LEFT);
                 }
                 else if (ImGui::IsKeyDown(ImGuiKey_D))
                 {
-                    m_serial.SetCommandVel(RIGHT);
+                    m_SetManual(RIGHT);
                 }
                 else if (ImGui::IsKeyDown(ImGuiKey_Space))
                 {
-                    m_serial.SetCommandVel(STOP);
+                    m_SetManual(STOP);
                 }
             }
         }
         ImGui::End();
     }
+
+private:
+    void m_SetManual(float velA, float velB)
+    {
+        manualCommand[0] = velA;
+        manualCommand[1] = velB;
+    }
 };
\ No newline at end of file
@@ -1,33 +1,87 @@
 #pragma once
+#include <functional>
 #include <imgui.h>
 #include <Eigen/Dense>  
 #include "Core/ViewPort.hpp"
 #include "UI/UIwindow.hpp"
 #include "WorldGrid.hpp"
 #include "Localization/LandmarkContainer.hpp"
-#include "Localization/OdomKalmanFilter.hpp"
+#include "Localization/OdomVelocityKalmanFilter.hpp"
+#include "Localization/FilterTuning.hpp"
+#include "Localization/FixedLagSmoother.hpp"
+#include "Localization/PoseGraph.hpp"
+#include "Localization/HypothesisBank.hpp"
+#include "Localization/RangeQualityModel.hpp"
+#include "Localization/AnchorCalibrator.hpp"
+#include "Localization/OdometryCalibrator.hpp"
+#include "Localization/LatencyCompensator.hpp"
 #include "Localization/PathController.hpp"
+#include "Localization/PathRecorder.hpp"
+#include "Localization/OccupancyGrid.hpp"
+#include "Localization/GridPlanner.hpp"
+#include "Localization/ControlExecutor.hpp"
+#include "Localization/Geofence.hpp"
 
 class ConfigWindow : public UIwindow
 {
 private:
     GridRenderer& m_WorldGrid;
     LandmarkContainer& m_Landmarks;
-    OdomKalmanFilter& m_KalmanFilter;
+    OdomVelocityKalmanFilter& m_KalmanFilter;
+    RangeQualityModel& m_RangeQuality;
+    AnchorCalibrator& m_AnchorCalibrator;
+    OdometryCalibrator& m_OdometryCalibrator;
+    LatencyCompensator& m_LatencyCompensator;
+    FixedLagSmoother& m_LagSmoother;
+    PoseGraph& m_PoseGraph;
+    HypothesisBank& m_HypothesisBank;
     PathController& m_PathController;
+    OccupancyGrid& m_OccupancyGrid;
+    GridPlanner& m_GridPlanner;
+    ControlExecutor& m_ControlExecutor;
+    Geofence& m_Geofence;
+    PathRecorder& m_PathRecorder;
+
+public:
+    // Set by the application, moves the live filter and clears everything that followed the old pose
+    std::function<void(const Eigen::Vector3d&, const Eigen::Matrix3d&)> resetPose;
 
 public:
     ConfigWindow::ConfigWindow
     (
         GridRenderer& worldGrid, 
         LandmarkContainer& landmarks, 
-        OdomKalmanFilter& kalmanFilter, 
-        PathController& pathController
+        OdomVelocityKalmanFilter& kalmanFilter, 
+        RangeQualityModel& rangeQuality,
+        AnchorCalibrator& anchorCalibrator,
+        OdometryCalibrator& odometryCalibrator,
+        LatencyCompensator& latencyCompensator,
+        FixedLagSmoother& lagSmoother,
+        PoseGraph& poseGraph,
+        HypothesisBank& hypothesisBank,
+        PathController& pathController,
+        OccupancyGrid& occupancyGrid,
+        GridPlanner& gridPlanner,
+        ControlExecutor& controlExecutor,
+        Geofence& geofence,
+        PathRecorder& pathRecorder
     ) 
         : m_WorldGrid(worldGrid), 
         m_Landmarks(landmarks), 
         m_KalmanFilter(kalmanFilter), 
-        m_PathController(pathController)
+        m_RangeQuality(rangeQuality),
+        m_AnchorCalibrator(anchorCalibrator),
+        m_OdometryCalibrator(odometryCalibrator),
+        m_LatencyCompensator(latencyCompensator),
+        m_LagSmoother(lagSmoother),
+        m_PoseGraph(poseGraph),
+        m_HypothesisBank(hypothesisBank),
+        m_PathController(pathController),
+        m_OccupancyGrid(occupancyGrid),
+        m_GridPlanner(gridPlanner),
+        m_ControlExecutor(controlExecutor),
+        m_Geofence(geofence),
+        m_PathRecorder(pathRecorder)
     {}
 
     void ConfigWindow::OnUpdate()
@@ -50,33 +104,86 @@ public:
             // Options fo setting Landmark pos & and adjusting visualisation
             if (ImGui::CollapsingHeader("Landmark Options", ImGuiTreeNodeFlags_DefaultOpen))
             {
-                ImGui::Text("Landmark A Position: %.3f, %.3f", m_Landmarks.getLandmarkPos('A').x(), m_Landmarks.getLandmarkPos('A').y());
-                ImGui::Text("Landmark B Position: %.3f, %.3f", m_Landmarks.getLandmarkPos('B').x(), m_Landmarks.getLandmarkPos('B').y());
+                AnchorTable& anchors = m_Landmarks.getAnchors();
+                static int setLandmarkIndex = -1;
+                bool bAnchorsChanged = false;
 
-                ImGui::Text("Landmark A Range: %.3f", m_Landmarks.getLandmarkRange('A'));
-                ImGui::Text("Landmark B Range: %.3f", m_Landmarks.getLandmarkRange('B'));
+                for (int i = 0; i < (int)anchors.size(); i++)
+                {
+                    char id = AnchorTable::idFromIndex(i);
+                    ImGui::PushID(i);
 
-                ImGui::Separator();
+                    ImGui::Text("Landmark %c Position: %.3f, %.3f | Range: %.3f", id, anchors.x[i], anchors.y[i], anchors.range[i]);
+
+                    if (ImGui::Button("Set Pos")) setLandmarkIndex = i;
 
-                static bool setLandmarkA = false;
-                if(ImGui::Button("Set Pos A")) setLandmarkA = true;
+                    // Packet IDs follow the table index so only the last anchor can be removed
+                    if (i == (int)anchors.size() - 1)
+                    {
+                        ImGui::SameLine();
+                        if (ImGui::Button("Remove"))
+                        {
+                            anchors.removeLast();
+                            if (setLandmarkIndex == i) setLandmarkIndex = -1;
+                            bAnchorsChanged = true;
+                            ImGui::PopID();
+                            break;
+                        }
+                    }
 
-                if (setLandmarkA && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                    bAnchorsChanged |= ImGui::InputDouble("Scale", &anchors.scale[i], 0.01, 0.1, "%.3f");
+                    bAnchorsChanged |= ImGui::InputDouble("Bias", &anchors.bias[i], 0.01, 0.1, "%.3f");
+
+                    ImGui::PopID();
+                }
+
+                // Double click in the viewport to place the selected landmark
+                if (anchors.isValid(setLandmarkIndex) && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
                 {
-                    setLandmarkA = false;
-                    m_Landmarks.SetLandmarkPos('A', mousePosWorld);
-                    m_KalmanFilter.setAnchors(m_Landmarks.getLandmarkPos('A'), m_Landmarks.getLandmarkPos('B'));
+                    m_Landmarks.SetLandmarkPos(setLandmarkIndex, mousePosWorld);
+                    setLandmarkIndex = -1;
+                    bAnchorsChanged = true;
                 }
 
-                ImGui::SameLine();
-                static bool setLandmarkB = false;
-                if(ImGui::Button("Set Pos B")) setLandmarkB = true;
+                if (ImGui::Button("Add Landmark"))
+                {
+                    setLandmarkIndex = m_Landmarks.AddLandmark(mousePosWorld);
+                    bAnchorsChanged = true;
+                }
 
-                if (setLandmarkB && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+                if (bAnchorsChanged)
+                {
+                    m_Landmarks.invalidateFix();
+                    m_KalmanFilter.setAnchors(anchors);
+
+                    // The calibrator state is laid out per anchor, restart it from the new table
+                    if (m_AnchorCalibrator.bEnabled)
+                    {
+                        m_AnchorCalibrator.reset(m_KalmanFilter.x, m_KalmanFilter.P, anchors);
+                        m_AnchorCalibrator.encoderA = m_KalmanFilter.encoderA;
+                        m_AnchorCalibrator.encoderB = m_KalmanFilter.encoderB;
+                    }
+                }
+
+                ImGui::Separator();
+
+                // Absolute position fix from the latest ranges
+                const MultilaterationResult& fix = m_Landmarks.getFix();
+                if (fix.bValid)
+                {
+                    ImGui::Text("Range Fix: %.3f, %.3f | GDOP: %.2f | Residual: %.3f", fix.pos.x(), fix.pos.y(), fix.gdop, fix.residualRms);
+                    if (ImGui::Button("Reset Filter To Fix"))
+                    {
+                        Eigen::Matrix3d P = m_KalmanFilter.P;
+                        P.block<2, 2>(0, 0) = fix.covariance;
+                        P.block<1, 2>(2, 0).setZero();
+                        P.block<2, 1>(0, 2).setZero();
+                        if (resetPose) resetPose({fix.pos.x(), fix.pos.y(), m_KalmanFilter.x.z()}, P);
+                    }
+                }
+                else
                 {
-                    setLandmarkB = false;
-                    m_Landmarks.SetLandmarkPos('B', mousePosWorld);
-                    m_KalmanFilter.setAnchors(m_Landmarks.getLandmarkPos('A'), m_Landmarks.getLandmarkPos('B'));
+                    ImGui::Text("Range Fix: not enough anchors in range");
                 }
 
                 ImGui::Separator();
@@ -97,6 +204,207 @@ public:
                 ImGui::Text("Pose Estimate: %.3f, %.3f, %.3f", m_KalmanFilter.x.x(), m_KalmanFilter.x.y(), m_KalmanFilter.x.z());
                 ImGui::InputDouble("Process Noise", &m_KalmanFilter.processNoise, 0.01f, 0.1f, "%.3e");
                 ImGui::InputDouble("Measurement Noise", &m_KalmanFilter.measurementNoise, 0.01f, 0.1f, "%.3e");
+
+                // Noise chosen offline by the KalmanTune tool
+                if (ImGui::Button("Load Tuning"))
+                {
+                    FilterTuning tuning;
+                    if (tuning.load(TUNING_DEFAULT_FILE)) tuning.applyTo(m_KalmanFilter);
+                }
+
+                ImGui::Separator();
+                ImGui::Text("Velocity: %.3f m/s, %.3f rad/s", m_KalmanFilter.velocity.x(), m_KalmanFilter.velocity.y());
+                ImGui::Checkbox("Extrapolate Pose", &m_KalmanFilter.bExtrapolate);
+                ImGui::InputDouble("Wheel Speed Noise", &m_KalmanFilter.wheelVelNoise, 0.05, 0.5, "%.3f");
+
+                ImGui::Separator();
+                if (ImGui::Checkbox("Fixed-Lag Smoother", &m_LagSmoother.bEnabled)) m_LagSmoother.clear();
+                ImGui::InputDouble("Smoother Lag (s)", &m_LagSmoother.lag, 0.05, 0.1, "%.2f");
+                Eigen::Vector3d lagged = m_LagSmoother.laggedPose();
+                ImGui::Text("Smoothed Pose: %.3f, %.3f, %.3f (%zu steps)", lagged.x(), lagged.y(), lagged.z(), m_LagSmoother.smoother.size());
+
+                ImGui::Separator();
+                ImGui::Checkbox("Innovation Gating", &m_KalmanFilter.bGating);
+                ImGui::InputDouble("Gate (NIS)", &m_KalmanFilter.gateThreshold, 1.0, 5.0, "%.2f");
+                ImGui::InputInt("Max Consecutive Rejects", &m_KalmanFilter.maxConsecutiveRejects);
+
+                // Mean NIS of a consistent filter sits inside these bounds
+                ConsistencyMonitor& consistency = m_KalmanFilter.consistency;
+                double nisLower, nisUpper;
+                ConsistencyMonitor::meanBounds(consistency.nis, 1.0, nisLower, nisUpper);
+                ImGui::Text("Mean NIS: %.2f (%.2f - %.2f) over %zu", consistency.nis.mean(), nisLower, nisUpper, consistency.nis.count());
+                ImGui::Text("Accepted: %zu   Rejected: %zu", consistency.totalAccepted, consistency.totalRejected);
+
+                for (size_t i = 0; i < consistency.anchors.size(); i++)
+                {
+                    const ConsistencyMonitor::AnchorStats& stats = consistency.anchors[i];
+                    ImGui::Text("  %c: accepted %zu, rejected %zu, mean NIS %.2f",
+                        AnchorTable::idFromIndex(static_cast<int>(i)), stats.accepted, stats.rejected, stats.nis.mean());
+                }
+
+                if (ImGui::Button("Reset Statistics"))
+                {
+                    consistency.reset();
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Range Quality"))
+            {
+                ImGui::Checkbox("Use Quality Model", &m_RangeQuality.bEnabled);
+                ImGui::InputDouble("log(R) Offset", &m_RangeQuality.logVarOffset, 0.1, 1.0, "%.3f");
+                ImGui::InputDouble("log(R) Slope", &m_RangeQuality.logVarSlope, 0.01, 0.1, "%.4f");
+                ImGui::InputDouble("NLOS Power (dBm)", &m_RangeQuality.nlosPower, 1.0, 5.0, "%.1f");
+                ImGui::InputDouble("NLOS Bias (m)", &m_RangeQuality.nlosBias, 0.05, 0.1, "%.2f");
+
+                for (size_t i = 0; i < m_RangeQuality.anchors.size(); i++)
+                {
+                    const RangeQualityModel::AnchorState& state = m_RangeQuality.anchors[i];
+                    ImGui::Text("  %c: %.1f dBm, std %.3f m, residual %.3f m, NLOS %zu%s",
+                        AnchorTable::idFromIndex(static_cast<int>(i)), state.lastPower, sqrt(state.last.variance), 
+                        state.residuals.mean(), state.nlosCount, state.last.bNlos ? " (NLOS)" : "");
+                }
+
+                if (ImGui::Button("Save Model")) m_RangeQuality.save(RQ_DEFAULT_FILE);
+                ImGui::SameLine();
+                if (ImGui::Button("Load Model")) m_RangeQuality.load(RQ_DEFAULT_FILE);
+            }
+
+            // Estimates anchor positions and range calibration while driving, starting from the current table
+            if (ImGui::CollapsingHeader("Anchor Self-Calibration"))
+            {
+                AnchorTable& anchors = m_Landmarks.getAnchors();
+
+                if (ImGui::Checkbox("Calibrate Anchors", &m_AnchorCalibrator.bEnabled) && m_AnchorCalibrator.bEnabled)
+                {
+                    m_AnchorCalibrator.reset(m_KalmanFilter.x, m_KalmanFilter.P, anchors);
+                    m_AnchorCalibrator.encoderA = m_KalmanFilter.encoderA;
+                    m_AnchorCalibrator.encoderB = m_KalmanFilter.encoderB;
+                }
+
+                if (m_AnchorCalibrator.bEnabled)
+                {
+                    ImGui::Text("Accepted: %zu   Rejected: %zu", m_AnchorCalibrator.acceptedCount, m_AnchorCalibrator.rejectedCount);
+
+                    for (int i = 0; i < m_AnchorCalibrator.anchorCount(); i++)
+                    {
+                        ImGui::PushID(i);
+                        ImGui::Text("%c: %.3f, %.3f (+/- %.3f) | Scale: %.3f | Bias: %.3f", 
+                            AnchorTable::idFromIndex(i), m_AnchorCalibrator.anchorPos(i).x(), m_AnchorCalibrator.anchorPos(i).y(),
+                            sqrt(m_AnchorCalibrator.anchorCovariance(i).trace()), m_AnchorCalibrator.anchorScale(i), m_AnchorCalibrator.anchorBias(i));
+                        ImGui::SameLine();
+                        if (ImGui::Button("Release")) m_AnchorCalibrator.releaseAnchor(i);
+                        ImGui::PopID();
+                    }
+
+                    if (m_AnchorCalibrator.anchorCount() != static_cast<int>(anchors.size()))
+                    {
+                        ImGui::Text("Anchor table changed, restart calibration");
+                    }
+                    else if (ImGui::Button("Apply To Anchors"))
+                    {
+                        m_AnchorCalibrator.applyTo(anchors);
+                        m_Landmarks.invalidateFix();
+                        m_KalmanFilter.setAnchors(anchors);
+                    }
+                }
+            }
+
+            // Wheel geometry shared by the filters and the path controller
+            if (ImGui::CollapsingHeader("Kinematics"))
+            {
+                std::lock_guard<std::mutex> lock(m_PathController.mutex); // Shared with the control thread
+                KinematicParams& kinematics = KinematicParams::GetShared();
+                ImGui::InputDouble("Wheel Radius A", &kinematics.wheelRadiusL, 0.0005, 0.001, "%.5f");
+                ImGui::InputDouble("Wheel Radius B", &kinematics.wheelRadiusR, 0.0005, 0.001, "%.5f");
+                ImGui::InputDouble("Track Width", &kinematics.trackWidth, 0.001, 0.01, "%.4f");
+
+                ImGui::Separator();
+
+                // Estimates the geometry from ranges while driving, starting from the current pose and values
+                if (ImGui::Checkbox("Calibrate Odometry", &m_OdometryCalibrator.bEnabled) && m_OdometryCalibrator.bEnabled)
+                {
+                    m_OdometryCalibrator.reset(m_KalmanFilter.x, m_KalmanFilter.P, kinematics);
+                    m_OdometryCalibrator.encoderA = m_KalmanFilter.encoderA;
+                    m_OdometryCalibrator.encoderB = m_KalmanFilter.encoderB;
+                }
+
+                KinematicParams estimate = m_OdometryCalibrator.estimate();
+                Eigen::Vector3d relStd = m_OdometryCalibrator.relativeStdDev() * 100.0;
+                ImGui::Text("Ranges: %zu (rejected %zu) | Mean NIS: %.2f", 
+                    m_OdometryCalibrator.acceptedCount, m_OdometryCalibrator.rejectedCount, m_OdometryCalibrator.nis.mean());
+                ImGui::Text("Radius A: %.5f (+/- %.2f%%)", estimate.wheelRadiusL, relStd.x());
+                ImGui::Text("Radius B: %.5f (+/- %.2f%%)", estimate.wheelRadiusR, relStd.y());
+                ImGui::Text("Track Width: %.4f (+/- %.2f%%)", estimate.trackWidth, relStd.z());
+                ImGui::Text("%s", m_OdometryCalibrator.isConverged() ? "Converged" : "Not converged");
+
+                if (ImGui::Button("Apply Estimate"))
+                {
+                    kinematics = estimate;
+                }
+            }
+
+            // Sliding window optimisation over odometry and ranges, solved on its own thread
+            if (ImGui::CollapsingHeader("Pose Graph"))
+            {
+                bool bRunning = m_PoseGraph.isRunning();
+                if (ImGui::Checkbox("Optimise Pose Graph", &bRunning))
+                {
+                    if (bRunning) m_PoseGraph.start();
+                    else m_PoseGraph.stop();
+                    m_PoseGraph.clear();
+                }
+
+                int windowSize = static_cast<int>(m_PoseGraph.windowSize);
+                if (ImGui::InputInt("Window Size", &windowSize, 10, 50)) m_PoseGraph.windowSize = static_cast<size_t>(std::max(windowSize, 2));
+                ImGui::InputDouble("Correction Weight", &m_PoseGraph.correctionWeight, 0.1, 0.2, "%.2f");
+                m_PoseGraph.correctionWeight = std::clamp(m_PoseGraph.correctionWeight, 0.01, 1.0);
+
+                ImGui::Text("Nodes: %zu | Ranges: %zu", m_PoseGraph.nodeCount(), m_PoseGraph.rangeCount());
+                ImGui::Text("Solve: %.2f ms, %d iterations, cost %.1f", m_PoseGraph.lastSolveMs.load(), m_PoseGraph.lastIterations.load(), m_PoseGraph.lastCost.load());
+            }
+
+            // Bank of filters over both mirror solutions of the fix, hands the winner to the live filter
+            if (ImGui::CollapsingHeader("Auto Localisation"))
+            {
+                // The bank predicts from the encoder counts, so it starts from the live filter's baseline
+                if (ImGui::Checkbox("Localise Automatically", &m_HypothesisBank.bEnabled))
+                {
+                    m_HypothesisBank.reset();
+                    m_HypothesisBank.encoderA = m_KalmanFilter.encoderA;
+                    m_HypothesisBank.encoderB = m_KalmanFilter.encoderB;
+                }
+                if (ImGui::Button("Relocalise"))
+                {
+                    m_HypothesisBank.reset();
+                    m_HypothesisBank.encoderA = m_KalmanFilter.encoderA;
+                    m_HypothesisBank.encoderB = m_KalmanFilter.encoderB;
+                    m_HypothesisBank.bEnabled = true;
+                }
+
+                if (m_HypothesisBank.isSeeded())
+                {
+                    int best = m_HypothesisBank.best();
+                    ImGui::Text("Hypotheses: %d | Ranges: %zu", m_HypothesisBank.size(), m_HypothesisBank.updateCount);
+                    ImGui::Text("Best: %.3f, %.3f, %.3f (%.0f%%)", m_HypothesisBank.X(0, best), m_HypothesisBank.X(1, best), m_HypothesisBank.X(2, best), m_HypothesisBank.weights()(best) * 100.0);
+                }
+                else
+                {
+                    ImGui::Text(m_HypothesisBank.bEnabled ? "Waiting for a position fix" : "Localised");
+                }
+            }
+
+            // Commands are generated for the pose predicted to when they reach the robot
+            if (ImGui::CollapsingHeader("Latency Compensation"))
+            {
+                std::lock_guard<std::mutex> lock(m_PathController.mutex); // Shared with the control thread
+                ImGui::Checkbox("Compensate Latency", &m_LatencyCompensator.bEnabled);
+                ImGui::InputDouble("Actuation Delay (s)", &m_LatencyCompensator.actuationDelay, 0.005, 0.01, "%.3f");
+                ImGui::InputDouble("Max Prediction (s)", &m_LatencyCompensator.maxPrediction, 0.05, 0.1, "%.2f");
+                m_LatencyCompensator.actuationDelay = std::max(m_LatencyCompensator.actuationDelay, 0.0);
+
+                ImGui::Text("Inbound Delay: %.1f ms", m_LatencyCompensator.inboundDelay.mean() * 1000.0);
+                ImGui::Text("Outbound Delay: %.1f ms", m_LatencyCompensator.outboundDelay.mean() * 1000.0);
+                ImGui::Text("Command Latency: %.1f ms", m_LatencyCompensator.commandLatency() * 1000.0);
             }
 
             if (ImGui::CollapsingHeader("Waypoint Options", ImGuiTreeNodeFlags_DefaultOpen))
@@ -120,8 +428,175 @@ public:
         
                 if (ImGui::Button("Clear Path"))
                 {
-                    m_PathController.waypoints.clear();
+                    std::lock_guard<std::mutex> lock(m_PathController.mutex);
+                    m_PathController.clearWaypoints();
+                }
+
+                // After a load the levels are rebuilt here, outside the lock
+                const PathLod& lod = m_PathController.getLod();
+
+                // Loading and saving only read or swap the path, the settings below are shared with the control thread
+                std::lock_guard<std::mutex> lock(m_PathController.mutex);
+
+                ImGui::InputDouble("Lookahead (m)", &m_PathController.lookahead, 0.05, 0.1, "%.2f");
+                m_PathController.lookahead = std::max(m_PathController.lookahead, 0.05);
+
+                // Follow a simplified path, drawing always picks the level for the zoom
+                double followTolerance = m_PathController.followTolerance();
+                if (ImGui::InputDouble("Follow Tolerance (m)", &followTolerance, 0.001, 0.01, "%.3f"))
+                {
+                    m_PathController.setFollowTolerance(followTolerance);
+                }
+                size_t drawn = lod.level(LOD_PIXEL_TOLERANCE / std::max(ViewPort::GetInstance().GetCamera().getScale(), 1)).size();
+                ImGui::Text("Drawn: %zu of %zu waypoints, %zu levels", drawn, m_PathController.waypoints.size(), lod.levelCount());
+
+                // Speed profile along the spline, any change replans the whole path
+                VelocityProfile& profile = m_PathController.getProfile();
+                bool bReplan = false;
+                bReplan |= ImGui::InputDouble("Max Speed (m/s)", &profile.maxSpeed, 0.05, 0.1, "%.2f");
+                bReplan |= ImGui::InputDouble("Max Accel (m/s^2)", &profile.maxAccel, 0.05, 0.1, "%.2f");
+                bReplan |= ImGui::InputDouble("Max Decel (m/s^2)", &profile.maxDecel, 0.05, 0.1, "%.2f");
+                bReplan |= ImGui::InputDouble("Max Lateral Accel (m/s^2)", &profile.maxLateralAccel, 0.05, 0.1, "%.2f");
+                bReplan |= ImGui::InputDouble("Max Wheel Speed (m/s)", &profile.maxWheelSpeed, 0.05, 0.1, "%.2f");
+                if (bReplan)
+                {
+                    profile.maxSpeed = std::max(profile.maxSpeed, 0.0);
+                    profile.maxAccel = std::max(profile.maxAccel, 0.01);
+                    profile.maxDecel = std::max(profile.maxDecel, 0.01);
+                    profile.maxLateralAccel = std::max(profile.maxLateralAccel, 0.01);
+                    profile.maxWheelSpeed = std::max(profile.maxWheelSpeed, 0.01);
+                    m_PathController.replanSpeeds();
+                }
+                ImGui::Text("Last Replan: %zu samples", profile.lastUpdateSamples);
+            }
+
+            // Drive the route manually, then use the recording as the path and save it from Waypoint Options
+            if (ImGui::CollapsingHeader("Path Recording"))
+            {
+                if (!m_PathRecorder.isRecording())
+                {
+                    if (ImGui::Button("Start Recording")) m_PathRecorder.start();
+                }
+                else if (ImGui::Button("Stop Recording"))
+                {
+                    m_PathRecorder.stop();
+                }
+                ImGui::SameLine();
+                ImGui::Checkbox("Show Recording", &m_PathRecorder.bRender);
+
+                ImGui::InputDouble("Point Spacing (m)", &m_PathRecorder.spacing, 0.01, 0.05, "%.2f");
+                ImGui::InputDouble("Heading Change (rad)", &m_PathRecorder.headingThreshold, 0.05, 0.1, "%.2f");
+                m_PathRecorder.spacing = std::max(m_PathRecorder.spacing, RECORD_MIN_SPACING);
+                m_PathRecorder.headingThreshold = std::max(m_PathRecorder.headingThreshold, 0.01);
+                ImGui::Text("Kept: %zu of %zu poses, buffer %zu", m_PathRecorder.points().size(), m_PathRecorder.samples, m_PathRecorder.capacity());
+
+                // Paths are followed as loops, an open route gets a straight run from its end back to its start
+                double loopGap = m_PathRecorder.loopGap();
+                if (loopGap > RECORD_LOOP_GAP) ImGui::Text("Ends %.2f m from its start, the path will close it in a straight line", loopGap);
+
+                if (ImGui::Button("Use Recording As Path") && !m_PathRecorder.isRecording() && m_PathRecorder.points().size() > 1)
+                {
+                    if (loopGap > RECORD_LOOP_GAP)
+                    {
+                        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RECORD INFO: Route ends %.2f m from its start, the path closes the loop with a straight segment\n", loopGap);
+                    }
+                    m_PathController.setWaypoints(m_PathRecorder.points());
                 }
+                ImGui::SameLine();
+                if (ImGui::Button("Clear Recording")) m_PathRecorder.clear();
+            }
+
+            // Timing of the fixed rate control thread
+            if (ImGui::CollapsingHeader("Control Loop"))
+            {
+                ControlStats stats = m_ControlExecutor.stats();
+                ImGui::Text("Period: %.1f ms, %s", m_ControlExecutor.period() * 1000.0, m_ControlExecutor.isRunning() ? "running" : "stopped");
+                ImGui::Text("Ticks: %llu, Overruns: %llu", static_cast<unsigned long long>(stats.ticks), static_cast<unsigned long long>(stats.overruns));
+                ImGui::Text("Jitter: %.1f us mean, %.1f us max (%.1f us sd)", stats.meanJitter, stats.maxJitter, stats.sdJitter);
+                ImGui::Text("Tick: %.1f us mean, %.1f us max", stats.meanExec, stats.maxExec);
+                if (ImGui::Button("Reset Control Stats")) m_ControlExecutor.resetStats();
+            }
+
+            // Tracks the spline at the planned speeds, solve time is fixed by the iteration count
+            if (ImGui::CollapsingHeader("Model Predictive Control"))
+            {
+                std::lock_guard<std::mutex> lock(m_PathController.mutex); // Shared with the control thread
+                MpcController& mpc = m_PathController.mpc;
+                ImGui::InputDouble("Position Weight", &mpc.posWeight, 5.0, 10.0, "%.1f");
+                ImGui::InputDouble("Heading Weight", &mpc.headingWeight, 0.5, 1.0, "%.2f");
+                ImGui::InputDouble("Input Weight", &mpc.inputWeight, 0.1, 0.5, "%.2f");
+                ImGui::InputDouble("MPC Wheel Limit (m/s)", &mpc.maxWheelSpeed, 0.05, 0.1, "%.2f");
+                ImGui::InputInt("Iterations", &mpc.iterations, 5, 10);
+                mpc.inputWeight = std::max(mpc.inputWeight, 1e-3);
+                mpc.iterations = std::clamp(mpc.iterations, 1, 500);
+
+                ImGui::Text("Solve: %.1f us mean, %.1f us max (%.1f us sd)", mpc.solveTime.mean(), mpc.maxSolveTime, sqrt(mpc.solveTime.variance()));
+                ImGui::Text("Residual: %.2e", mpc.lastResidual);
+                if (ImGui::Button("Reset Stats")) mpc.resetStats();
+            }
+
+            // Obstacles are painted in the viewport, the planner routes from the robot to a ctrl + right clicked goal
+            if (ImGui::CollapsingHeader("Occupancy Map"))
+            {
+                ImGui::Checkbox("Show Map", &m_OccupancyGrid.bRender);
+                ImGui::SameLine();
+                ImGui::Checkbox("Edit Obstacles", &m_OccupancyGrid.bEditing);
+                ImGui::InputDouble("Brush Radius (m)", &m_OccupancyGrid.brushRadius, 0.01, 0.05, "%.2f");
+                m_OccupancyGrid.brushRadius = std::max(m_OccupancyGrid.brushRadius, 0.0);
+
+                // Regrowing every obstacle invalidates every cost the planner holds
+                if (ImGui::InputDouble("Inflation (m)", &m_OccupancyGrid.inflation, 0.01, 0.05, "%.2f"))
+                {
+                    m_OccupancyGrid.inflation = std::max(m_OccupancyGrid.inflation, 0.0);
+                    m_OccupancyGrid.reinflate();
+                    m_GridPlanner.reset();
+                }
+
+                if (ImGui::Button("Clear Map"))
+                {
+                    m_OccupancyGrid.clear();
+                    m_GridPlanner.reset();
+                }
+                ImGui::Text("Grid: %d x %d cells", m_OccupancyGrid.width, m_OccupancyGrid.height);
+
+                ImGui::Checkbox("Plan To Goal", &m_GridPlanner.bEnabled);
+                ImGui::InputInt("Expansions / Frame", &m_GridPlanner.maxExpansions, 5000, 25000);
+                m_GridPlanner.maxExpansions = std::max(m_GridPlanner.maxExpansions, 100);
+
+                if (!m_GridPlanner.hasGoal()) ImGui::Text("Goal: none");
+                else ImGui::Text("Goal: %.2f, %.2f", m_GridPlanner.goal().x(), m_GridPlanner.goal().y());
+                ImGui::Text("Plan: %s, %zu points", m_GridPlanner.bSearching ? "searching" : (m_GridPlanner.bPathFound ? "found" : "no path"), m_GridPlanner.path.size());
+                ImGui::Text("Last Update: %zu expansions, %.2f ms", m_GridPlanner.lastExpansions, m_GridPlanner.lastPlanTime);
+
+                // The followers loop the path, so it comes back the same way rather than cutting through obstacles
+                if (ImGui::Button("Use As Path") && m_GridPlanner.bPathFound)
+                {
+                    std::vector<Eigen::Vector2d> route = m_GridPlanner.path;
+                    if (route.size() > 2) route.insert(route.end(), m_GridPlanner.path.rbegin() + 1, m_GridPlanner.path.rend() - 1);
+                    m_PathController.setWaypoints(std::move(route));
+                }
+            }
+
+            // Zones are drawn in the viewport, left click adds a vertex and right click closes the outline
+            if (ImGui::CollapsingHeader("Geofence"))
+            {
+                std::lock_guard<std::mutex> lock(m_Geofence.mutex); // Shared with the control thread
+                ImGui::Checkbox("Enable Geofence", &m_Geofence.bEnabled);
+                ImGui::SameLine();
+                ImGui::Checkbox("Show Zones", &m_Geofence.bRender);
+                ImGui::Checkbox("Edit Zones", &m_Geofence.bEditing);
+                ImGui::SameLine();
+                ImGui::Checkbox("New Zone Keeps Out", &m_Geofence.bNewKeepOut);
+
+                ImGui::InputDouble("Robot Radius (m)", &m_Geofence.robotRadius, 0.01, 0.05, "%.2f");
+                ImGui::InputDouble("Check Horizon (s)", &m_Geofence.horizon, 0.05, 0.1, "%.2f");
+                m_Geofence.robotRadius = std::max(m_Geofence.robotRadius, 0.0);
+                m_Geofence.horizon = std::max(m_Geofence.horizon, 0.02);
+
+                if (ImGui::Button("Clear Zones")) m_Geofence.clear();
+                ImGui::Text("Zones: %zu, %zu edges", m_Geofence.zones().size(), m_Geofence.edgeCount());
+                ImGui::Text("Check: %.1f us mean (%.1f us sd)", m_Geofence.checkTime.mean(), sqrt(m_Geofence.checkTime.variance()));
+                ImGui::Text("Stops: %zu, %s", m_Geofence.violations, m_Geofence.bViolating ? "stopped" : "clear");
             }
 
         }
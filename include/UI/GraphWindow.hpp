@@ -2,8 +2,11 @@
 #include "implot.h"
 #include "UI/UIwindow.hpp"
 #include "Buffer.hpp"
+#include "Localization/AnchorTable.hpp"
+#include <vector>
 
 #define GRAPH_BUFFER_SIZE 250
+#define GRAPH_MAX_ANCHORS 12
 
 class GraphWindow : public UIwindow
 {
@@ -11,7 +14,7 @@ private:
     struct kData
     {
         double time;
-        Eigen::Matrix<double, 3, 2> K;
+        Eigen::Matrix<double, 3, GRAPH_MAX_ANCHORS> K;
     };
 
     struct pData
@@ -20,28 +23,32 @@ private:
         Eigen::Matrix3d P;
     };
 
+    struct poseData
+    {
+        double time;
+        Eigen::Vector3d pose;
+    };
+
     double& m_AvgFrameTime;
 
     Buffer<ImPlotPoint>& m_FrameTBuffer;
-    Buffer<ImPlotPoint> rangeBufferA;
-    Buffer<ImPlotPoint> rangeBufferB;
-    Buffer<ImPlotPoint> kalmanRangeA;
-    Buffer<ImPlotPoint> kalmanRangeB;
+    std::vector<Buffer<ImPlotPoint>> rangeBuffers;
+    std::vector<Buffer<ImPlotPoint>> kalmanRangeBuffers;
 
     Buffer<kData> kBuffer;
     Buffer<pData> pBuffer;
+    Buffer<poseData> livePoseBuffer;
+    Buffer<poseData> laggedPoseBuffer;
 
 public:
 
     GraphWindow(Buffer<ImPlotPoint>& FrameTBuffer, double& AvgFrameTime) : 
         m_FrameTBuffer(FrameTBuffer), 
         m_AvgFrameTime(AvgFrameTime), 
-        rangeBufferA(GRAPH_BUFFER_SIZE), 
-        rangeBufferB(GRAPH_BUFFER_SIZE),
-        kalmanRangeA(GRAPH_BUFFER_SIZE), 
-        kalmanRangeB(GRAPH_BUFFER_SIZE),
         kBuffer(GRAPH_BUFFER_SIZE),
-        pBuffer(GRAPH_BUFFER_SIZE)
+        pBuffer(GRAPH_BUFFER_SIZE),
+        livePoseBuffer(GRAPH_BUFFER_SIZE),
+        laggedPoseBuffer(GRAPH_BUFFER_SIZE)
     {}
 
     void GraphWindow::OnUpdate() override
@@ -59,25 +66,45 @@ public:
             if (ImGui::CollapsingHeader("Anchor Ranges##Header", ImGuiTreeNodeFlags_DefaultOpen) && ImPlot::BeginPlot("Anchor Ranges")) 
             {
                 ImPlot::SetupAxes("Time (s)", "Range (m)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
-                ImPlot::PlotLine("rangeA"  , &rangeBufferA.data()[0][0], &rangeBufferA.data()[0][1], (int)rangeBufferA.size(), 0, 0, sizeof(rangeBufferA.data()[0]));
-                ImPlot::PlotLine("rangeB"  , &rangeBufferB.data()[0][0], &rangeBufferB.data()[0][1], (int)rangeBufferB.size(), 0, 0, sizeof(rangeBufferB.data()[0]));
-                ImPlot::PlotLine("Kalman A", &kalmanRangeA.data()[0][0], &kalmanRangeA.data()[0][1], (int)kalmanRangeA.size(), 0, 0, sizeof(kalmanRangeA.data()[0]));
-                ImPlot::PlotLine("Kalman B", &kalmanRangeB.data()[0][0], &kalmanRangeB.data()[0][1], (int)kalmanRangeB.size(), 0, 0, sizeof(kalmanRangeB.data()[0]));
+                char label[32];
+                for (size_t i = 0; i < rangeBuffers.size(); i++)
+                {
+                    Buffer<ImPlotPoint>& rangeBuffer = rangeBuffers[i];
+                    Buffer<ImPlotPoint>& kalmanRange = kalmanRangeBuffers[i];
+
+                    snprintf(label, sizeof(label), "range%c", AnchorTable::idFromIndex((int)i));
+                    ImPlot::PlotLine(label, &rangeBuffer.data()[0][0], &rangeBuffer.data()[0][1], (int)rangeBuffer.size(), 0, 0, sizeof(rangeBuffer.data()[0]));
+                    snprintf(label, sizeof(label), "Kalman %c", AnchorTable::idFromIndex((int)i));
+                    ImPlot::PlotLine(label, &kalmanRange.data()[0][0], &kalmanRange.data()[0][1], (int)kalmanRange.size(), 0, 0, sizeof(kalmanRange.data()[0]));
+                }
+                ImPlot::EndPlot();
+            }
+
+            // Live pose against the fixed-lag smoothed pose, plotted at the time each estimate is for
+            if (ImGui::CollapsingHeader("Pose Graph##Header", ImGuiTreeNodeFlags_DefaultOpen) && ImPlot::BeginPlot("Pose##graph"))
+            {
+                ImPlot::SetupAxes("Time (s)", "Position (m)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                ImPlot::PlotLine("x", &livePoseBuffer.data()[0].time, &livePoseBuffer.data()[0].pose(0), (int)livePoseBuffer.size(), 0, 0, sizeof(livePoseBuffer.data()[0]));
+                ImPlot::PlotLine("y", &livePoseBuffer.data()[0].time, &livePoseBuffer.data()[0].pose(1), (int)livePoseBuffer.size(), 0, 0, sizeof(livePoseBuffer.data()[0]));
+                ImPlot::PlotLine("Smoothed x", &laggedPoseBuffer.data()[0].time, &laggedPoseBuffer.data()[0].pose(0), (int)laggedPoseBuffer.size(), 0, 0, sizeof(laggedPoseBuffer.data()[0]));
+                ImPlot::PlotLine("Smoothed y", &laggedPoseBuffer.data()[0].time, &laggedPoseBuffer.data()[0].pose(1), (int)laggedPoseBuffer.size(), 0, 0, sizeof(laggedPoseBuffer.data()[0]));
                 ImPlot::EndPlot();
             }
 
             if (ImGui::CollapsingHeader("K Matrix Graph##Header", ImGuiTreeNodeFlags_DefaultOpen) && ImPlot::BeginPlot("K Matrix ##graph"))
             {
                 ImPlot::SetupAxes("Time (s)", "Gain", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
-                // Row 0: x state gains
-                ImPlot::PlotLine("K(x, r_a)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(0, 0), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
-                ImPlot::PlotLine("K(x, r_b)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(0, 1), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
-                // Row 1: y state gains
-                ImPlot::PlotLine("K(y, r_a)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(1, 0), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
-                ImPlot::PlotLine("K(y, r_b)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(1, 1), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
-                // Row 2: theta state gains
-                ImPlot::PlotLine("K(θ, r_a)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(2, 0), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
-                ImPlot::PlotLine("K(θ, r_b)", &kBuffer.data()[0].time, &kBuffer.data()[0].K(2, 1), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
+                // One column of gains per anchor, rows are the x, y and theta states
+                const char* stateNames[3] = {"x", "y", "θ"};
+                char label[32];
+                for (int row = 0; row < 3; row++)
+                {
+                    for (int col = 0; col < (int)rangeBuffers.size() && col < GRAPH_MAX_ANCHORS; col++)
+                    {
+                        snprintf(label, sizeof(label), "K(%s, r_%c)", stateNames[row], tolower(AnchorTable::idFromIndex(col)));
+                        ImPlot::PlotLine(label, &kBuffer.data()[0].time, &kBuffer.data()[0].K(row, col), (int)kBuffer.size(), 0, 0, sizeof(kBuffer.data()[0]));
+                    }
+                }
                 ImPlot::EndPlot();
             }
         
@@ -102,18 +129,34 @@ public:
         ImGui::End();
     }
 
-    void addRangeData(Eigen::Vector2d rangeData, Eigen::Vector2d KalmanData)
+    void addRangeData(const Eigen::VectorXd& rangeData, const Eigen::VectorXd& KalmanData)
     {
-        rangeBufferA.addData({SDL_GetTicks() / 1000.0, rangeData(0)});
-        rangeBufferB.addData({SDL_GetTicks() / 1000.0, rangeData(1)});
-        kalmanRangeA.addData({SDL_GetTicks() / 1000.0, KalmanData(0)});
-        kalmanRangeB.addData({SDL_GetTicks() / 1000.0, KalmanData(1)});
+        while (rangeBuffers.size() < static_cast<size_t>(rangeData.size()))
+        {
+            rangeBuffers.emplace_back(GRAPH_BUFFER_SIZE);
+            kalmanRangeBuffers.emplace_back(GRAPH_BUFFER_SIZE);
+        }
+
+        for (Eigen::Index i = 0; i < rangeData.size(); i++)
+        {
+            rangeBuffers[i].addData({SDL_GetTicks() / 1000.0, rangeData(i)});
+            kalmanRangeBuffers[i].addData({SDL_GetTicks() / 1000.0, KalmanData(i)});
+        }
     }
 
-    void addKalmanData(Eigen::Matrix<double, 3, 2> K, Eigen::Matrix3d P)
+    void addKalmanData(const Eigen::Matrix<double, 3, Eigen::Dynamic>& K, Eigen::Matrix3d P)
     {
-        kBuffer.addData({SDL_GetTicks() / 1000.0, K});
+        Eigen::Matrix<double, 3, GRAPH_MAX_ANCHORS> kPadded = Eigen::Matrix<double, 3, GRAPH_MAX_ANCHORS>::Zero();
+        Eigen::Index cols = (K.cols() < GRAPH_MAX_ANCHORS) ? K.cols() : GRAPH_MAX_ANCHORS;
+        kPadded.leftCols(cols) = K.leftCols(cols);
+
+        kBuffer.addData({SDL_GetTicks() / 1000.0, kPadded});
         pBuffer.addData({SDL_GetTicks() / 1000.0, P});
     }
-};
 
+    void addPoseData(double liveTime, const Eigen::Vector3d& livePose, double laggedTime, const Eigen::Vector3d& laggedPose)
+    {
+        livePoseBuffer.addData({liveTime, livePose});
+        laggedPoseBuffer.addData({laggedTime, laggedPose});
+    }
+};
@@ -1,6 +1,8 @@
 #include "imgui.h"
 #include "SerialInterface.hpp"
+#include "PacketLog.hpp"
 #include "UI/UIwindow.hpp"
+#include "Localization/AnchorTable.hpp"
 #include <deque>
 
 #define SERIAL_LINE_SIZE_BYTES 128
@@ -25,8 +27,13 @@ public:
     SerialInterface& serialCom;
     std::vector<std::string> availablePorts;
 
+    // Every received packet is written to the log while recording
+    PacketLogWriter packetLog;
+    const AnchorTable& anchors;
+    char logName[64] = "PacketLog";
+
 public:
-    SerialMonitor(SerialInterface& serialCom) : serialCom(serialCom)
+    SerialMonitor(SerialInterface& serialCom, const AnchorTable& anchors) : serialCom(serialCom), anchors(anchors)
     {
         findAvailablePorts();
     }
@@ -46,20 +53,25 @@ public:
         }
     }
 
+    static double logTimestamp() { return SDL_GetTicksNS() / 1e9; }
+
     void OnNewStatusPacket(StatusPacket* packet)
     {
+        packetLog.writePacket(logTimestamp(), *packet);
         statPacket = *packet;
         newStatPacket = true;
     }
 
     void OnNewLandmarkPacket(LandmarkPacket* packet)
     {
+        packetLog.writePacket(logTimestamp(), *packet);
         AncPacket = *packet;
         newLandmarkPacket = true;
     }
 
     void OnNewEncoderPacket(EncoderDataPacket* packet)
     {
+        packetLog.writePacket(logTimestamp(), *packet);
         EncPacket = *packet;
         newEncoderPacket = true;
     }
@@ -95,6 +107,20 @@ public:
             ImGui::SameLine();
             if (ImGui::Button("Clear")) historyBuffer.clear();
 
+            ImGui::Separator();
+
+            ImGui::InputText("Log Name", logName, sizeof(logName));
+            if (!packetLog.isOpen())
+            {
+                if (ImGui::Button("Record")) packetLog.open(std::string(logName) + ".p3log", anchors, logTimestamp());
+            }
+            else
+            {
+                if (ImGui::Button("Stop Recording")) packetLog.close();
+                ImGui::SameLine();
+                ImGui::Text("%zu records", packetLog.recordCount());
+            }
+
             ImGui::Separator();
             
             static bool encEnable = false;
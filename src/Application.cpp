@@ -3,27 +3,42 @@
 // Constructor: Initializes the application, UI windows, and default settings
 Application::Application() : 
     m_WorldGrid({0, 0}, {DEFAULT_GRID_SIZE, DEFAULT_GRID_SIZE}), 
-    m_Landmarks(DEFAULT_LANDMARK_A_POS, DEFAULT_LANDMARK_B_POS), 
+    m_OccupancyGrid({0, 0}, {DEFAULT_GRID_SIZE, DEFAULT_GRID_SIZE}),
+    m_GridPlanner(m_OccupancyGrid),
     m_KalmanFilter(KF_DEFAULT_POS, KF_DEFAULT_Q, KF_DEFAULT_R),
+    m_HypothesisBank(KF_DEFAULT_Q),
+    m_AnchorCalibrator(KF_DEFAULT_Q),
     m_FrameTBuffer(FPS_BUFFER_SIZE)
 {
     // Initialize UI windows
     m_infoBar = std::make_shared<InfoBar>(m_RobotSerial, m_AvgFrameTime);
-    m_SerialMonitor = std::make_shared<SerialMonitor>(m_RobotSerial);
+    m_SerialMonitor = std::make_shared<SerialMonitor>(m_RobotSerial, m_Landmarks.getAnchors());
     m_ControlPanel = std::make_shared<BotControlWindow>(m_RobotSerial);
     m_GraphWindow = std::make_shared<GraphWindow>(m_FrameTBuffer, m_AvgFrameTime);
-    m_ConfigWindow = std::make_shared<ConfigWindow>(m_WorldGrid, m_Landmarks, m_KalmanFilter, m_PathController);
+    m_ConfigWindow = std::make_shared<ConfigWindow>(m_WorldGrid, m_Landmarks, m_KalmanFilter, m_RangeQuality, m_AnchorCalibrator, m_OdometryCalibrator, m_LatencyCompensator, m_LagSmoother, m_PoseGraph, m_HypothesisBank, m_PathController, m_OccupancyGrid, m_GridPlanner, m_ControlExecutor, m_Geofence, m_PathRecorder);
 
     // Add UI windows to the rendering order
+    m_ConfigWindow->resetPose = [this](const Eigen::Vector3d& pose, const Eigen::Matrix3d& P) { m_ResetPose(pose, P); };
     m_UIwindows.push_back(m_ConfigWindow);
     m_UIwindows.push_back(m_SerialMonitor);
     m_UIwindows.push_back(m_ControlPanel);
     m_UIwindows.push_back(m_infoBar);
     m_UIwindows.push_back(m_GraphWindow);
 
-    // Set default viewport zoom and Kalman filter anchors
+    // Set default viewport zoom, landmarks and Kalman filter anchors
     m_ViewPort.GetCamera().setScale(DEFAULT_VIEWPORT_ZOOM);
-    m_KalmanFilter.setAnchors(DEFAULT_LANDMARK_A_POS, DEFAULT_LANDMARK_B_POS);
+    m_Landmarks.AddLandmark(DEFAULT_LANDMARK_A_POS, DEFAULT_LANDMARK_A_SCALE, DEFAULT_LANDMARK_A_BIAS);
+    m_Landmarks.AddLandmark(DEFAULT_LANDMARK_B_POS, DEFAULT_LANDMARK_B_SCALE, DEFAULT_LANDMARK_B_BIAS);
+    m_KalmanFilter.setAnchors(m_Landmarks.getAnchors());
+    m_Geofence.addZone({{-DEFAULT_GRID_SIZE / 2.0, -DEFAULT_GRID_SIZE / 2.0}, {DEFAULT_GRID_SIZE / 2.0, -DEFAULT_GRID_SIZE / 2.0},
+        {DEFAULT_GRID_SIZE / 2.0, DEFAULT_GRID_SIZE / 2.0}, {-DEFAULT_GRID_SIZE / 2.0, DEFAULT_GRID_SIZE / 2.0}}, false);
+    m_RangeQuality.load(RQ_DEFAULT_FILE);
+
+    FilterTuning tuning;
+    if (tuning.load(TUNING_DEFAULT_FILE)) tuning.applyTo(m_KalmanFilter);
+
+    m_PathController.mpc.tickPeriod = 1.0 / CONTROL_FREQ_HZ;
+    m_ControlExecutor.start(CONTROL_FREQ_HZ, [this](double now) { m_ControlTick(now); });
 
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "APP INFO: Application initialized\n");
 }
@@ -46,15 +61,64 @@ void Application::OnEvent(SDL_Event* event)
         delete event->user.data1; // Free the memory allocated for the packet
 
         // Landmark Container processes the landmark data
-        m_Landmarks.OnNewPacket(&landmarkData);
+        bool bValidRange = m_Landmarks.OnNewPacket(&landmarkData, SDL_GetTicks() / 1000.0);
         m_SerialMonitor->OnNewLandmarkPacket(&landmarkData);
+
+        // The calibrator works on raw ranges so it sees the scale and bias
+        if (m_AnchorCalibrator.bEnabled && landmarkData.range > 0 && landmarkData.range < LANDMARK_MAX_RANGE)
+        {
+            m_AnchorCalibrator.updateRange(AnchorTable::indexFromId(landmarkData.LandmarkID), landmarkData.range);
+        }
     
         // Update the Kalman filter with the corrected landmark data
-        m_KalmanFilter.updateLandmark(
-            landmarkData.LandmarkID, 
-            m_Landmarks.getLandmarkPos(landmarkData.LandmarkID), 
-            m_Landmarks.getLandmarkRange(landmarkData.LandmarkID)
-        );
+        if (bValidRange)
+        {
+            int landmark = AnchorTable::indexFromId(landmarkData.LandmarkID);
+            Eigen::Vector2d landmarkPos = m_Landmarks.getLandmarkPos(landmark);
+            double range = m_Landmarks.getLandmarkRange(landmark);
+
+            // Weight the range by its received power, NLOS ranges are skipped
+            double residual = range - (m_KalmanFilter.x.head<2>() - landmarkPos).norm();
+            RangeQuality quality = m_RangeQuality.assess(landmark, landmarkData.rxPower, residual);
+
+            bool bAccepted = false;
+            if (!m_RangeQuality.bEnabled)
+            {
+                bAccepted = m_KalmanFilter.updateLandmark(landmark, landmarkPos, range);
+            }
+            else if (!quality.bNlos)
+            {
+                bAccepted = m_KalmanFilter.updateLandmark(landmark, landmarkPos, range, quality.variance);
+            }
+            if (bAccepted)
+            {
+                m_LagSmoother.addUpdate(m_KalmanFilter);
+                if (m_PoseGraph.isRunning()) m_PoseGraph.addRange(landmarkPos, range, m_RangeQuality.bEnabled ? quality.variance : m_KalmanFilter.measurementNoise);
+            }
+
+            if (m_OdometryCalibrator.bEnabled) m_OdometryCalibrator.updateRange(landmarkPos, range);
+
+            // Localise from the hypothesis bank until one side of the mirror wins
+            if (m_HypothesisBank.bEnabled && (!m_RangeQuality.bEnabled || !quality.bNlos))
+            {
+                if (!m_HypothesisBank.isSeeded())
+                {
+                    m_HypothesisBank.seed(m_Landmarks.getFix());
+                }
+                else
+                {
+                    m_HypothesisBank.updateRange(landmarkPos, range);
+                }
+
+                if (m_HypothesisBank.isConverged())
+                {
+                    int best = m_HypothesisBank.best();
+                    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "MHT INFO: Localised at (%.3f, %.3f, %.2f) after %zu ranges\n",
+                        m_HypothesisBank.X(0, best), m_HypothesisBank.X(1, best), m_HypothesisBank.X(2, best), m_HypothesisBank.updateCount);
+                    m_ResetPose(m_HypothesisBank.pose(best), m_HypothesisBank.covariance(best));
+                }
+            }
+        }
     }
     // Handle serial encoder event
     else if (event->type == SDL_EVENT_USER && event->user.code == SERIAL_ENCODER_EVENT)
@@ -63,7 +127,17 @@ void Application::OnEvent(SDL_Event* event)
         delete event->user.data1; // Free the memory allocated for the packet
 
         m_SerialMonitor->OnNewEncoderPacket(&encoderData);
-        m_KalmanFilter.predict({encoderData.encA, encoderData.encB}, ImGui::GetIO().DeltaTime);
+
+        // Timestamp the packet when it finished arriving, the wait in the event queue is part of the inbound delay
+        double rxTime = event->user.timestamp / 1e9 - m_RobotSerial.TransmissionTime(sizeof(EncoderDataPacket));
+        m_LatencyCompensator.inboundDelay.add(SDL_GetTicksNS() / 1e9 - rxTime);
+        m_KalmanFilter.onEncoderPacket(encoderData, rxTime);
+        m_LagSmoother.addPrediction(rxTime, m_KalmanFilter);
+        m_PathRecorder.addPose(m_KalmanFilter.x);
+        if (m_HypothesisBank.bEnabled) m_HypothesisBank.predict({encoderData.encA, encoderData.encB});
+        if (m_PoseGraph.isRunning()) m_PoseGraph.addOdometry(rxTime, {encoderData.encA, encoderData.encB}, m_KalmanFilter.x, m_KalmanFilter.P);
+        if (m_AnchorCalibrator.bEnabled) m_AnchorCalibrator.predict({encoderData.encA, encoderData.encB}, ImGui::GetIO().DeltaTime);
+        if (m_OdometryCalibrator.bEnabled) m_OdometryCalibrator.predict({encoderData.encA, encoderData.encB});
     }
 }
 
@@ -97,49 +171,56 @@ void Application::Update()
     // Handle viewport input (camera and interaction)
     m_HandleViewportInput();
 
-    // Update robot control logic
-    Eigen::Vector2d mousePosWorld = m_ViewPort.GetCamera().transform.inverse() * m_ViewPort.GetViewPortMousePos();
-    static Eigen::Vector2d currentGoal = {0, -0.5}; 
+    // Rebuild the spline and speeds after any edit, off the control thread
+    m_PathController.update();
+
     static bool bStopped = false;
 
-    // Check if the robot has reached the current goal
-    if ((m_KalmanFilter.x.head(2) - currentGoal).norm() < 0.05)
+    // Fuse the pose graph estimate of its newest node as a pose measurement
+    Eigen::Vector3d graphCorrection;
+    Eigen::Matrix3d graphCovariance;
+    if (m_PoseGraph.popCorrection(graphCorrection, graphCovariance))
     {
-        currentGoal = m_PathController.getNextWaypoint();    
+        m_KalmanFilter.updatePose(graphCorrection, graphCovariance);
     }
 
+    // Pose predicted to now rather than the pose at the last encoder packet
+    double now = SDL_GetTicksNS() / 1e9;
+    Eigen::Vector3d currentPose = m_KalmanFilter.currentPose(now);
+
+    m_PathController.bShowLookahead = m_ControlPanel->controlMode == PURSUIT;
+
+    // Repair the obstacle aware plan from where the robot is now
+    m_GridPlanner.update(currentPose.head<2>());
+
     // Toggle robot movement
     if (ImGui::IsKeyPressed(ImGuiKey_Space, false))
     {
         bStopped = !bStopped;
     }
 
-    // Update robot serial commands
-    static Uint64 lastControl = SDL_GetTicks();
-    if (((SDL_GetTicks() - lastControl) > 1000 / CONTROL_FREQ_HZ) && !bStopped)
-    {
-        if (m_ControlPanel->controlMode == WAYPOINT)
-        {
-            Eigen::Vector2d wheelVels = m_PathController.wheelVelFromGoal(m_KalmanFilter.x, currentGoal);
-            m_RobotSerial.SetCommandVel(static_cast<float>(wheelVels[0]), static_cast<float>(wheelVels[1]));
-        }
-        lastControl = SDL_GetTicks();
-    }
-    
-    else if (bStopped)
-    {
-        m_RobotSerial.SetCommandVel(0, 0);
-    }
+    // Hand the newest estimate to the control thread, it predicts on from here to each tick
+    ControlSnapshot snapshot;
+    Eigen::Map<Eigen::Vector3d>(snapshot.pose) = m_KalmanFilter.x;
+    Eigen::Map<Eigen::Vector2d>(snapshot.velocity) = m_KalmanFilter.velocity;
+    snapshot.packetTime = m_KalmanFilter.lastPacketTime;
+    snapshot.mode = m_ControlPanel->controlMode;
+    snapshot.manualCommand[0] = m_ControlPanel->manualCommand[0];
+    snapshot.manualCommand[1] = m_ControlPanel->manualCommand[1];
+    snapshot.bStopped = bStopped;
+    m_ControlSnapshot.store(snapshot);
 
     // Update graphs with Kalman filter data
     static Uint64 lastGraphSample = SDL_GetTicks();
     if ((SDL_GetTicks() - lastGraphSample) > 1000 / GRAPH_FREQ_HZ)
     {
-        double kRangeA = (m_KalmanFilter.x.head(2) - m_Landmarks.getLandmarkPos('A')).norm();
-        double kRangeB = (m_KalmanFilter.x.head(2) - m_Landmarks.getLandmarkPos('B')).norm();
+        AnchorTable& anchors = m_Landmarks.getAnchors();
+        Eigen::VectorXd kalmanRanges = anchors.predictRanges(m_KalmanFilter.x.head(2));
+        Eigen::Map<const Eigen::VectorXd> measuredRanges(anchors.range.data(), static_cast<Eigen::Index>(anchors.size()));
 
-        m_GraphWindow->addRangeData({m_Landmarks.getLandmarkRange('A'), m_Landmarks.getLandmarkRange('B')}, {kRangeA, kRangeB});
+        m_GraphWindow->addRangeData(measuredRanges, kalmanRanges);
         m_GraphWindow->addKalmanData(m_KalmanFilter.K, m_KalmanFilter.P);
+        if (m_LagSmoother.hasEstimate()) m_GraphWindow->addPoseData(now, currentPose, m_LagSmoother.laggedTime(), m_LagSmoother.laggedPose());
 
         m_CalcFrameTime();
         lastGraphSample = SDL_GetTicks();
@@ -152,12 +233,83 @@ void Application::Update()
     }
 }
 
+// Moves the live filter to a new pose, everything that tracked the old trajectory starts again from it
+void Application::m_ResetPose(const Eigen::Vector3d& pose, const Eigen::Matrix3d& P)
+{
+    m_KalmanFilter.setPoseEstimate(pose);
+    m_KalmanFilter.P = P;
+    m_LagSmoother.clear();
+    m_PoseGraph.clear();
+    m_HypothesisBank.bEnabled = false;
+    m_HypothesisBank.reset();
+}
+
+// Runs on the control thread at CONTROL_FREQ_HZ, whatever the frame rate
+void Application::m_ControlTick(double now)
+{
+    ControlSnapshot snapshot = m_ControlSnapshot.load();
+    std::lock_guard<std::mutex> lock(m_PathController.mutex);
+
+    double commandDelay;
+    if (m_RobotSerial.PopCommandDelay(commandDelay)) m_LatencyCompensator.outboundDelay.add(commandDelay);
+
+    // Drive the filter pose on through the commands sent since its packet, to now and to when this command acts
+    Eigen::Vector3d pose = Eigen::Map<const Eigen::Vector3d>(snapshot.pose);
+    Eigen::Vector2d velocity = Eigen::Map<const Eigen::Vector2d>(snapshot.velocity);
+    Eigen::Vector3d currentPose = pose;
+    Eigen::Vector3d controlPose = pose;
+    if (snapshot.packetTime >= 0)
+    {
+        currentPose = m_LatencyCompensator.predict(pose, velocity, snapshot.packetTime, now);
+        if (m_LatencyCompensator.bEnabled) controlPose = m_LatencyCompensator.predict(pose, velocity, snapshot.packetTime, m_LatencyCompensator.applyTime(now));
+        else controlPose = currentPose;
+    }
+
+    // Check if the robot has reached the current goal
+    if ((currentPose.head<2>() - m_CurrentGoal).norm() < 0.05)
+    {
+        m_CurrentGoal = m_PathController.getNextWaypoint();
+    }
+
+    if (snapshot.bStopped)
+    {
+        m_RobotSerial.SetCommandVel(0, 0);
+        m_LatencyCompensator.addCommand(now, 0, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> fenceLock(m_Geofence.mutex);
+    const KinematicParams& kinematics = *m_Geofence.kinematics;
+    bool bWasViolating = m_Geofence.bViolating;
+
+    ControlMode_t controlMode = snapshot.mode;
+    if (controlMode == MOUSE) return;
+
+    // Manual keys go through the same fence check as the followers
+    Eigen::Vector2d wheelVels;
+    if (controlMode == MANUAL) wheelVels = Eigen::Map<const Eigen::Vector2d>(snapshot.manualCommand);
+    else if (controlMode == PURSUIT) wheelVels = m_PathController.wheelVelPurePursuit(controlPose);
+    else if (controlMode == MPC) wheelVels = m_PathController.wheelVelMpc(controlPose);
+    else wheelVels = m_PathController.wheelVelFromGoal(controlPose, m_CurrentGoal);
+
+    // Hold the command over the horizon from where it takes effect, anything that leaves the fence becomes a stop
+    if (m_Geofence.bEnabled && !m_Geofence.isMotionAllowed(controlPose, wheelVels[0] * kinematics.wheelRadiusL, wheelVels[1] * kinematics.wheelRadiusR))
+    {
+        wheelVels.setZero();
+        if (!bWasViolating) SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GEOFENCE INFO: Stopped at (%.3f, %.3f)\n", controlPose.x(), controlPose.y());
+    }
+    m_RobotSerial.SetCommandVel(static_cast<float>(wheelVels[0]), static_cast<float>(wheelVels[1]));
+    m_LatencyCompensator.addCommand(now, wheelVels[0], wheelVels[1]);
+}
+
 // Handles viewport input for camera controls and waypoint editing
 void Application::m_HandleViewportInput()
 {
     m_ViewPort.ViewPortBegin();
     {
+        // Only the main thread edits the path, so hovering reads it unlocked and the lock covers the edits
         Eigen::Vector2d mousePosWorld = m_ViewPort.GetCamera().transform.inverse() * m_ViewPort.GetViewPortMousePos();
+        m_PathController.setMousePos(mousePosWorld);
 
         if (ImGui::IsWindowHovered())
         {
@@ -180,32 +332,68 @@ void Application::m_HandleViewportInput()
             // Kalman filter controls
             if (ImGui::IsKeyDown(ImGuiKey_LeftShift) && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
             {
-                m_KalmanFilter.setPoseEstimate({mousePosWorld.x(), mousePosWorld.y(), 0});
-                m_KalmanFilter.P = Eigen::Matrix3d::Identity();
+                m_ResetPose({mousePosWorld.x(), mousePosWorld.y(), 0}, Eigen::Matrix3d::Identity());
             }
             
-            // Waypoint editing 
+            // Obstacle editing, left paints and right erases
+            if (m_OccupancyGrid.bEditing && !ImGui::IsKeyDown(ImGuiKey_LeftShift) && !ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && !ImGui::IsKeyDown(ImGuiKey_LeftAlt))
+            {
+                if (ImGui::IsMouseDown(ImGuiMouseButton_Left))
+                {
+                    m_GridPlanner.onGridChanged(m_OccupancyGrid.paint(mousePosWorld, m_OccupancyGrid.brushRadius, true));
+                }
+                else if (ImGui::IsMouseDown(ImGuiMouseButton_Right))
+                {
+                    m_GridPlanner.onGridChanged(m_OccupancyGrid.paint(mousePosWorld, m_OccupancyGrid.brushRadius, false));
+                }
+            }
+
+            // Planner goal
+            if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
+            {
+                m_GridPlanner.setGoal(mousePosWorld);
+            }
+
+            // Zone editing, left adds a vertex and right closes the outline or removes the zone under the mouse
+            if (m_Geofence.bEditing && !ImGui::IsKeyDown(ImGuiKey_LeftShift) && !ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && !ImGui::IsKeyDown(ImGuiKey_LeftAlt))
+            {
+                std::lock_guard<std::mutex> fenceLock(m_Geofence.mutex);
+                if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+                {
+                    m_Geofence.addPendingVertex(mousePosWorld);
+                }
+                else if (ImGui::IsMouseClicked(ImGuiMouseButton_Right))
+                {
+                    if (m_Geofence.pendingCount() > 0) m_Geofence.closePending();
+                    else m_Geofence.removeZoneAt(mousePosWorld);
+                }
+            }
+
+            // Waypoint editing, waypoints the robot could not reach inside the fence are refused
+            bool bWaypointAllowed = true;
+            if (m_Geofence.bEnabled)
+            {
+                std::lock_guard<std::mutex> fenceLock(m_Geofence.mutex);
+                bWaypointAllowed = m_Geofence.isDiscAllowed(mousePosWorld, m_Geofence.robotRadius);
+            }
+
             if (ImGui::IsKeyDown(ImGuiKey_LeftShift) && ImGui::IsMouseClicked(ImGuiMouseButton_Left, true))
             {
-                m_PathController.addWaypoint(mousePosWorld);
+                std::lock_guard<std::mutex> lock(m_PathController.mutex);
+                if (bWaypointAllowed) m_PathController.addWaypoint(mousePosWorld);
             }
 
             else if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) & ImGui::IsMouseClicked(ImGuiMouseButton_Left))
             {
+                std::lock_guard<std::mutex> lock(m_PathController.mutex);
                 m_PathController.removeWaypointNear(mousePosWorld);
             }
 
             // Move nearest waypoint to mouse position
-            else if (ImGui::IsKeyDown(ImGuiKey_LeftAlt) && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
+            else if (ImGui::IsKeyDown(ImGuiKey_LeftAlt) && ImGui::IsMouseDragging(ImGuiMouseButton_Left) && bWaypointAllowed)
             {
-                for (int i = 0; i < m_PathController.waypoints.size(); i++)
-                {
-                    if (m_PathController.isMouseOverWaypoint(m_PathController.waypoints[i]))
-                    {
-                        m_PathController.moveWaypoint(i, mousePosWorld);
-                        break;
-                    }
-                }
+                std::lock_guard<std::mutex> lock(m_PathController.mutex);
+                m_PathController.moveWaypoint(m_PathController.hoveredWaypoint(), mousePosWorld);
             }
         }
     }
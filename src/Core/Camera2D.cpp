@@ -71,3 +71,16 @@ void Camera2D::updateTransform()
     transform.rotate(-rotation);
     transform.translate(-this->position);  // Apply the translation 
 }
+
+Eigen::AlignedBox2d Camera2D::getVisibleBox(double margin) const
+{
+    Eigen::Affine2d screenToWorld = transform.inverse();
+    Eigen::AlignedBox2d box;
+    box.extend(screenToWorld * Eigen::Vector2d(0, 0));
+    box.extend(screenToWorld * Eigen::Vector2d(screenSize.x(), 0));
+    box.extend(screenToWorld * Eigen::Vector2d(0, screenSize.y()));
+    box.extend(screenToWorld * screenSize);
+    box.min().array() -= margin;
+    box.max().array() += margin;
+    return box;
+}
@@ -0,0 +1,134 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include "AnchorCalibrator.hpp"
+#include "DiffDriveModel.hpp"
+
+AnchorCalibrator::AnchorCalibrator(double processNoise, double measurementNoise)
+{
+    this->processNoise = processNoise;
+    this->measurementNoise = measurementNoise;
+
+    x = Eigen::VectorXd::Zero(3);
+    P = Eigen::MatrixXd::Identity(3, 3);
+}
+
+void AnchorCalibrator::reset(const Eigen::Vector3d& pose, const Eigen::Matrix3d& poseCovariance, const AnchorTable& anchors)
+{
+    const Eigen::Index n = 3 + ANCHOR_CAL_STATES * static_cast<Eigen::Index>(anchors.size());
+    x.resize(n);
+    P.setZero(n, n);
+
+    x.head<3>() = pose;
+    P.topLeftCorner<3, 3>() = poseCovariance;
+
+    for (int i = 0; i < static_cast<int>(anchors.size()); i++)
+    {
+        x.segment<ANCHOR_CAL_STATES>(anchorOffset(i)) << anchors.x[i], anchors.y[i], anchors.scale[i], anchors.bias[i];
+        releaseAnchor(i);
+    }
+
+    acceptedCount = 0;
+    rejectedCount = 0;
+}
+
+void AnchorCalibrator::releaseAnchor(int anchor)
+{
+    if (anchor < 0 || anchor >= anchorCount()) return;
+
+    const int offset = anchorOffset(anchor);
+    P.middleRows(offset, ANCHOR_CAL_STATES).setZero();
+    P.middleCols(offset, ANCHOR_CAL_STATES).setZero();
+    P.block<ANCHOR_CAL_STATES, ANCHOR_CAL_STATES>(offset, offset).diagonal() <<
+        ANCHOR_CAL_POS_STDDEV * ANCHOR_CAL_POS_STDDEV,
+        ANCHOR_CAL_POS_STDDEV * ANCHOR_CAL_POS_STDDEV,
+        ANCHOR_CAL_SCALE_STDDEV * ANCHOR_CAL_SCALE_STDDEV,
+        ANCHOR_CAL_BIAS_STDDEV * ANCHOR_CAL_BIAS_STDDEV;
+}
+
+// Only the pose moves, so only the pose rows and columns of P change
+void AnchorCalibrator::predict(const Eigen::Vector2d& U, double dt)
+{
+    const double chassisWidth = kinematics->trackWidth;
+
+    double dL = (U[0] - encoderA) * kinematics->wheelRadiusL;
+    double dR = (U[1] - encoderB) * kinematics->wheelRadiusR;
+    encoderA = static_cast<float>(U[0]);
+    encoderB = static_cast<float>(U[1]);
+
+    Eigen::Vector3d pose = x.head<3>();
+    Eigen::Matrix3d F = DiffDriveModel::motionJacobian(pose, dL, dR, chassisWidth);
+    x.head<3>() = DiffDriveModel::motion(pose, dL, dR, chassisWidth);
+
+    Eigen::Matrix3d Q = Eigen::Matrix3d::Identity() * processNoise;
+    Q(2, 2) = 1e-4;
+
+    const Eigen::Index nAnchorStates = x.size() - 3;
+    P.topLeftCorner<3, 3>() = F * P.topLeftCorner<3, 3>() * F.transpose() + Q;
+    if (nAnchorStates > 0)
+    {
+        P.topRightCorner(3, nAnchorStates) = F * P.topRightCorner(3, nAnchorStates);
+        P.bottomLeftCorner(nAnchorStates, 3) = P.topRightCorner(3, nAnchorStates).transpose();
+        P.diagonal().tail(nAnchorStates).array() += anchorProcessNoise;
+    }
+}
+
+// Raw range model: rawRange = (|pos - anchor| - bias) / scale
+bool AnchorCalibrator::updateRange(int anchor, double rawRange)
+{
+    if (anchor < 0 || anchor >= anchorCount()) return false;
+
+    const int offset = anchorOffset(anchor);
+    const double scale = std::max(anchorScale(anchor), 1e-3);
+    const double bias = anchorBias(anchor);
+
+    Eigen::Vector2d delta = x.head<2>() - anchorPos(anchor);
+    double distance = std::max(delta.norm(), ANCHOR_MIN_RANGE);
+    Eigen::Vector2d direction = delta / distance;
+
+    // Non zero entries of H, pose x/y then anchor x/y, scale, bias
+    Eigen::Vector2d H_pos = direction / scale;
+    Eigen::Vector4d H_anchor(-direction.x() / scale, -direction.y() / scale, -(distance - bias) / (scale * scale), -1.0 / scale);
+
+    Eigen::VectorXd PHt = P.leftCols<2>() * H_pos + P.middleCols<ANCHOR_CAL_STATES>(offset) * H_anchor;
+    double HPHt = H_pos.dot(PHt.head<2>()) + H_anchor.dot(PHt.segment<ANCHOR_CAL_STATES>(offset));
+
+    // measurementNoise is the variance of a corrected range, scale it back to a raw range
+    double S = HPHt + measurementNoise / (scale * scale);
+    double innovation = rawRange - (distance - bias) / scale;
+
+    if (innovation * innovation / S > gateThreshold)
+    {
+        rejectedCount++;
+        return false;
+    }
+
+    x += PHt * (innovation / S);
+    P -= PHt * PHt.transpose() / S;
+    acceptedCount++;
+    return true;
+}
+
+void AnchorCalibrator::applyTo(AnchorTable& anchors) const
+{
+    for (int i = 0; i < anchorCount() && anchors.isValid(i); i++)
+    {
+        anchors.setPosition(i, anchorPos(i));
+        anchors.scale[i] = anchorScale(i);
+        anchors.bias[i] = anchorBias(i);
+    }
+}
+
+void AnchorCalibrator::render()
+{
+    if (!bEnabled) return;
+
+    ViewPort& viewport = ViewPort::GetInstance();
+    for (int i = 0; i < anchorCount(); i++)
+    {
+        // Circle of twice the largest position std around each estimated anchor
+        double stdDev = sqrt(std::max(anchorCovariance(i).eigenvalues().real().maxCoeff(), 0.0));
+        viewport.RenderTexture(viewport.circleTexture, anchorPos(i), {4 * stdDev, 4 * stdDev}, 0, DARK_BLUE, 60);
+        viewport.RenderTexture(viewport.circleTexture, anchorPos(i), {0.05, 0.05}, 0, DARK_BLUE, SDL_ALPHA_OPAQUE);
+    }
+}
@@ -12,16 +12,13 @@ ConstPosKalmanFilter::ConstPosKalmanFilter(const Eigen::Vector2d initialState, d
 
     P.setIdentity();
     Q.setIdentity();
-    R.setIdentity();
 
     Q *= processNoise;
-    R *= measurementNoise;
 }
 
-void ConstPosKalmanFilter::setAnchors(const Eigen::Vector2d& anchorA, const Eigen::Vector2d& anchorB) 
+void ConstPosKalmanFilter::setAnchors(const AnchorTable& anchors) 
 {
-    this->anchorA = anchorA;
-    this->anchorB = anchorB;
+    this->anchors = anchors;
 }
 
 void ConstPosKalmanFilter::predict(const Eigen::Vector2d& U, double dt) 
@@ -31,34 +28,21 @@ void ConstPosKalmanFilter::predict(const Eigen::Vector2d& U, double dt)
     P = F * P * F.transpose() + Q;
 }
 
-void ConstPosKalmanFilter::update(const Eigen::Vector2d& measurement, double dt) 
+void ConstPosKalmanFilter::update(const Eigen::VectorXd& measurement, double dt) 
 {
-    // Measurement noise covariance matrix (2x2)
-    R.setIdentity();
-    R *= measurementNoise;
+    // Measurement noise covariance matrix (NxN)
+    const Eigen::Index n = static_cast<Eigen::Index>(anchors.size());
+    R = Eigen::MatrixXd::Identity(n, n) * measurementNoise;
 
-    // State vector (2x1)
-    double x_pos = x(0);
-    double y_pos = x(1);
+    // Expected measurement and Jacobian matrix (Nx2) for all anchors
+    Eigen::VectorXd predicted;
+    anchors.predictRanges(x, predicted, H);
 
-    // Expected measurement
-    double r_a = std::sqrt(std::pow(x_pos - anchorA(0), 2) + std::pow(y_pos - anchorA(1), 2));
-    double r_b = std::sqrt(std::pow(x_pos - anchorB(0), 2) + std::pow(y_pos - anchorB(1), 2));
-
-    // Jacobian matrix (2x2)
-    double d_rA_dx = (x_pos - anchorA(0)) / r_a;
-    double d_rA_dy = (y_pos - anchorA(1)) / r_a;
-    double d_rB_dx = (x_pos - anchorB(0)) / r_b;
-    double d_rB_dy = (y_pos - anchorB(1)) / r_b;
-
-    H << d_rA_dx, d_rA_dy,
-         d_rB_dx, d_rB_dy;
-
-    // Kalman gain (2x2)
+    // Kalman gain (2xN)
     K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
 
     // Update state estimate (2x1)
-    x = x + K * (measurement - h(x));
+    x = x + K * (measurement - predicted);
 
     // Update error covariance matrix (2x2)
     P = (Eigen::Matrix2d::Identity() - K * H) * P;
@@ -90,12 +74,7 @@ double& ConstPosKalmanFilter::GetMeasureNoiseRef()
     return measurementNoise;
 }
 
-Eigen::Vector2d ConstPosKalmanFilter::h(const Eigen::Vector2d& state) 
+Eigen::VectorXd ConstPosKalmanFilter::h(const Eigen::Vector2d& state) 
 {
-    double r_a = sqrt((state(0) - anchorA(0)) * (state(0) - anchorA(0)) + (state(1) - anchorA(1)) * (state(1) - anchorA(1)));
-    double r_b = sqrt((state(0) - anchorB(0)) * (state(0) - anchorB(0)) + (state(1) - anchorB(1)) * (state(1) - anchorB(1)));
-
-    Eigen::Vector2d measurement;
-    measurement << r_a, r_b;
-    return measurement;
-}
\ No newline at end of file
+    return anchors.predictRanges(state);
+}
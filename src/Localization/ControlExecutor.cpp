@@ -0,0 +1,181 @@
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include "ControlExecutor.hpp"
+#include "ConsistencyMonitor.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+// Sleeps until an absolute time on the monotonic clock
+class DeadlineTimer
+{
+public:
+    DeadlineTimer()
+    {
+#ifdef _WIN32
+        m_Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+    }
+
+    ~DeadlineTimer()
+    {
+#ifdef _WIN32
+        if (m_Timer) CloseHandle(m_Timer);
+#endif
+    }
+
+    static int64_t now()
+    {
+#ifdef _WIN32
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    }
+
+    void sleepUntil(int64_t deadline)
+    {
+#ifdef _WIN32
+        // Waitable timers only take a relative time against the monotonic clock, it is worked out from
+        // the deadline each time so the error does not build up
+        int64_t remaining = deadline - now();
+        if (remaining <= 0) return;
+        if (m_Timer)
+        {
+            LARGE_INTEGER due;
+            due.QuadPart = -std::max<int64_t>(remaining / 100, 1);
+            if (SetWaitableTimer(m_Timer, &due, 0, nullptr, nullptr, FALSE))
+            {
+                WaitForSingleObject(m_Timer, INFINITE);
+                return;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+#else
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(deadline / 1000000000);
+        ts.tv_nsec = static_cast<long>(deadline % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_Timer = nullptr;
+#endif
+};
+
+// Real time priority where the OS allows it, otherwise the thread carries on at normal priority
+static void raiseThreadPriority()
+{
+#ifdef _WIN32
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "CONTROL INFO: Running at normal priority\n");
+    }
+#else
+    sched_param param = {};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "CONTROL INFO: No permission for SCHED_FIFO, running at normal priority\n");
+    }
+#endif
+}
+
+ControlExecutor::~ControlExecutor()
+{
+    stop();
+}
+
+void ControlExecutor::start(double rateHz, Task task)
+{
+    stop();
+    if (rateHz <= 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "CONTROL ERROR: Invalid control rate %.1f Hz\n", rateHz);
+        return;
+    }
+
+    m_PeriodNs = static_cast<int64_t>(llround(1e9 / rateHz));
+    m_Task = std::move(task);
+    m_Stats.store(ControlStats());
+    m_RunThread = true;
+    m_Worker = new std::thread(&ControlExecutor::m_ControlTask, this);
+}
+
+void ControlExecutor::stop()
+{
+    m_RunThread = false;
+    if (m_Worker)
+    {
+        m_Worker->join();
+        delete m_Worker;
+        m_Worker = nullptr;
+    }
+}
+
+// runs in a separate thread, one task call per release
+void ControlExecutor::m_ControlTask()
+{
+    raiseThreadPriority();
+
+    DeadlineTimer timer;
+    RollingStat jitter(CTRL_STATS_WINDOW);
+    RollingStat exec(CTRL_STATS_WINDOW);
+    ControlStats stats;
+
+    int64_t deadline = DeadlineTimer::now() + m_PeriodNs;
+    while (m_RunThread)
+    {
+        timer.sleepUntil(deadline);
+        if (!m_RunThread) break;
+
+        int64_t wake = DeadlineTimer::now();
+        m_Task(SDL_GetTicksNS() / 1e9);
+        int64_t done = DeadlineTimer::now();
+
+        if (m_bResetStats.exchange(false))
+        {
+            jitter = RollingStat(CTRL_STATS_WINDOW);
+            exec = RollingStat(CTRL_STATS_WINDOW);
+            stats = ControlStats();
+        }
+
+        double wakeLate = (wake - deadline) / 1e3;
+        double execTime = (done - wake) / 1e3;
+        jitter.add(wakeLate);
+        exec.add(execTime);
+
+        stats.ticks++;
+        stats.meanJitter = jitter.mean();
+        stats.sdJitter = sqrt(jitter.variance());
+        stats.maxJitter = std::max(stats.maxJitter, wakeLate);
+        stats.meanExec = exec.mean();
+        stats.maxExec = std::max(stats.maxExec, execTime);
+
+        deadline += m_PeriodNs;
+        if (done > deadline)
+        {
+            int64_t missed = (done - deadline) / m_PeriodNs + 1;
+            stats.overruns += static_cast<uint64_t>(missed);
+            deadline += missed * m_PeriodNs;
+        }
+        m_Stats.store(stats);
+    }
+}
@@ -0,0 +1,296 @@
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <math.h>
+#include "Geofence.hpp"
+#include "DiffDriveModel.hpp"
+
+void Geofence::addZone(const std::vector<Eigen::Vector2d>& vertices, bool bKeepOut)
+{
+    if (vertices.size() < 3)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "GEOFENCE ERROR: A zone needs at least 3 vertices, got %zu\n", vertices.size());
+        return;
+    }
+    m_Zones.push_back({vertices, bKeepOut});
+    m_Rebuild();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GEOFENCE INFO: Added %s zone with %zu vertices\n", bKeepOut ? "keep out" : "keep in", vertices.size());
+}
+
+void Geofence::removeZoneAt(const Eigen::Vector2d& point)
+{
+    m_CastRay(point);
+    for (size_t zone = 0; zone < m_Zones.size(); zone++)
+    {
+        if (!m_Parity[zone]) continue;
+        m_Zones.erase(m_Zones.begin() + zone);
+        m_Rebuild();
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GEOFENCE INFO: Removed zone at %.2f, %.2f\n", point.x(), point.y());
+        return;
+    }
+}
+
+void Geofence::clear()
+{
+    m_Zones.clear();
+    m_Pending.clear();
+    m_Rebuild();
+}
+
+void Geofence::closePending()
+{
+    if (m_Pending.size() >= 3) addZone(m_Pending, bNewKeepOut);
+    m_Pending.clear();
+}
+
+void Geofence::m_Rebuild()
+{
+    m_Edges.clear();
+    for (size_t zone = 0; zone < m_Zones.size(); zone++)
+    {
+        const std::vector<Eigen::Vector2d>& vertices = m_Zones[zone].vertices;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            m_Edges.push_back({vertices[i], vertices[(i + 1) % vertices.size()], static_cast<int>(zone)});
+        }
+    }
+
+    m_Nodes.clear();
+    m_Parity.assign(m_Zones.size(), 0);
+    if (!m_Edges.empty()) m_BuildNode(0, static_cast<int>(m_Edges.size()));
+}
+
+// Median split on the longest side of the box of edge midpoints
+int Geofence::m_BuildNode(int first, int count)
+{
+    int index = static_cast<int>(m_Nodes.size());
+    m_Nodes.emplace_back();
+
+    Eigen::AlignedBox2d box, centres;
+    for (int i = first; i < first + count; i++)
+    {
+        box.extend(m_Edges[i].a);
+        box.extend(m_Edges[i].b);
+        centres.extend(0.5 * (m_Edges[i].a + m_Edges[i].b));
+    }
+    m_Nodes[index].box = box;
+
+    if (count <= GEOFENCE_LEAF_EDGES)
+    {
+        m_Nodes[index].first = first;
+        m_Nodes[index].count = count;
+        return index;
+    }
+
+    int axis = (centres.sizes().x() >= centres.sizes().y()) ? 0 : 1;
+    int half = count / 2;
+    std::nth_element(m_Edges.begin() + first, m_Edges.begin() + first + half, m_Edges.begin() + first + count,
+        [axis](const Edge& l, const Edge& r) { return (l.a[axis] + l.b[axis]) < (r.a[axis] + r.b[axis]); });
+
+    // Children are built after the push so the reference is taken again
+    int left = m_BuildNode(first, half);
+    int right = m_BuildNode(first + half, count - half);
+    m_Nodes[index].left = left;
+    m_Nodes[index].right = right;
+    return index;
+}
+
+bool Geofence::m_EdgeWithin(const Eigen::Vector2d& point, double radius)
+{
+    if (m_Nodes.empty()) return false;
+    const double radius2 = radius * radius;
+
+    m_Stack.clear();
+    m_Stack.push_back(0);
+    while (!m_Stack.empty())
+    {
+        const Node& node = m_Nodes[m_Stack.back()];
+        m_Stack.pop_back();
+        if (node.box.squaredExteriorDistance(point) > radius2) continue;
+
+        if (node.count == 0)
+        {
+            m_Stack.push_back(node.left);
+            m_Stack.push_back(node.right);
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; i++)
+        {
+            const Edge& edge = m_Edges[i];
+            Eigen::Vector2d ab = edge.b - edge.a;
+            double length2 = ab.squaredNorm();
+            double t = (length2 > 1e-18) ? std::clamp((point - edge.a).dot(ab) / length2, 0.0, 1.0) : 0.0;
+            if ((point - (edge.a + t * ab)).squaredNorm() <= radius2) return true;
+        }
+    }
+    return false;
+}
+
+// Distance to the closest edge of any zone, infinite without zones
+double Geofence::m_NearestEdge(const Eigen::Vector2d& point)
+{
+    double best2 = std::numeric_limits<double>::infinity();
+    if (m_Nodes.empty()) return best2;
+
+    m_Stack.clear();
+    m_Stack.push_back(0);
+    while (!m_Stack.empty())
+    {
+        const Node& node = m_Nodes[m_Stack.back()];
+        m_Stack.pop_back();
+        if (node.box.squaredExteriorDistance(point) >= best2) continue;
+
+        if (node.count == 0)
+        {
+            m_Stack.push_back(node.left);
+            m_Stack.push_back(node.right);
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; i++)
+        {
+            const Edge& edge = m_Edges[i];
+            Eigen::Vector2d ab = edge.b - edge.a;
+            double length2 = ab.squaredNorm();
+            double t = (length2 > 1e-18) ? std::clamp((point - edge.a).dot(ab) / length2, 0.0, 1.0) : 0.0;
+            best2 = std::min(best2, (point - (edge.a + t * ab)).squaredNorm());
+        }
+    }
+    return sqrt(best2);
+}
+
+double Geofence::m_Penetration(const Eigen::Vector2d& center)
+{
+    double distance = m_NearestEdge(center);
+    return isPointAllowed(center) ? robotRadius - distance : robotRadius + distance;
+}
+
+// Crossings of a ray towards +x, odd parity means inside that zone
+void Geofence::m_CastRay(const Eigen::Vector2d& point)
+{
+    std::fill(m_Parity.begin(), m_Parity.end(), 0);
+    if (m_Nodes.empty()) return;
+
+    m_Stack.clear();
+    m_Stack.push_back(0);
+    while (!m_Stack.empty())
+    {
+        const Node& node = m_Nodes[m_Stack.back()];
+        m_Stack.pop_back();
+        if (point.y() < node.box.min().y() || point.y() > node.box.max().y() || point.x() > node.box.max().x()) continue;
+
+        if (node.count == 0)
+        {
+            m_Stack.push_back(node.left);
+            m_Stack.push_back(node.right);
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; i++)
+        {
+            const Edge& edge = m_Edges[i];
+            if ((edge.a.y() > point.y()) == (edge.b.y() > point.y())) continue;
+            double x = edge.a.x() + (point.y() - edge.a.y()) * (edge.b.x() - edge.a.x()) / (edge.b.y() - edge.a.y());
+            if (point.x() < x) m_Parity[edge.zone] ^= 1;
+        }
+    }
+}
+
+bool Geofence::isPointAllowed(const Eigen::Vector2d& point)
+{
+    m_CastRay(point);
+
+    bool bHasKeepIn = false;
+    bool bInsideKeepIn = false;
+    for (size_t zone = 0; zone < m_Zones.size(); zone++)
+    {
+        if (m_Zones[zone].bKeepOut)
+        {
+            if (m_Parity[zone]) return false;
+        }
+        else
+        {
+            bHasKeepIn = true;
+            bInsideKeepIn |= m_Parity[zone] != 0;
+        }
+    }
+    return !bHasKeepIn || bInsideKeepIn;
+}
+
+bool Geofence::isDiscAllowed(const Eigen::Vector2d& center, double radius)
+{
+    return isPointAllowed(center) && !m_EdgeWithin(center, radius);
+}
+
+bool Geofence::isMotionAllowed(const Eigen::Vector3d& pose, double speedL, double speedR)
+{
+    auto start = std::chrono::steady_clock::now();
+    const double dt = horizon / GEOFENCE_STEPS;
+
+    bool bAllowed = true;
+    bool bOutside = !isDiscAllowed(pose.head<2>(), robotRadius);
+    double depth = bOutside ? m_Penetration(pose.head<2>()) : 0;
+    m_LastFootprints.clear();
+
+    Eigen::Vector3d predicted = pose;
+    for (int k = 1; k <= GEOFENCE_STEPS; k++)
+    {
+        predicted = DiffDriveModel::motion(predicted, speedL * dt, speedR * dt, kinematics->trackWidth);
+        m_LastFootprints.push_back(predicted.head<2>());
+
+        if (isDiscAllowed(predicted.head<2>(), robotRadius))
+        {
+            bOutside = false;
+            continue;
+        }
+
+        // From outside each footprint may be no deeper than the one before it
+        double next = bOutside ? m_Penetration(predicted.head<2>()) : 0;
+        if (!bOutside || next > depth + GEOFENCE_DEPTH_TOLERANCE)
+        {
+            bAllowed = false;
+            break;
+        }
+        depth = next;
+    }
+
+    if (!bAllowed && !bViolating) violations++;
+    bViolating = !bAllowed;
+    checkTime.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    return bAllowed;
+}
+
+void Geofence::render()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!bRender) return;
+    ViewPort& viewport = ViewPort::GetInstance();
+
+    for (const Zone& zone : m_Zones)
+    {
+        for (size_t i = 0; i < zone.vertices.size(); i++)
+        {
+            const Eigen::Vector2d& a = zone.vertices[i];
+            const Eigen::Vector2d& b = zone.vertices[(i + 1) % zone.vertices.size()];
+            if (zone.bKeepOut) viewport.RenderLineTexture(a, b, 0.02, RED, 200);
+            else viewport.RenderLineTexture(a, b, 0.02, GREEN, 200);
+        }
+    }
+
+    for (size_t i = 0; i < m_Pending.size(); i++)
+    {
+        viewport.RenderTexture(viewport.circleTexture, m_Pending[i], {0.03, 0.03}, 0, WHITE, 255);
+        if (i > 0) viewport.RenderLineTexture(m_Pending[i - 1], m_Pending[i], 0.01, WHITE, 200);
+    }
+
+    // Footprints of the motion that was stopped
+    if (bViolating)
+    {
+        for (const Eigen::Vector2d& footprint : m_LastFootprints)
+        {
+            viewport.RenderTexture(viewport.circleTexture, footprint, {2.0 * robotRadius, 2.0 * robotRadius}, 0, RED, 60);
+        }
+    }
+}
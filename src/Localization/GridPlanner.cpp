@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <math.h>
+#include "GridPlanner.hpp"
+
+static constexpr float INF = std::numeric_limits<float>::infinity();
+static constexpr float DIAGONAL = 1.41421356f;
+
+GridPlanner::GridPlanner(const OccupancyGrid& grid) : m_Grid(grid)
+{
+    reset();
+}
+
+void GridPlanner::reset()
+{
+    m_Width = m_Grid.width;
+    size_t cells = static_cast<size_t>(m_Grid.width) * m_Grid.height;
+    m_G.assign(cells, INF);
+    m_Rhs.assign(cells, INF);
+    m_bOpen.assign(cells, 0);
+    m_Open = {};
+
+    m_Km = 0;
+    m_RepairExpansions = 0;
+    m_Start = -1;
+    m_LastStart = -1;
+    path.clear();
+    bPathFound = false;
+    bSearching = false;
+
+    // The goal is the root of the search, it keeps rhs = 0
+    m_Goal = -1;
+    if (m_bGoalSet)
+    {
+        Eigen::Vector2i cell = m_Grid.cellAt(m_GoalPos);
+        if (m_Grid.inBounds(cell.x(), cell.y()))
+        {
+            m_Goal = m_Cell(cell.x(), cell.y());
+            m_Rhs[m_Goal] = 0;
+        }
+    }
+}
+
+void GridPlanner::setGoal(const Eigen::Vector2d& goal)
+{
+    Eigen::Vector2i cell = m_Grid.cellAt(goal);
+    if (!m_Grid.inBounds(cell.x(), cell.y()))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PLANNER ERROR: Goal %.2f, %.2f is off the map\n", goal.x(), goal.y());
+        return;
+    }
+
+    // Every cost to go is measured to the goal, so a new goal starts the search again
+    m_GoalPos = m_Grid.cellCenter(cell.x(), cell.y());
+    m_bGoalSet = true;
+    reset();
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PLANNER INFO: Goal set to %.2f, %.2f\n", m_GoalPos.x(), m_GoalPos.y());
+}
+
+void GridPlanner::onGridChanged(const GridRect& rect)
+{
+    if (rect.empty() || m_Start < 0) return;
+
+    // Edges touching a changed cell, including diagonals that now cut its corner, start one cell outside it
+    int x0 = std::max(rect.x0 - 1, 0), y0 = std::max(rect.y0 - 1, 0);
+    int x1 = std::min(rect.x1 + 1, m_Grid.width), y1 = std::min(rect.y1 + 1, m_Grid.height);
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = x0; x < x1; x++) m_UpdateVertex(m_Cell(x, y));
+    }
+    m_bPathStale = true;
+}
+
+void GridPlanner::update(const Eigen::Vector2d& start)
+{
+    if (!bEnabled || m_Goal < 0) return;
+    auto begin = std::chrono::steady_clock::now();
+    lastExpansions = 0;
+    lastPlanTime = 0;
+
+    Eigen::Vector2i cell = m_Grid.cellAt(start);
+    if (!m_Grid.inBounds(cell.x(), cell.y()))
+    {
+        path.clear();
+        bPathFound = false;
+        m_bPathStale = true;
+        return;
+    }
+
+    // Nothing can reach a blocked goal, skip the search rather than flood the map proving it
+    if (m_Grid.isBlocked(m_X(m_Goal), m_Y(m_Goal)))
+    {
+        path.clear();
+        bPathFound = false;
+        bSearching = false;
+        m_bPathStale = true;
+        return;
+    }
+
+    // Some edits, walls across the path near the robot, make the repair rise through most of the searched area.
+    // Past a share of what a search from scratch cost last time, starting again is the cheaper way to finish.
+    size_t restartAt = std::max(static_cast<size_t>(PLAN_RESTART_RATIO * m_FreshExpansions), static_cast<size_t>(maxExpansions));
+    if (!m_bFreshSearch && m_RepairExpansions > restartAt)
+    {
+        std::vector<Eigen::Vector2d> lastPath = std::move(path);
+        reset();
+        path = std::move(lastPath);
+        restarts++;
+    }
+
+    int newStart = m_Cell(cell.x(), cell.y());
+    if (m_Start < 0)
+    {
+        m_bFreshSearch = true;
+        m_Start = newStart;
+        m_LastStart = newStart;
+        m_Open.push({m_Key(m_Goal), m_Goal});
+        m_bOpen[m_Goal] = 1;
+        m_bPathStale = true;
+    }
+    else if (newStart != m_Start)
+    {
+        // Raising km keeps the keys already queued valid lower bounds for the new start
+        m_Km += m_Heuristic(m_LastStart, newStart);
+        m_LastStart = newStart;
+
+        // The start may leave a blocked cell, so its outgoing edges change with it
+        int oldStart = m_Start;
+        m_Start = newStart;
+        m_UpdateVertex(oldStart);
+        m_UpdateVertex(newStart);
+        m_bPathStale = true;
+    }
+
+    bSearching = !m_ComputeShortestPath();
+    m_RepairExpansions += lastExpansions;
+    m_bPathStale |= lastExpansions > 0;
+    if (!bSearching)
+    {
+        if (m_bFreshSearch) m_FreshExpansions = m_RepairExpansions;
+        m_RepairExpansions = 0;
+        m_bFreshSearch = false;
+
+        // The line of sight simplification is slow on a long path, an idle frame keeps the last one
+        if (m_bPathStale) m_ExtractPath();
+        m_bPathStale = false;
+    }
+
+    lastPlanTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+float GridPlanner::m_Heuristic(int a, int b) const
+{
+    float dx = static_cast<float>(abs(m_X(a) - m_X(b)));
+    float dy = static_cast<float>(abs(m_Y(a) - m_Y(b)));
+    return std::max(dx, dy) + (DIAGONAL - 1.0f) * std::min(dx, dy);
+}
+
+float GridPlanner::m_Cost(int from, int to) const
+{
+    int fx = m_X(from), fy = m_Y(from), tx = m_X(to), ty = m_Y(to);
+    if (m_Grid.isBlocked(tx, ty)) return INF;
+
+    // The robot can always drive out of the cell it is in
+    if (from == m_Start) return (fx != tx && fy != ty) ? DIAGONAL : 1.0f;
+    if (m_Grid.isBlocked(fx, fy)) return INF;
+
+    if (fx != tx && fy != ty)
+    {
+        if (m_Grid.isBlocked(tx, fy) || m_Grid.isBlocked(fx, ty)) return INF;
+        return DIAGONAL;
+    }
+    return 1.0f;
+}
+
+GridPlanner::Key GridPlanner::m_Key(int cell) const
+{
+    float m = std::min(m_G[cell], m_Rhs[cell]);
+    return {m + m_Heuristic(m_Start, cell) + m_Km, m};
+}
+
+// Cheapest move out of cell, reads the blocked state of the 3x3 block around it once
+float GridPlanner::m_BestSuccessor(int cell, int* best) const
+{
+    int x = m_X(cell), y = m_Y(cell);
+    bool blocked[3][3];
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++) blocked[dy + 1][dx + 1] = m_Grid.isBlocked(x + dx, y + dy);
+    }
+
+    // The robot can always drive out of the cell it is in
+    bool bStart = cell == m_Start;
+    if (blocked[1][1] && !bStart) return INF;
+
+    float bestCost = INF;
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            if ((dx == 0 && dy == 0) || blocked[dy + 1][dx + 1]) continue;
+
+            bool bDiagonal = dx != 0 && dy != 0;
+            if (bDiagonal && !bStart && (blocked[1][dx + 1] || blocked[dy + 1][1])) continue;
+
+            int next = m_Cell(x + dx, y + dy);
+            float cost = (bDiagonal ? DIAGONAL : 1.0f) + m_G[next];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                if (best) *best = next;
+            }
+        }
+    }
+    return bestCost;
+}
+
+void GridPlanner::m_UpdateVertex(int cell)
+{
+    if (cell != m_Goal) m_Rhs[cell] = m_BestSuccessor(cell, nullptr);
+    m_Requeue(cell);
+}
+
+void GridPlanner::m_Requeue(int cell)
+{
+    if (m_G[cell] != m_Rhs[cell])
+    {
+        m_Open.push({m_Key(cell), cell});
+        m_bOpen[cell] = 1;
+    }
+    else
+    {
+        m_bOpen[cell] = 0;
+    }
+}
+
+// Returns false if the expansion budget ran out before the start was settled
+bool GridPlanner::m_ComputeShortestPath()
+{
+    lastExpansions = 0;
+    while (!m_Open.empty())
+    {
+        Entry top = m_Open.top();
+        if (!m_bOpen[top.cell])
+        {
+            m_Open.pop();
+            continue;
+        }
+        if (!(top.key < m_Key(m_Start)) && m_Rhs[m_Start] == m_G[m_Start]) break;
+        if (lastExpansions >= static_cast<size_t>(maxExpansions)) return false;
+
+        m_Open.pop();
+        int u = top.cell;
+        Key key = m_Key(u);
+        if (top.key < key)
+        {
+            m_Open.push({key, u});
+            continue;
+        }
+
+        lastExpansions++;
+        if (m_G[u] > m_Rhs[u])
+        {
+            // Cost to go fell, neighbours can only improve by moving through u
+            m_G[u] = m_Rhs[u];
+            m_bOpen[u] = 0;
+            m_ForNeighbours(u, [&](int previous)
+            {
+                float cost = m_Cost(previous, u) + m_G[u];
+                if (previous != m_Goal && cost < m_Rhs[previous])
+                {
+                    m_Rhs[previous] = cost;
+                    m_Requeue(previous);
+                }
+            });
+        }
+        else
+        {
+            // Cost to go rose, only neighbours whose best move was through u need a full look
+            float oldG = m_G[u];
+            m_G[u] = INF;
+            m_ForNeighbours(u, [&](int previous)
+            {
+                if (previous != m_Goal && m_Rhs[previous] == m_Cost(previous, u) + oldG) m_UpdateVertex(previous);
+            });
+            m_UpdateVertex(u);
+        }
+    }
+    return true;
+}
+
+void GridPlanner::m_ExtractPath()
+{
+    path.clear();
+    bPathFound = false;
+    if (m_Rhs[m_Start] == INF) return;
+
+    // Walk downhill on cost to go
+    std::vector<int> cells = {m_Start};
+    int u = m_Start;
+    while (u != m_Goal && cells.size() < m_G.size())
+    {
+        int best = -1;
+        if (m_BestSuccessor(u, &best) == INF) return;
+        u = best;
+        cells.push_back(u);
+    }
+    if (u != m_Goal) return;
+
+    // Keep only the cells needed to see along the path
+    path.push_back(m_Grid.cellCenter(m_X(m_Start), m_Y(m_Start)));
+    size_t anchor = 0;
+    while (anchor + 1 < cells.size())
+    {
+        size_t next = anchor + 1;
+        while (next + 1 < cells.size() && next + 1 - anchor <= PLAN_MAX_SEGMENT && m_LineOfSight(cells[anchor], cells[next + 1])) next++;
+        path.push_back(m_Grid.cellCenter(m_X(cells[next]), m_Y(cells[next])));
+        anchor = next;
+    }
+    bPathFound = true;
+}
+
+bool GridPlanner::m_LineOfSight(int from, int to) const
+{
+    int fx = m_X(from), fy = m_Y(from);
+    int dx = m_X(to) - fx, dy = m_Y(to) - fy;
+    int steps = 2 * std::max(abs(dx), abs(dy));
+    for (int i = 1; i < steps; i++)
+    {
+        double t = static_cast<double>(i) / steps;
+        int x = static_cast<int>(lround(fx + t * dx));
+        int y = static_cast<int>(lround(fy + t * dy));
+        if (m_Grid.isBlocked(x, y)) return false;
+    }
+    return true;
+}
+
+void GridPlanner::render()
+{
+    if (!bRender || !bEnabled || m_Goal < 0) return;
+    ViewPort& viewport = ViewPort::GetInstance();
+
+    for (size_t i = 1; i < path.size(); i++)
+    {
+        viewport.RenderLineTexture(path[i - 1], path[i], 0.015, BLUE, 200);
+    }
+    viewport.RenderTexture(viewport.circleTexture, m_GoalPos, {0.06, 0.06}, 0, BLUE, 255);
+}
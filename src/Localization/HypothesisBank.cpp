@@ -0,0 +1,191 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include "HypothesisBank.hpp"
+#include "DiffDriveModel.hpp"
+
+HypothesisBank::HypothesisBank(double processNoise, double measurementNoise)
+    : processNoise(processNoise), measurementNoise(measurementNoise)
+{
+}
+
+void HypothesisBank::reset()
+{
+    X.resize(3, 0);
+    P.resize(9, 0);
+    logWeight.resize(0);
+    updateCount = 0;
+}
+
+void HypothesisBank::seed(const MultilaterationResult& fix)
+{
+    reset();
+    if (!fix.bValid) return;
+
+    const int positions = fix.bAmbiguous ? 2 : 1;
+    const int count = std::min(positions * MHT_HEADINGS, MHT_MAX_HYPOTHESES);
+    const double headingStdDev = M_PI / MHT_HEADINGS;
+
+    Eigen::Matrix3d P0 = Eigen::Matrix3d::Zero();
+    P0.topLeftCorner<2, 2>() = fix.covariance;
+    P0(2, 2) = headingStdDev * headingStdDev;
+
+    X.resize(3, count);
+    P.resize(9, count);
+    logWeight = Eigen::RowVectorXd::Zero(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        Eigen::Vector2d pos = (i / MHT_HEADINGS == 0) ? fix.pos : fix.mirrorPos;
+        double heading = -M_PI + 2.0 * M_PI * (i % MHT_HEADINGS) / MHT_HEADINGS;
+        X.col(i) << pos.x(), pos.y(), heading;
+        P.col(i) = Eigen::Map<const Eigen::Matrix<double, 9, 1>>(P0.data());
+    }
+}
+
+// Same odometry for every hypothesis, only the Jacobian differs through the heading
+void HypothesisBank::predict(const Eigen::Vector2d& U)
+{
+    double dL = (U[0] - encoderA) * kinematics->wheelRadiusL;
+    double dR = (U[1] - encoderB) * kinematics->wheelRadiusR;
+    encoderA = static_cast<float>(U[0]);
+    encoderB = static_cast<float>(U[1]);
+
+    if (!isSeeded()) return;
+
+    Eigen::Matrix3d Q = Eigen::Matrix3d::Identity() * processNoise;
+    Q(2, 2) = 1e-4;
+
+    for (int i = 0; i < size(); i++)
+    {
+        Eigen::Map<Eigen::Matrix3d> Pi(P.col(i).data());
+        Eigen::Matrix3d F = DiffDriveModel::motionJacobian(X.col(i), dL, dR, kinematics->trackWidth);
+        Pi = F * Pi * F.transpose() + Q;
+    }
+    DiffDriveModel::motionBatch<Eigen::Dynamic>(X, dL, dR, kinematics->trackWidth);
+}
+
+void HypothesisBank::updateRange(const Eigen::Vector2d& landmarkPos, double range)
+{
+    if (!isSeeded()) return;
+
+    Eigen::RowVectorXd predicted = DiffDriveModel::rangeBatch<Eigen::Dynamic>(X, landmarkPos);
+
+    for (int i = 0; i < size(); i++)
+    {
+        Eigen::Map<Eigen::Matrix3d> Pi(P.col(i).data());
+        double h = std::max(predicted(i), 1e-6);
+        Eigen::RowVector3d H((X(0, i) - landmarkPos.x()) / h, (X(1, i) - landmarkPos.y()) / h, 0);
+
+        Eigen::Vector3d PHt = Pi * H.transpose();
+        double S = H.dot(PHt) + measurementNoise;
+        double innovation = range - h;
+
+        // Gaussian log likelihood of the range under this hypothesis
+        logWeight(i) += -0.5 * (innovation * innovation / S + log(2.0 * M_PI * S));
+
+        Eigen::Vector3d K = PHt / S;
+        X.col(i) += K * innovation;
+        Pi = (Eigen::Matrix3d::Identity() - K * H) * Pi;
+    }
+
+    updateCount++;
+    m_Normalise();
+    m_PruneAndMerge();
+}
+
+void HypothesisBank::m_Normalise()
+{
+    if (logWeight.size() > 0) logWeight.array() -= logWeight.maxCoeff();
+}
+
+Eigen::RowVectorXd HypothesisBank::weights() const
+{
+    Eigen::RowVectorXd w = logWeight.array().exp();
+    double total = w.sum();
+    return (total > 0) ? Eigen::RowVectorXd(w / total) : w;
+}
+
+int HypothesisBank::best() const
+{
+    if (!isSeeded()) return -1;
+    Eigen::Index index;
+    logWeight.maxCoeff(&index);
+    return static_cast<int>(index);
+}
+
+bool HypothesisBank::isConverged() const
+{
+    if (!isSeeded() || updateCount < MHT_MIN_UPDATES) return false;
+    return weights()(best()) > MHT_CONFIDENCE;
+}
+
+void HypothesisBank::m_Remove(int i)
+{
+    int last = size() - 1;
+    if (i != last)
+    {
+        X.col(i) = X.col(last);
+        P.col(i) = P.col(last);
+        logWeight(i) = logWeight(last);
+    }
+    X.conservativeResize(3, last);
+    P.conservativeResize(9, last);
+    logWeight.conservativeResize(last);
+}
+
+void HypothesisBank::m_PruneAndMerge()
+{
+    Eigen::RowVectorXd w = weights();
+    for (int i = size() - 1; i >= 0 && size() > 1; i--)
+    {
+        if (w(i) < MHT_PRUNE_WEIGHT)
+        {
+            m_Remove(i);
+            w(i) = w(w.size() - 1);
+            w.conservativeResize(w.size() - 1);
+        }
+    }
+
+    // Moment matched merge of hypotheses that have converged onto the same pose
+    for (int i = 0; i < size(); i++)
+    {
+        for (int j = size() - 1; j > i; j--)
+        {
+            Eigen::Map<Eigen::Matrix3d> Pi(P.col(i).data());
+            Eigen::Map<const Eigen::Matrix3d> Pj(P.col(j).data());
+
+            Eigen::Vector3d delta = X.col(j) - X.col(i);
+            delta.z() = remainder(delta.z(), 2.0 * M_PI);
+            if (delta.dot((Pi + Pj).ldlt().solve(delta)) > MHT_MERGE_DISTANCE) continue;
+
+            double wi = exp(logWeight(i)), wj = exp(logWeight(j));
+            double a = wj / (wi + wj);
+
+            Eigen::Vector3d merged = X.col(i) + a * delta;
+            Eigen::Vector3d di = X.col(i) - merged;
+            Eigen::Vector3d dj = X.col(i) + delta - merged;
+            Pi = (1.0 - a) * (Eigen::Matrix3d(Pi) + di * di.transpose()) + a * (Pj + dj * dj.transpose());
+
+            // The spreads above use the unwrapped heading, the stored one is kept in [-pi, pi]
+            merged.z() = remainder(merged.z(), 2.0 * M_PI);
+            X.col(i) = merged;
+            logWeight(i) = log(wi + wj);
+            m_Remove(j);
+        }
+    }
+    m_Normalise();
+}
+
+void HypothesisBank::render()
+{
+    if (!bEnabled || !isSeeded()) return;
+
+    Eigen::RowVectorXd w = weights();
+    double size = kinematics->trackWidth;
+    for (int i = 0; i < this->size(); i++)
+    {
+        int alpha = 40 + static_cast<int>(200 * w(i));
+        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().robotTexture, X.col(i).head(2), {size, size}, -X(2, i) + M_PI_2, BLUE, alpha);
+    }
+}
@@ -0,0 +1,121 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "MpcController.hpp"
+
+MpcController::Reference MpcController::reference(const SplinePath& spline, const VelocityProfile& profile, size_t progress) const
+{
+    Reference ref;
+    const double halfWidth = kinematics->trackWidth / 2.0;
+    const double step = SPLINE_SAMPLE_SPACING;
+
+    double s = spline.distance[progress];
+    double previousHeading = 0;
+    for (int k = 0; k <= N; k++)
+    {
+        Eigen::Vector2d tangent = spline.pointAt(s + step) - spline.pointAt(s - step);
+        double heading = atan2(tangent.y(), tangent.x());
+        if (k > 0) heading = previousHeading + remainder(heading - previousHeading, 2.0 * M_PI);
+        previousHeading = heading;
+
+        ref.pose.col(k) << spline.pointAt(s), heading;
+        if (k == N) break;
+
+        ref.speed(k) = profile.speedAt(spline.sampleAt(s));
+        s += ref.speed(k) * MPC_DT;
+    }
+
+    for (int k = 0; k < N; k++)
+    {
+        double omega = (ref.pose(2, k + 1) - ref.pose(2, k)) / MPC_DT;
+        ref.wheel.col(k) << ref.speed(k) - halfWidth * omega, ref.speed(k) + halfWidth * omega;
+    }
+    return ref;
+}
+
+Eigen::Vector2d MpcController::solve(const Eigen::Vector3d& state, const Reference& ref)
+{
+    auto start = std::chrono::steady_clock::now();
+    const double width = kinematics->trackWidth;
+
+    Eigen::Vector3d error = state - ref.pose.col(0);
+    error.z() = remainder(error.z(), 2.0 * M_PI);
+
+    // Condense the horizon, state errors 1..N are Phi * e0 + Gamma * u
+    Eigen::Matrix<double, 3 * N, 3> Phi;
+    Eigen::Matrix<double, 3 * N, NU> Gamma = Eigen::Matrix<double, 3 * N, NU>::Zero();
+    Eigen::Matrix3d PhiPrev = Eigen::Matrix3d::Identity();
+    for (int k = 0; k < N; k++)
+    {
+        double heading = ref.pose(2, k), speed = ref.speed(k);
+        double c = cos(heading), s = sin(heading);
+
+        Eigen::Matrix3d A = Eigen::Matrix3d::Identity();
+        A(0, 2) = -speed * s * MPC_DT;
+        A(1, 2) = speed * c * MPC_DT;
+
+        Eigen::Matrix<double, 3, 2> B;
+        B << c / 2, c / 2,
+             s / 2, s / 2,
+             -1 / width, 1 / width;
+        B *= MPC_DT;
+
+        PhiPrev = A * PhiPrev;
+        Phi.block<3, 3>(3 * k, 0) = PhiPrev;
+        if (k > 0) Gamma.block<3, NU>(3 * k, 0) = A * Gamma.block<3, NU>(3 * (k - 1), 0);
+        Gamma.block<3, 2>(3 * k, 2 * k) = B;
+    }
+
+    Eigen::Matrix<double, 3 * N, 1> weights;
+    for (int k = 0; k < N; k++) weights.segment<3>(3 * k) << posWeight, posWeight, headingWeight;
+
+    // 1/2 u'Hu + g'u
+    HessianMatrix H = Gamma.transpose() * weights.asDiagonal() * Gamma;
+    H.diagonal().array() += inputWeight;
+    InputVector g = Gamma.transpose() * weights.asDiagonal() * (Phi * error);
+
+    // Wheel speed limits on the total speed become boxes on the deviation
+    InputVector lower, upper;
+    for (int k = 0; k < N; k++)
+    {
+        lower.segment<2>(2 * k) = Eigen::Vector2d::Constant(-maxWheelSpeed) - ref.wheel.col(k);
+        upper.segment<2>(2 * k) = Eigen::Vector2d::Constant(maxWheelSpeed) - ref.wheel.col(k);
+    }
+
+    // Gershgorin bound on the largest eigenvalue sets a safe step without an eigen solve
+    double lipschitz = H.cwiseAbs().rowwise().sum().maxCoeff();
+    double stepSize = 1.0 / std::max(lipschitz, 1e-9);
+
+    // Warm start from last tick's plan moved on by the tick period, which is a fraction of a step
+    const double shift = tickPeriod / MPC_DT;
+    InputVector u;
+    for (int k = 0; k < N; k++)
+    {
+        double from = std::min(k + shift, static_cast<double>(N - 1));
+        int k0 = static_cast<int>(from);
+        int k1 = std::min(k0 + 1, N - 1);
+        double f = from - k0;
+        u.segment<2>(2 * k) = (1.0 - f) * m_Warm.segment<2>(2 * k0) + f * m_Warm.segment<2>(2 * k1);
+    }
+    u = u.cwiseMax(lower).cwiseMin(upper);
+
+    InputVector y = u;
+    double t = 1.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        InputVector next = (y - stepSize * (H * y + g)).cwiseMax(lower).cwiseMin(upper);
+        double tNext = (1.0 + sqrt(1.0 + 4.0 * t * t)) / 2.0;
+        y = next + ((t - 1.0) / tNext) * (next - u);
+        lastResidual = (next - u).norm() / stepSize;
+        u = next;
+        t = tNext;
+    }
+    m_Warm = u;
+
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    solveTime.add(elapsed);
+    maxSolveTime = std::max(maxSolveTime, elapsed);
+
+    return ref.wheel.col(0) + u.head<2>();
+}
@@ -0,0 +1,156 @@
+#include "Multilateration.hpp"
+#include <algorithm>
+
+#define MULTILAT_MAX_ANCHORS 16
+
+typedef Eigen::Matrix<double, Eigen::Dynamic, 2, Eigen::ColMajor, MULTILAT_MAX_ANCHORS, 2> AnchorMatrix;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, MULTILAT_MAX_ANCHORS, 1> RangeVector;
+
+MultilaterationResult Multilateration::solve(const AnchorTable& anchors, const Eigen::Vector2d& hint) const
+{
+    // Only use anchors with a range that is recent compared to the newest one
+    double newest = 0;
+    for (size_t i = 0; i < anchors.size(); i++)
+    {
+        if (anchors.range[i] > 0) newest = std::max(newest, anchors.timestamp[i]);
+    }
+
+    AnchorMatrix anchorPos(MULTILAT_MAX_ANCHORS, 2);
+    RangeVector ranges(MULTILAT_MAX_ANCHORS);
+    int n = 0;
+
+    for (size_t i = 0; i < anchors.size() && n < MULTILAT_MAX_ANCHORS; i++)
+    {
+        if (anchors.range[i] > 0 && anchors.timestamp[i] >= newest - maxRangeAge)
+        {
+            anchorPos.row(n) << anchors.x[i], anchors.y[i];
+            ranges(n) = anchors.range[i];
+            n++;
+        }
+    }
+
+    // Fixed size fast paths for the common anchor counts
+    switch (n)
+    {
+        case 0:
+        case 1: return MultilaterationResult();
+        case 2: return m_Solve<2, 2>(anchorPos.topRows<2>(), ranges.head<2>(), hint);
+        case 3: return m_Solve<3, 3>(anchorPos.topRows<3>(), ranges.head<3>(), hint);
+        case 4: return m_Solve<4, 4>(anchorPos.topRows<4>(), ranges.head<4>(), hint);
+        default: return m_Solve<Eigen::Dynamic, MULTILAT_MAX_ANCHORS>(anchorPos.topRows(n), ranges.head(n), hint);
+    }
+}
+
+template <int N, int MaxN>
+static void evaluateResiduals(
+    const Eigen::Matrix<double, N, 2, Eigen::ColMajor, MaxN, 2>& anchorPos,
+    const Eigen::Matrix<double, N, 1, Eigen::ColMajor, MaxN, 1>& ranges,
+    const Eigen::Vector2d& pos,
+    Eigen::Matrix<double, N, 1, Eigen::ColMajor, MaxN, 1>& residuals,
+    Eigen::Matrix<double, N, 2, Eigen::ColMajor, MaxN, 2>& J)
+{
+    J.col(0).array() = pos.x() - anchorPos.col(0).array();
+    J.col(1).array() = pos.y() - anchorPos.col(1).array();
+
+    Eigen::Array<double, N, 1, Eigen::ColMajor, MaxN, 1> predicted = J.rowwise().norm().array().max(ANCHOR_MIN_RANGE);
+    J.array().colwise() /= predicted;
+    residuals = (predicted - ranges.array()).matrix();
+}
+
+template <int N, int MaxN>
+MultilaterationResult Multilateration::m_Solve(
+    const Eigen::Matrix<double, N, 2, Eigen::ColMajor, MaxN, 2>& anchorPos, 
+    const Eigen::Matrix<double, N, 1, Eigen::ColMajor, MaxN, 1>& ranges, 
+    const Eigen::Vector2d& hint) const
+{
+    typedef Eigen::Matrix<double, N, 2, Eigen::ColMajor, MaxN, 2> Jacobian;
+    typedef Eigen::Matrix<double, N, 1, Eigen::ColMajor, MaxN, 1> Residuals;
+
+    const Eigen::Index n = anchorPos.rows();
+    MultilaterationResult result;
+    result.anchorsUsed = static_cast<int>(n);
+
+    // Closed form initial guess
+    Eigen::Vector2d pos = hint;
+    if (n == 2)
+    {
+        // Two circle intersection, both solutions are equally likely
+        Eigen::Vector2d a0 = anchorPos.row(0).transpose();
+        Eigen::Vector2d baseline = anchorPos.row(1).transpose() - a0;
+        double d = std::max(baseline.norm(), ANCHOR_MIN_RANGE);
+        double a = (ranges(0) * ranges(0) - ranges(1) * ranges(1) + d * d) / (2.0 * d);
+        double h = sqrt(std::max(ranges(0) * ranges(0) - a * a, 0.0));
+
+        Eigen::Vector2d midPoint = a0 + a * baseline / d;
+        Eigen::Vector2d offset = h * Eigen::Vector2d(-baseline.y(), baseline.x()) / d;
+
+        bool bFirstCloser = ((midPoint + offset) - hint).norm() <= ((midPoint - offset) - hint).norm();
+        pos = bFirstCloser ? Eigen::Vector2d(midPoint + offset) : Eigen::Vector2d(midPoint - offset);
+        result.mirrorPos = bFirstCloser ? Eigen::Vector2d(midPoint - offset) : Eigen::Vector2d(midPoint + offset);
+        result.bAmbiguous = true;
+    }
+    else
+    {
+        // Subtract the first range equation from the others to get a linear system in x, y
+        Eigen::Matrix<double, Eigen::Dynamic, 2, Eigen::ColMajor, MaxN, 2> A = 2.0 * (anchorPos.bottomRows(n - 1).rowwise() - anchorPos.row(0));
+        Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, MaxN, 1> b = 
+            (ranges(0) * ranges(0) - ranges.tail(n - 1).array().square() 
+            + anchorPos.bottomRows(n - 1).rowwise().squaredNorm().array() - anchorPos.row(0).squaredNorm()).matrix();
+
+        Eigen::Matrix2d AtA = A.transpose() * A;
+        if (std::abs(AtA.determinant()) > 1e-9)
+        {
+            pos = AtA.ldlt().solve(A.transpose() * b);
+        }
+    }
+
+    // Levenberg-Marquardt refinement
+    Residuals residuals(n);
+    Jacobian J(n, 2);
+    evaluateResiduals<N, MaxN>(anchorPos, ranges, pos, residuals, J);
+    double cost = residuals.squaredNorm();
+    double lambda = 1e-3;
+
+    Residuals trialResiduals(n);
+    Jacobian trialJ(n, 2);
+
+    for (result.iterations = 0; result.iterations < maxIterations; result.iterations++)
+    {
+        Eigen::Matrix2d JtJ = J.transpose() * J;
+        Eigen::Vector2d gradient = J.transpose() * residuals;
+
+        Eigen::Matrix2d damped = JtJ;
+        damped.diagonal() *= (1.0 + lambda);
+        Eigen::Vector2d delta = -damped.ldlt().solve(gradient);
+        if (delta.norm() < tolerance) break;
+
+        Eigen::Vector2d trialPos = pos + delta;
+        evaluateResiduals<N, MaxN>(anchorPos, ranges, trialPos, trialResiduals, trialJ);
+        double trialCost = trialResiduals.squaredNorm();
+
+        if (trialCost < cost)
+        {
+            pos = trialPos;
+            residuals = trialResiduals;
+            J = trialJ;
+            cost = trialCost;
+            lambda *= 0.1;
+        }
+        else
+        {
+            lambda *= 10.0;
+        }
+    }
+
+    // Covariance and geometric dilution of precision at the solution
+    Eigen::Matrix2d JtJ = J.transpose() * J;
+    Eigen::Matrix2d JtJInv = JtJ.inverse();
+
+    result.pos = pos;
+    result.covariance = rangeStdDev * rangeStdDev * JtJInv;
+    result.gdop = sqrt(std::max(JtJInv.trace(), 0.0));
+    result.residualRms = sqrt(cost / n);
+    result.bValid = pos.allFinite() && JtJInv.allFinite() && std::abs(JtJ.determinant()) > 1e-9;
+
+    return result;
+}
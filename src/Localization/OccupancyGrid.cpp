@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <math.h>
+#include "OccupancyGrid.hpp"
+
+OccupancyGrid::OccupancyGrid(const Eigen::Vector2d& center, const Eigen::Vector2d& size, double resolution)
+{
+    resize(center, size, resolution);
+}
+
+OccupancyGrid::~OccupancyGrid()
+{
+    if (m_Texture) SDL_DestroyTexture(m_Texture);
+}
+
+void OccupancyGrid::resize(const Eigen::Vector2d& center, const Eigen::Vector2d& size, double newResolution)
+{
+    resolution = newResolution;
+    width = std::max(1, static_cast<int>(ceil(size.x() / resolution)));
+    height = std::max(1, static_cast<int>(ceil(size.y() / resolution)));
+    origin = center - 0.5 * Eigen::Vector2d(width * resolution, height * resolution);
+
+    m_Stride = (width + 63) / 64;
+    m_Occupied.assign(static_cast<size_t>(m_Stride) * height, 0);
+    m_Blocked.assign(static_cast<size_t>(m_Stride) * height, 0);
+
+    if (m_Texture) SDL_DestroyTexture(m_Texture);
+    m_Texture = nullptr;
+    reinflate();
+}
+
+void OccupancyGrid::clear()
+{
+    std::fill(m_Occupied.begin(), m_Occupied.end(), 0);
+    std::fill(m_Blocked.begin(), m_Blocked.end(), 0);
+    m_DirtyRect.merge({0, 0, width, height});
+}
+
+void OccupancyGrid::reinflate()
+{
+    int r = static_cast<int>(ceil(inflation / resolution));
+    m_InflationDisc.clear();
+    for (int dy = -r; dy <= r; dy++)
+    {
+        for (int dx = -r; dx <= r; dx++)
+        {
+            if (dx * dx + dy * dy <= r * r) m_InflationDisc.push_back({dx, dy});
+        }
+    }
+
+    m_UpdateBlocked({0, 0, width, height});
+}
+
+Eigen::Vector2i OccupancyGrid::cellAt(const Eigen::Vector2d& pos) const
+{
+    Eigen::Vector2d cell = (pos - origin) / resolution;
+    return {static_cast<int>(floor(cell.x())), static_cast<int>(floor(cell.y()))};
+}
+
+Eigen::Vector2d OccupancyGrid::cellCenter(int x, int y) const
+{
+    return origin + Eigen::Vector2d(x + 0.5, y + 0.5) * resolution;
+}
+
+GridRect OccupancyGrid::m_Clip(GridRect rect) const
+{
+    rect.x0 = std::clamp(rect.x0, 0, width);
+    rect.x1 = std::clamp(rect.x1, 0, width);
+    rect.y0 = std::clamp(rect.y0, 0, height);
+    rect.y1 = std::clamp(rect.y1, 0, height);
+    return rect;
+}
+
+GridRect OccupancyGrid::paint(const Eigen::Vector2d& pos, double radius, bool bOccupied)
+{
+    Eigen::Vector2i center = cellAt(pos);
+    int r = std::max(0, static_cast<int>(radius / resolution));
+
+    GridRect brush = m_Clip({center.x() - r, center.y() - r, center.x() + r + 1, center.y() + r + 1});
+    if (brush.empty()) return {};
+
+    bool bChanged = false;
+    for (int y = brush.y0; y < brush.y1; y++)
+    {
+        for (int x = brush.x0; x < brush.x1; x++)
+        {
+            int dx = x - center.x(), dy = y - center.y();
+            if (dx * dx + dy * dy > r * r || m_Get(m_Occupied, x, y) == bOccupied) continue;
+            m_Set(m_Occupied, x, y, bOccupied);
+            bChanged = true;
+        }
+    }
+    if (!bChanged) return {};
+
+    int grow = static_cast<int>(ceil(inflation / resolution));
+    GridRect affected = m_Clip({brush.x0 - grow, brush.y0 - grow, brush.x1 + grow, brush.y1 + grow});
+    m_UpdateBlocked(affected);
+    return affected;
+}
+
+void OccupancyGrid::m_UpdateBlocked(const GridRect& rect)
+{
+    for (int y = rect.y0; y < rect.y1; y++)
+    {
+        for (int x = rect.x0; x < rect.x1; x++)
+        {
+            bool bBlocked = false;
+            for (const Eigen::Vector2i& offset : m_InflationDisc)
+            {
+                if (isOccupied(x + offset.x(), y + offset.y()))
+                {
+                    bBlocked = true;
+                    break;
+                }
+            }
+            m_Set(m_Blocked, x, y, bBlocked);
+        }
+    }
+    m_DirtyRect.merge(rect);
+}
+
+// Occupied cells are opaque, the inflated margin faint, texture rows run top down so y is flipped
+void OccupancyGrid::m_UpdateTexture()
+{
+    if (!m_Texture)
+    {
+        m_Texture = SDL_CreateTexture(ViewPort::GetInstance().GetSdlRenderer(), SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+        if (!m_Texture)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "OCCUPANCY ERROR: Unable to create %dx%d map texture: %s\n", width, height, SDL_GetError());
+            return;
+        }
+        SDL_SetTextureScaleMode(m_Texture, SDL_SCALEMODE_NEAREST);
+        m_DirtyRect = {0, 0, width, height};
+    }
+    if (m_DirtyRect.empty()) return;
+
+    const int w = m_DirtyRect.x1 - m_DirtyRect.x0;
+    const int h = m_DirtyRect.y1 - m_DirtyRect.y0;
+    m_Pixels.resize(static_cast<size_t>(w) * h);
+
+    for (int row = 0; row < h; row++)
+    {
+        int y = m_DirtyRect.y1 - 1 - row;
+        for (int x = m_DirtyRect.x0; x < m_DirtyRect.x1; x++)
+        {
+            uint32_t alpha = isOccupied(x, y) ? 255 : (m_Get(m_Blocked, x, y) ? 70 : 0);
+            m_Pixels[static_cast<size_t>(row) * w + (x - m_DirtyRect.x0)] = 0x00FFFFFFu | (alpha << 24);
+        }
+    }
+
+    SDL_Rect target = {m_DirtyRect.x0, height - m_DirtyRect.y1, w, h};
+    SDL_UpdateTexture(m_Texture, &target, m_Pixels.data(), w * static_cast<int>(sizeof(uint32_t)));
+    m_DirtyRect = {};
+}
+
+void OccupancyGrid::render()
+{
+    if (!bRender) return;
+
+    m_UpdateTexture();
+    if (!m_Texture) return;
+
+    Eigen::Vector2d size(width * resolution, height * resolution);
+    ViewPort::GetInstance().RenderTexture(m_Texture, origin + size / 2.0, size, 0, RED, 255);
+}
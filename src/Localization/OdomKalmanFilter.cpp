@@ -1,6 +1,8 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
 #include "OdomKalmanFilter.hpp"
+#include "DiffDriveModel.hpp"
 
 OdomKalmanFilter::OdomKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise)
 {
@@ -10,16 +12,17 @@ OdomKalmanFilter::OdomKalmanFilter(Eigen::Vector3d initialState, double processN
 
     P.setIdentity();
     Q.setIdentity();
-    R.setIdentity();
 
     Q *= processNoise;
-    R *= measurementNoise;
 }
 
-void OdomKalmanFilter::setAnchors(const Eigen::Vector2d& anchorA, const Eigen::Vector2d& anchorB) 
+void OdomKalmanFilter::setAnchors(const AnchorTable& anchors) 
 {
-    this->anchorA = anchorA;
-    this->anchorB = anchorB;
+    this->anchors = anchors;
+
+    Eigen::Index previousCols = K.cols();
+    K.conservativeResize(3, static_cast<Eigen::Index>(anchors.size()));
+    if (K.cols() > previousCols) K.rightCols(K.cols() - previousCols).setZero();
 }
 
 // Take in wheel encoder data and dt
@@ -29,99 +32,102 @@ void OdomKalmanFilter::predict(const Eigen::Vector2d& U, double dt)
     Q *= processNoise;
     Q(Q.rows() - 1, Q.cols() - 1) = 1e-4; // 1e-6
 
-    const float chassisWidth = 0.173f;
-    const float wheelRadius = 0.03f;
-
-    float dL = static_cast<float>((U[0] - encoderA) * wheelRadius); //New encoder - old encoder value
-    float dR = static_cast<float>((U[1] - encoderB) * wheelRadius);
+    const double chassisWidth = kinematics->trackWidth;
 
-    // Convert encoder values to distance traveled
-    float d = (dL + dR) / 2.0f;
-    float dTheta = (dR - dL) / (chassisWidth);
+    double dL = (U[0] - encoderA) * kinematics->wheelRadiusL; //New encoder - old encoder value
+    double dR = (U[1] - encoderB) * kinematics->wheelRadiusR;
 
     // Save for next prediction step
     encoderA = static_cast<float>(U[0]); 
     encoderB = static_cast<float>(U[1]);
 
     // Jacobian of the motion model
-    F << 1, 0, -d * sin(x.z() + dTheta / 2.0f),
-         0, 1,  d * cos(x.z() + dTheta / 2.0f),
-         0, 0,  1;
+    F = DiffDriveModel::motionJacobian(x, dL, dR, chassisWidth);
 
     // nonlinear motion model (differential drive)
-    x.x() += d * cos(x.z() + dTheta / 2.0f);
-    x.y() += d * sin(x.z() + dTheta / 2.0f);
-    x.z() += dTheta;
+    x = DiffDriveModel::motion(x, dL, dR, chassisWidth);
 
     P = F * P * F.transpose() + Q;
 }
 
-void OdomKalmanFilter::batchUpdate(const Eigen::Vector2d& measurement,  double dt) 
+void OdomKalmanFilter::batchUpdate(const Eigen::VectorXd& measurement,  double dt) 
 {
-    R.setIdentity();
-    R *= measurementNoise;
-
-    // current state
-    double x_pos = x(0);  
-    double y_pos = x(1); 
-    double theta = x(2); 
-
-    // distances to the anchors, predicted ranges
-    double r_a = std::sqrt(std::pow(x_pos - anchorA(0), 2) + std::pow(y_pos - anchorA(1), 2));
-    double r_b = std::sqrt(std::pow(x_pos - anchorB(0), 2) + std::pow(y_pos - anchorB(1), 2));
+    const Eigen::Index n = static_cast<Eigen::Index>(anchors.size());
+    R = Eigen::MatrixXd::Identity(n, n) * measurementNoise;
 
-    // partial derivatives for r_a and r_b wrt x and y
-    double d_rA_dx = (x_pos - anchorA(0)) / r_a;
-    double d_rA_dy = (y_pos - anchorA(1)) / r_a;
-    double d_rB_dx = (x_pos - anchorB(0)) / r_b;
-    double d_rB_dy = (y_pos - anchorB(1)) / r_b;
+    // predicted ranges and their partial derivatives wrt x and y for all anchors
+    Eigen::VectorXd predicted;
+    Eigen::Matrix<double, Eigen::Dynamic, 2> rangeJacobian;
+    anchors.predictRanges(x.head<2>(), predicted, rangeJacobian);
 
     // Jacobian matrix H
-    H << d_rA_dx, d_rA_dy, 0,
-         d_rB_dx, d_rB_dy, 0;
+    H.resize(n, 3);
+    H.leftCols<2>() = rangeJacobian;
+    H.col(2).setZero();
 
     // Kalman gain           
     K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
 
     // State update
-    x = x + K * (measurement - h(x));
+    x = x + K * (measurement - predicted);
 
     // Covariance update
-    P = (Eigen::MatrixXd::Identity(3, 3) - K * H) * P;
+    P = (Eigen::Matrix3d::Identity() - K * H) * P;
 }
 
-void OdomKalmanFilter::updateLandmark(char landmark, Eigen::Vector2d landmarkPos,  double measurement)
+bool OdomKalmanFilter::updateLandmark(int landmark, Eigen::Vector2d landmarkPos,  double measurement)
 {
-    // Local R for scalar measurement
-    Eigen::MatrixXd R_(1,1);
-    R_ << measurementNoise;
+    return updateLandmark(landmark, landmarkPos, measurement, measurementNoise);
+}
 
-    // Current state
-    double x_pos = x(0);  
-    double y_pos = x(1); 
+// Returns false if the range failed the innovation gate and was not applied
+bool OdomKalmanFilter::updateLandmark(int landmark, Eigen::Vector2d landmarkPos, double measurement, double variance)
+{
+    if (landmark < 0) return false;
 
     // Expected measurement
-    double dx = x_pos - landmarkPos(0);
-    double dy = y_pos - landmarkPos(1);
-    double h_x = std::sqrt(dx * dx + dy * dy);
-    if (h_x < 1e-6) h_x = 1e-6;
+    Eigen::Vector2d delta = x.head<2>() - landmarkPos;
+    double h_x = std::max(delta.norm(), 1e-6);
 
-    // Jacobian matrix H for one landmark
-    Eigen::MatrixXd H_(1, 3); 
-    H_ << dx / h_x, dy / h_x, 0;
+    // Jacobian for one landmark
+    Eigen::RowVector3d H_(delta.x() / h_x, delta.y() / h_x, 0);
+
+    // Innovation and its variance
+    Eigen::Vector3d PHt = P * H_.transpose();
+    double S = H_.dot(PHt) + variance;
+    double innovation = measurement - h_x;
+    double nis = innovation * innovation / S;
+
+    // Reject outliers, unless the anchor has been rejected so often the filter is probably the one that is wrong
+    if (bGating && nis > gateThreshold && consistency.anchor(landmark).consecutiveRejects < maxConsecutiveRejects)
+    {
+        consistency.addRejected(landmark);
+        return false;
+    }
+    consistency.addAccepted(landmark, nis);
 
     // Kalman gain (3x1)
-    Eigen::Vector3d K_ = P * H_.transpose() * (H_ * P * H_.transpose() + R_).inverse();
+    Eigen::Vector3d K_ = PHt / S;
 
     // State update
-    x = x + K_ * (measurement - h_x);
+    x = x + K_ * innovation;
 
     // Covariance update
-    P = (Eigen::MatrixXd::Identity(3, 3) - K_ * H_) * P;
+    P = (Eigen::Matrix3d::Identity() - K_ * H_) * P;
 
     // Update full K matrix for visualization
-    if (landmark == 'A') K.col(0) = K_;
-    else if (landmark == 'B') K.col(1) = K_;
+    if (landmark >= 0 && landmark < K.cols()) K.col(landmark) = K_;
+    return true;
+}
+
+void OdomKalmanFilter::updatePose(const Eigen::Vector3d& innovation, const Eigen::Matrix3d& covariance)
+{
+    // H is the identity, so S = P + R and K = P S^-1
+    Eigen::Matrix3d K_ = P * (P + covariance).inverse();
+
+    x = x + K_ * innovation;
+    P = (Eigen::Matrix3d::Identity() - K_) * P;
+    P = 0.5 * (P + P.transpose());
 }
 
 void OdomKalmanFilter::setPoseEstimate(Eigen::Vector3d initialState)
@@ -129,14 +135,9 @@ void OdomKalmanFilter::setPoseEstimate(Eigen::Vector3d initialState)
     x = initialState;
 }
 
-Eigen::Vector2d OdomKalmanFilter::h(const Eigen::Vector3d& state) 
+Eigen::VectorXd OdomKalmanFilter::h(const Eigen::Vector3d& state) 
 {
-    double r_a = sqrt((state(0) - anchorA(0)) * (state(0) - anchorA(0)) + (state(1) - anchorA(1)) * (state(1) - anchorA(1)));
-    double r_b = sqrt((state(0) - anchorB(0)) * (state(0) - anchorB(0)) + (state(1) - anchorB(1)) * (state(1) - anchorB(1)));
-
-    Eigen::Vector2d measurement;
-    measurement << r_a, r_b;
-    return measurement;
+    return anchors.predictRanges(state.head<2>());
 }
 
 void OdomKalmanFilter::render() 
@@ -168,5 +169,6 @@ void OdomKalmanFilter::render()
         printf("KALMAN ERROR: Covariance matrix invalid\n");
     }
     
-    ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().robotTexture, x.head(2), {0.173, 0.173}, -x.z() + M_PI_2, WHITE, 255);
+    Eigen::Vector3d pose = m_RenderPose();
+    ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().robotTexture, pose.head(2), {kinematics->trackWidth, kinematics->trackWidth}, -pose.z() + M_PI_2, WHITE, 255);
 }
\ No newline at end of file
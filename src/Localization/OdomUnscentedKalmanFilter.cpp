@@ -0,0 +1,138 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include "OdomUnscentedKalmanFilter.hpp"
+#include "DiffDriveModel.hpp"
+
+OdomUnscentedKalmanFilter::OdomUnscentedKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise)
+{
+    x = initialState;
+    this->processNoise = processNoise;
+    this->measurementNoise = measurementNoise;
+
+    P.setIdentity();
+    Q.setIdentity();
+
+    Q *= processNoise;
+
+    m_CalcWeights();
+}
+
+void OdomUnscentedKalmanFilter::setAnchors(const AnchorTable& anchors)
+{
+    this->anchors = anchors;
+
+    Eigen::Index previousCols = K.cols();
+    K.conservativeResize(3, static_cast<Eigen::Index>(anchors.size()));
+    if (K.cols() > previousCols) K.rightCols(K.cols() - previousCols).setZero();
+}
+
+// Take in wheel encoder data and dt
+void OdomUnscentedKalmanFilter::predict(const Eigen::Vector2d& U, double dt)
+{
+    Q.setIdentity();
+    Q *= processNoise;
+    Q(Q.rows() - 1, Q.cols() - 1) = 1e-4;
+
+    const double chassisWidth = kinematics->trackWidth;
+
+    double dL = (U[0] - encoderA) * kinematics->wheelRadiusL; //New encoder - old encoder value
+    double dR = (U[1] - encoderB) * kinematics->wheelRadiusR;
+
+    // Save for next prediction step
+    encoderA = static_cast<float>(U[0]);
+    encoderB = static_cast<float>(U[1]);
+
+    // Propagate all sigma points through the motion model at once
+    m_GenerateSigmaPoints();
+    DiffDriveModel::motionBatch<UKF_SIGMA_POINTS>(m_Sigma, dL, dR, chassisWidth);
+
+    // Recover mean and covariance, heading is unwrapped so a linear mean is valid
+    x = m_Sigma * m_Wm.transpose();
+    SigmaPoints deviation = m_Sigma.colwise() - x;
+    P = deviation * m_Wc.asDiagonal() * deviation.transpose() + Q;
+}
+
+void OdomUnscentedKalmanFilter::updateLandmark(int landmark, Eigen::Vector2d landmarkPos, double measurement)
+{
+    m_GenerateSigmaPoints();
+
+    // Expected range for every sigma point
+    SigmaWeights Z = DiffDriveModel::rangeBatch<UKF_SIGMA_POINTS>(m_Sigma, landmarkPos);
+    double zMean = Z.dot(m_Wm);
+
+    SigmaWeights zDeviation = (Z.array() - zMean).matrix();
+    SigmaPoints xDeviation = m_Sigma.colwise() - x;
+
+    // Innovation variance and state-measurement cross covariance
+    double S = zDeviation.cwiseProduct(m_Wc).dot(zDeviation) + measurementNoise;
+    Eigen::Vector3d Pxz = xDeviation * m_Wc.cwiseProduct(zDeviation).transpose();
+
+    // Kalman gain (3x1)
+    Eigen::Vector3d K_ = Pxz / S;
+
+    // State and covariance update
+    x = x + K_ * (measurement - zMean);
+    P = P - K_ * S * K_.transpose();
+
+    // Update full K matrix for visualization
+    if (landmark >= 0 && landmark < K.cols()) K.col(landmark) = K_;
+}
+
+void OdomUnscentedKalmanFilter::setPoseEstimate(Eigen::Vector3d initialState)
+{
+    x = initialState;
+}
+
+void OdomUnscentedKalmanFilter::m_CalcWeights()
+{
+    const double n = UKF_STATE_DIM;
+    double lambda = alpha * alpha * (n + kappa) - n;
+
+    m_Gamma = sqrt(n + lambda);
+
+    m_Wm.setConstant(1.0 / (2.0 * (n + lambda)));
+    m_Wc = m_Wm;
+    m_Wm(0) = lambda / (n + lambda);
+    m_Wc(0) = m_Wm(0) + (1.0 - alpha * alpha + beta);
+}
+
+// Sigma points from the Cholesky factor of P, column 0 is the mean
+void OdomUnscentedKalmanFilter::m_GenerateSigmaPoints()
+{
+    m_CalcWeights();
+
+    Eigen::Matrix3d L = P.llt().matrixL();
+    L *= m_Gamma;
+
+    m_Sigma.col(0) = x;
+    m_Sigma.block<3, 3>(0, 1) = L.colwise() + x;
+    m_Sigma.block<3, 3>(0, 1 + UKF_STATE_DIM) = (-L).colwise() + x;
+}
+
+void OdomUnscentedKalmanFilter::render()
+{
+    Eigen::Matrix2d covariance = P.block<2,2>(0, 0); // 2x2 part of the covariance matrix for x and y
+
+    if (covariance.allFinite())
+    {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> solver(covariance);
+
+        Eigen::Vector2d eigenvalues = solver.eigenvalues();
+        Eigen::Matrix2d eigenvectors = solver.eigenvectors();
+
+        // rotation of the ellipse from first eigenvector
+        double angle = std::atan2(eigenvectors(1, 0), eigenvectors(0, 0));
+
+        // Use standard deviations as the ellipse size
+        double ellipse_width = 2 * std::sqrt(eigenvalues(0));
+        double ellipse_height = 2 * std::sqrt(eigenvalues(1));
+        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, x.head(2), {ellipse_width, ellipse_height}, -angle, BLUE, 50);
+    }
+
+    else
+    {
+        printf("UKF ERROR: Covariance matrix invalid\n");
+    }
+
+    ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().robotTexture, x.head(2), {kinematics->trackWidth, kinematics->trackWidth}, -x.z() + M_PI_2, BLUE, 255);
+}
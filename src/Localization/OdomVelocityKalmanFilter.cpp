@@ -0,0 +1,51 @@
+#include <algorithm>
+#include "OdomVelocityKalmanFilter.hpp"
+
+OdomVelocityKalmanFilter::OdomVelocityKalmanFilter(Eigen::Vector3d initialState, double processNoise, double measurementNoise)
+    : OdomKalmanFilter(initialState, processNoise, measurementNoise)
+{
+}
+
+void OdomVelocityKalmanFilter::onEncoderPacket(const EncoderDataPacket& packet, double timestamp)
+{
+    double dt = (lastPacketTime < 0) ? 0 : std::max(timestamp - lastPacketTime, 0.0);
+    lastPacketTime = timestamp;
+
+    predict({packet.encA, packet.encB}, dt);
+    updateWheelVelocities(packet.velA, packet.velB, dt);
+}
+
+// Random walk on [v, omega] followed by a linear update with the wheel speeds
+void OdomVelocityKalmanFilter::updateWheelVelocities(double velA, double velB, double dt)
+{
+    Eigen::Matrix2d Q = Eigen::Vector2d(accelNoise * accelNoise, alphaNoise * alphaNoise).asDiagonal();
+    velocityP += Q * dt;
+
+    // Wheel speeds from body velocity
+    const double halfWidth = kinematics->trackWidth / 2.0;
+    Eigen::Matrix2d H_;
+    H_ << 1.0 / kinematics->wheelRadiusL, -halfWidth / kinematics->wheelRadiusL,
+          1.0 / kinematics->wheelRadiusR,  halfWidth / kinematics->wheelRadiusR;
+
+    Eigen::Matrix2d R_ = Eigen::Matrix2d::Identity() * wheelVelNoise * wheelVelNoise;
+    Eigen::Matrix2d S = H_ * velocityP * H_.transpose() + R_;
+    Eigen::Matrix2d K_ = velocityP * H_.transpose() * S.inverse();
+
+    velocity += K_ * (Eigen::Vector2d(velA, velB) - H_ * velocity);
+    velocityP = (Eigen::Matrix2d::Identity() - K_ * H_) * velocityP;
+}
+
+Eigen::Vector3d OdomVelocityKalmanFilter::extrapolate(double now) const
+{
+    if (lastPacketTime < 0) return x;
+
+    double tau = std::min(std::max(now - lastPacketTime, 0.0), maxExtrapolation);
+    double heading = x.z() + velocity.y() * tau / 2.0;
+
+    return {x.x() + velocity.x() * tau * cos(heading), x.y() + velocity.x() * tau * sin(heading), x.z() + velocity.y() * tau};
+}
+
+Eigen::Vector3d OdomVelocityKalmanFilter::m_RenderPose()
+{
+    return currentPose(SDL_GetTicksNS() / 1e9);
+}
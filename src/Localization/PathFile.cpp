@@ -0,0 +1,238 @@
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstring>
+#include "PathFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read only view of a whole file, unmapped when it goes out of scope
+class MappedFile
+{
+public:
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+
+    explicit MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart == 0) return;
+
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_Mapping) return;
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data) size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+        m_File = open(path.c_str(), O_RDONLY);
+        if (m_File < 0) return;
+
+        struct stat info;
+        if (fstat(m_File, &info) != 0 || info.st_size == 0) return;
+
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+        if (view == MAP_FAILED) return;
+
+        madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t*>(view);
+        size = static_cast<uint64_t>(info.st_size);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (m_Mapping) CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), static_cast<size_t>(size));
+        if (m_File >= 0) close(m_File);
+#endif
+    }
+
+    bool isOpen() const { return data != nullptr; }
+
+private:
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#else
+    int m_File = -1;
+#endif
+};
+
+// The payload in the file need not be aligned, it is copied as raw doubles into the point storage
+static void copyPoints(std::vector<Eigen::Vector2d>& points, const uint8_t* data, size_t count)
+{
+    points.resize(count);
+    if (count == 0) return;
+    Eigen::Map<Eigen::Matrix<double, 2, Eigen::Dynamic>> destination(points.front().data(), 2, static_cast<Eigen::Index>(count));
+    memcpy(destination.data(), data, count * sizeof(Eigen::Vector2d));
+}
+
+uint64_t PathFile::checksum(const void* data, size_t bytes, uint64_t hash)
+{
+    const uint8_t* bytePtr = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytePtr + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool PathFile::checkHeader(const PathFileHeader& header, uint64_t fileSize, const std::string& path)
+{
+    if (header.version != PATHFILE_VERSION)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s is version %d, expected %d\n", path.c_str(), header.version, PATHFILE_VERSION);
+        return false;
+    }
+    if (header.byteOrder != PATHFILE_BYTE_ORDER)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s was written with a different byte order\n", path.c_str());
+        return false;
+    }
+    if (header.count > (fileSize - sizeof(PathFileHeader)) / sizeof(Eigen::Vector2d) ||
+        sizeof(PathFileHeader) + header.count * sizeof(Eigen::Vector2d) != fileSize)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s is truncated\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PathFile::save(const std::string& path, const std::vector<Eigen::Vector2d>& points)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: Unable to open file %s for writing\n", path.c_str());
+        return false;
+    }
+
+    const size_t bytes = points.size() * sizeof(Eigen::Vector2d);
+    PathFileHeader header;
+    header.count = points.size();
+    header.checksum = checksum(points.data(), bytes);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(points.data()), static_cast<std::streamsize>(bytes));
+    if (!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: Failed writing %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PathFile::load(const std::string& path, std::vector<Eigen::Vector2d>& points)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        // Mapping can fail where reading still works, e.g. on some network drives
+        PathFileReader reader;
+        if (!reader.open(path)) return false;
+
+        points.resize(reader.count());
+        size_t read = 0;
+        while (reader.remaining() > 0)
+        {
+            size_t n = reader.read(points.data() + read, PATHFILE_STREAM_CHUNK);
+            if (n == 0) break;
+            read += n;
+        }
+        if (!reader.verify())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s failed its checksum\n", path.c_str());
+            points.clear();
+            return false;
+        }
+        return true;
+    }
+
+    PathFileHeader header;
+    if (file.size >= sizeof(header)) memcpy(&header, file.data, sizeof(header));
+
+    if (file.size >= sizeof(header) && header.magic == PATHFILE_MAGIC)
+    {
+        if (!checkHeader(header, file.size, path)) return false;
+
+        const uint8_t* payload = file.data + sizeof(header);
+        const size_t bytes = static_cast<size_t>(header.count) * sizeof(Eigen::Vector2d);
+        if (checksum(payload, bytes) != header.checksum)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s failed its checksum\n", path.c_str());
+            return false;
+        }
+
+        copyPoints(points, payload, static_cast<size_t>(header.count));
+        return true;
+    }
+
+    // Legacy layout, a size_t count then the points with nothing to check but the length
+    uint64_t legacyCount = 0;
+    if (file.size >= sizeof(legacyCount)) memcpy(&legacyCount, file.data, sizeof(legacyCount));
+    if (file.size < sizeof(legacyCount) || legacyCount > file.size / sizeof(Eigen::Vector2d) ||
+        sizeof(legacyCount) + legacyCount * sizeof(Eigen::Vector2d) != file.size)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s is not a path file\n", path.c_str());
+        return false;
+    }
+
+    copyPoints(points, file.data + sizeof(legacyCount), static_cast<size_t>(legacyCount));
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE INFO: %s uses the old format, save it again to add a checksum\n", path.c_str());
+    return true;
+}
+
+bool PathFileReader::open(const std::string& path)
+{
+    m_File.open(path, std::ios::binary | std::ios::ate);
+    if (!m_File.is_open())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: Unable to open file %s for reading\n", path.c_str());
+        return false;
+    }
+
+    uint64_t fileSize = static_cast<uint64_t>(m_File.tellg());
+    m_File.seekg(0);
+    m_File.read(reinterpret_cast<char*>(&m_Header), sizeof(m_Header));
+    if (!m_File || m_Header.magic != PATHFILE_MAGIC || !PathFile::checkHeader(m_Header, fileSize, path))
+    {
+        if (m_File && m_Header.magic != PATHFILE_MAGIC)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "PATHFILE ERROR: %s is not a version %d path file\n", path.c_str(), PATHFILE_VERSION);
+        }
+        m_File.close();
+        return false;
+    }
+
+    m_Read = 0;
+    m_Checksum = PATHFILE_CHECKSUM_SEED;
+    return true;
+}
+
+size_t PathFileReader::read(Eigen::Vector2d* points, size_t maxPoints)
+{
+    size_t n = static_cast<size_t>(std::min<uint64_t>(maxPoints, remaining()));
+    if (n == 0 || !m_File.read(reinterpret_cast<char*>(points), static_cast<std::streamsize>(n * sizeof(Eigen::Vector2d)))) return 0;
+
+    m_Checksum = PathFile::checksum(points, n * sizeof(Eigen::Vector2d), m_Checksum);
+    m_Read += n;
+    return n;
+}
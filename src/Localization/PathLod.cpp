@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <limits>
+#include "PathLod.hpp"
+
+static double segmentDistance(const Eigen::Vector2d& p, const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+{
+    Eigen::Vector2d ab = b - a;
+    double length2 = ab.squaredNorm();
+    double t = (length2 > 1e-18) ? std::clamp((p - a).dot(ab) / length2, 0.0, 1.0) : 0.0;
+    return (p - (a + t * ab)).norm();
+}
+
+void PathLod::clear()
+{
+    importance.clear();
+    m_Levels.clear();
+    m_Tolerance.clear();
+}
+
+void PathLod::build(const std::vector<Eigen::Vector2d>& points, bool bClosed)
+{
+    clear();
+    const size_t n = points.size();
+    if (n == 0) return;
+
+    const double INF = std::numeric_limits<double>::infinity();
+    importance.assign(n, INF);
+
+    // Spans use unwrapped indices, the second half of a loop runs past the end back to the start
+    struct Span { size_t first, last; double parent; };
+    std::vector<Span> stack;
+    if (!bClosed)
+    {
+        // An open path is one span between its ends, both always kept
+        stack.push_back({0, n - 1, INF});
+    }
+    else if (n > 3)
+    {
+        // The loop is split at the start and the point furthest from it, both always kept
+        size_t far = 0;
+        double farDistance = -1;
+        for (size_t i = 1; i < n; i++)
+        {
+            double d = (points[i] - points[0]).squaredNorm();
+            if (d > farDistance)
+            {
+                farDistance = d;
+                far = i;
+            }
+        }
+        stack = {{0, far, INF}, {far, n, INF}};
+    }
+
+    while (!stack.empty())
+    {
+        Span span = stack.back();
+        stack.pop_back();
+        if (span.last - span.first < 2) continue;
+
+        const Eigen::Vector2d& a = points[span.first % n];
+        const Eigen::Vector2d& b = points[span.last % n];
+        size_t split = span.first + 1;
+        double splitDistance = -1;
+        for (size_t i = span.first + 1; i < span.last; i++)
+        {
+            double d = segmentDistance(points[i % n], a, b);
+            if (d > splitDistance)
+            {
+                splitDistance = d;
+                split = i;
+            }
+        }
+
+        double value = std::min(splitDistance, span.parent);
+        importance[split % n] = value;
+        stack.push_back({span.first, split, value});
+        stack.push_back({split, span.last, value});
+    }
+
+    std::vector<int> all(n);
+    for (size_t i = 0; i < n; i++) all[i] = static_cast<int>(i);
+    m_Levels.push_back(std::move(all));
+    m_Tolerance.push_back(0);
+
+    double tolerance = LOD_BASE_TOLERANCE;
+    while (m_Levels.size() < LOD_MAX_LEVELS && m_Levels.back().size() > 3)
+    {
+        std::vector<int> kept;
+        for (int i : m_Levels.back())
+        {
+            if (importance[i] > tolerance) kept.push_back(i);
+        }
+        if (kept.size() < m_Levels.back().size())
+        {
+            m_Levels.push_back(std::move(kept));
+            m_Tolerance.push_back(tolerance);
+        }
+        else
+        {
+            // Nothing dropped, widen this level's tolerance instead of storing a copy
+            m_Tolerance.back() = std::max(m_Tolerance.back(), tolerance);
+        }
+        tolerance *= 2.0;
+    }
+}
+
+const std::vector<int>& PathLod::level(double tolerance) const
+{
+    static const std::vector<int> none;
+    if (m_Levels.empty()) return none;
+
+    size_t level = 0;
+    while (level + 1 < m_Levels.size() && m_Tolerance[level + 1] <= tolerance) level++;
+    return m_Levels[level];
+}
+
+std::vector<Eigen::Vector2d> PathLod::simplify(const std::vector<Eigen::Vector2d>& points, double tolerance) const
+{
+    std::vector<Eigen::Vector2d> simplified;
+    if (importance.size() != points.size()) return points;
+
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        if (importance[i] > tolerance) simplified.push_back(points[i]);
+    }
+    return simplified;
+}
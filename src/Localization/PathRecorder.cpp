@@ -0,0 +1,108 @@
+#include <SDL3/SDL.h>
+#include <math.h>
+#include <algorithm>
+#include "PathRecorder.hpp"
+
+PathRecorder::PathRecorder()
+{
+    m_Points.reserve(RECORD_CAPACITY);
+}
+
+void PathRecorder::start()
+{
+    m_Points.clear();
+    m_LodPoints = 0;
+    samples = 0;
+    m_bRecording = true;
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RECORD INFO: Recording started\n");
+}
+
+void PathRecorder::stop()
+{
+    if (!m_bRecording) return;
+    m_bRecording = false;
+
+    // The end of the drive is kept even when it is closer than the spacing
+    if (samples > 0 && (m_LastPose.head<2>() - m_LastKept.head<2>()).norm() > RECORD_MIN_SPACING && m_Points.size() < m_Points.capacity())
+    {
+        m_Keep(m_LastPose);
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "RECORD INFO: Recorded %zu points from %zu poses\n", m_Points.size(), samples);
+}
+
+void PathRecorder::clear()
+{
+    m_bRecording = false;
+    m_Points.clear();
+    m_Lod.clear();
+    m_LodPoints = 0;
+    samples = 0;
+}
+
+void PathRecorder::m_Keep(const Eigen::Vector3d& pose)
+{
+    m_Points.push_back(pose.head<2>());
+    m_LastKept = pose;
+}
+
+void PathRecorder::addPose(const Eigen::Vector3d& pose)
+{
+    if (!m_bRecording) return;
+    m_LastPose = pose;
+
+    if (samples++ == 0)
+    {
+        m_Keep(pose);
+        return;
+    }
+
+    double distance = (pose.head<2>() - m_LastKept.head<2>()).norm();
+    double turned = fabs(atan2(sin(pose.z() - m_LastKept.z()), cos(pose.z() - m_LastKept.z())));
+    if (distance < spacing && (turned < headingThreshold || distance < RECORD_MIN_SPACING)) return;
+
+    if (m_Points.size() == m_Points.capacity())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "RECORD ERROR: Buffer full at %zu points, recording stopped\n", m_Points.size());
+        m_bRecording = false;
+        return;
+    }
+    m_Keep(pose);
+}
+
+void PathRecorder::render()
+{
+    if (!bRender || m_Points.empty()) return;
+    ViewPort& viewport = ViewPort::GetInstance();
+    Camera2D& camera = viewport.GetCamera();
+    const double pixel = 1.0 / std::max(camera.getScale(), 1);
+    const Eigen::AlignedBox2d view = camera.getVisibleBox();
+
+    auto drawSegment = [&](const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+    {
+        if (view.intersects(Eigen::AlignedBox2d(a.cwiseMin(b), a.cwiseMax(b)))) viewport.RenderLineTexture(a, b, 0.01, YELLOW, 200);
+    };
+
+    if (!m_bRecording)
+    {
+        // A finished recording is drawn at the coarsest level within LOD_PIXEL_TOLERANCE on screen
+        if (m_LodPoints != m_Points.size())
+        {
+            m_Lod.build(m_Points, false);
+            m_LodPoints = m_Points.size();
+        }
+        const std::vector<int>& level = m_Lod.level(LOD_PIXEL_TOLERANCE * pixel);
+        for (size_t k = 1; k < level.size(); k++) drawSegment(m_Points[level[k - 1]], m_Points[level[k]]);
+        return;
+    }
+
+    // Still growing, points closer than a pixel to the last one drawn are skipped rather than rebuilding levels
+    const double pixel2 = pixel * pixel;
+    size_t last = 0;
+    for (size_t i = 1; i < m_Points.size(); i++)
+    {
+        if (i + 1 < m_Points.size() && (m_Points[i] - m_Points[last]).squaredNorm() < pixel2) continue;
+        drawSegment(m_Points[last], m_Points[i]);
+        last = i;
+    }
+    viewport.RenderLineTexture(m_Points.back(), m_LastPose.head<2>(), 0.01, YELLOW, 100);
+}
@@ -0,0 +1,344 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include "PoseGraph.hpp"
+#include "DiffDriveModel.hpp"
+
+PoseGraph::~PoseGraph()
+{
+    stop();
+}
+
+void PoseGraph::start()
+{
+    if (m_Worker) return;
+    m_RunThread = true;
+    m_Worker = new std::thread(&PoseGraph::m_SolverTask, this);
+}
+
+void PoseGraph::stop()
+{
+    m_RunThread = false;
+    m_Condition.notify_all();
+    if (m_Worker)
+    {
+        m_Worker->join();
+        delete m_Worker;
+        m_Worker = nullptr;
+    }
+}
+
+void PoseGraph::clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Nodes.clear();
+    m_Ranges.clear();
+    m_OdomAccum.setZero();
+    m_OdomCov.setZero();
+    m_OdomDistance = 0;
+    m_bNewCorrection = false;
+    m_bDirty = false;
+}
+
+void PoseGraph::addOdometry(double time, const Eigen::Vector2d& U, const Eigen::Vector3d& filteredPose, const Eigen::Matrix3d& filteredP)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // The first node takes the filter pose as its prior
+    if (m_Nodes.empty())
+    {
+        encoderA = static_cast<float>(U[0]);
+        encoderB = static_cast<float>(U[1]);
+        m_AddNode(time, filteredPose, filteredP);
+        m_Nodes.back().priorInfo = filteredP.inverse();
+        return;
+    }
+
+    double dL = (U[0] - encoderA) * kinematics->wheelRadiusL;
+    double dR = (U[1] - encoderB) * kinematics->wheelRadiusR;
+    encoderA = static_cast<float>(U[0]);
+    encoderB = static_cast<float>(U[1]);
+
+    // Motion since the newest node in its frame, with noise growing with the wheel travel
+    Eigen::Matrix3d F = DiffDriveModel::motionJacobian(m_OdomAccum, dL, dR, kinematics->trackWidth);
+    m_OdomAccum = DiffDriveModel::motion(m_OdomAccum, dL, dR, kinematics->trackWidth);
+
+    double distance = (fabs(dL) + fabs(dR)) / 2.0;
+    double rotation = fabs(dR - dL) / kinematics->trackWidth;
+    Eigen::Vector3d stepVar(PG_ODOM_DIST_VAR * distance, PG_ODOM_DIST_VAR * distance, PG_ODOM_ANGLE_VAR * rotation);
+    m_OdomCov = F * m_OdomCov * F.transpose() + Eigen::Matrix3d(stepVar.asDiagonal());
+    m_OdomDistance += distance;
+
+    if (m_OdomDistance > PG_NODE_DISTANCE || fabs(m_OdomAccum.z()) > PG_NODE_ANGLE || time - m_Nodes.back().time > PG_NODE_PERIOD)
+    {
+        m_AddNode(time, filteredPose, filteredP);
+    }
+}
+
+// Called with the mutex held
+void PoseGraph::m_AddNode(double time, const Eigen::Vector3d& filteredPose, const Eigen::Matrix3d& filteredP)
+{
+    Node node;
+    node.id = m_NextId++;
+    node.time = time;
+    node.filtered = filteredPose;
+    node.filteredP = filteredP;
+
+    if (m_Nodes.empty())
+    {
+        node.pose = filteredPose;
+    }
+    else
+    {
+        // Chain the odometry onto the optimised previous node rather than trusting the filter
+        const Node& previous = m_Nodes.back();
+        double c = cos(previous.pose.z()), s = sin(previous.pose.z());
+        node.pose = previous.pose + Eigen::Vector3d(c * m_OdomAccum.x() - s * m_OdomAccum.y(), s * m_OdomAccum.x() + c * m_OdomAccum.y(), m_OdomAccum.z());
+        node.odometry = m_OdomAccum;
+        node.odometryInfo = (m_OdomCov + Eigen::Matrix3d::Identity() * PG_ODOM_MIN_VAR).inverse();
+    }
+    m_Nodes.push_back(node);
+
+    // Slide the window, the new oldest node takes the filter covariance from when it was made as its prior
+    while (m_Nodes.size() > std::max<size_t>(windowSize, 2))
+    {
+        m_Nodes.pop_front();
+        m_Nodes.front().priorInfo = m_Nodes.front().filteredP.inverse();
+        m_Nodes.front().odometry.setZero();
+        m_Nodes.front().odometryInfo.setZero();
+    }
+    while (!m_Ranges.empty() && m_Ranges.front().nodeId < m_Nodes.front().id)
+    {
+        m_Ranges.pop_front();
+    }
+
+    m_OdomAccum.setZero();
+    m_OdomCov.setZero();
+    m_OdomDistance = 0;
+    m_bDirty = true;
+    m_Condition.notify_one();
+}
+
+void PoseGraph::addRange(const Eigen::Vector2d& anchor, double range, double variance)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Nodes.empty() || variance <= 0) return;
+
+    RangeFactor factor;
+    factor.nodeId = m_Nodes.back().id;
+    factor.anchor = anchor;
+    factor.range = range;
+    factor.info = 1.0 / variance;
+    m_Ranges.push_back(factor);
+    m_bDirty = true;
+}
+
+bool PoseGraph::popCorrection(Eigen::Vector3d& correction, Eigen::Matrix3d& covariance)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_bNewCorrection || m_CorrectionId <= m_AppliedId) return false;
+
+    correction = m_Correction;
+    covariance = m_CorrectionCov / std::max(correctionWeight, 1e-3);
+    m_AppliedId = m_CorrectionId;
+    m_bNewCorrection = false;
+    return true;
+}
+
+size_t PoseGraph::nodeCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Nodes.size();
+}
+
+size_t PoseGraph::rangeCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Ranges.size();
+}
+
+// runs in a separate thread, solves a copy of the window whenever it has changed
+void PoseGraph::m_SolverTask()
+{
+    std::vector<Node> nodes;
+    std::vector<RangeFactor> ranges;
+
+    while (m_RunThread)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait_for(lock, std::chrono::milliseconds(PG_SOLVE_PERIOD_MS), [this]() { return m_bDirty || !m_RunThread; });
+            if (!m_bDirty || m_Nodes.size() < 2) continue;
+
+            nodes.assign(m_Nodes.begin(), m_Nodes.end());
+            ranges.assign(m_Ranges.begin(), m_Ranges.end());
+            m_bDirty = false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int iterations = 0;
+        Eigen::Matrix3d newestCov;
+        double cost = m_Optimise(nodes, ranges, iterations, newestCov);
+        lastSolveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        lastCost = cost;
+        lastIterations = iterations;
+
+        // Write back the nodes still in the window, new nodes added meanwhile keep their odometry guess
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const Node& newest = nodes.back();
+
+        // Cleared while solving, the result belongs to the old trajectory
+        if (m_Nodes.empty() || newest.id < m_Nodes.front().id) continue;
+
+        for (const Node& node : nodes)
+        {
+            if (node.id < m_Nodes.front().id) continue;
+            size_t index = static_cast<size_t>(node.id - m_Nodes.front().id);
+            if (index < m_Nodes.size()) m_Nodes[index].pose = node.pose;
+        }
+
+        m_Correction = newest.pose - newest.filtered;
+        m_Correction.z() = remainder(m_Correction.z(), 2.0 * M_PI);
+        m_CorrectionCov = newestCov;
+        m_CorrectionId = newest.id;
+        m_bNewCorrection = true;
+    }
+}
+
+double PoseGraph::m_Optimise(std::vector<Node>& nodes, const std::vector<RangeFactor>& ranges, int& iterations, Eigen::Matrix3d& newestCov)
+{
+    const int n = static_cast<int>(nodes.size());
+    const uint64_t firstId = nodes.front().id;
+    const Eigen::Vector3d prior = nodes.front().pose;
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(static_cast<size_t>(n) * 27);
+    Eigen::VectorXd b(3 * n);
+    double cost = 0;
+    bool bFactorised = false;
+
+    // Every entry of a block is added, even zeros, so the sparsity pattern is the same each iteration
+    auto addBlock = [&](int row, int col, const Eigen::Matrix3d& block)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                triplets.emplace_back(3 * row + i, 3 * col + j, block(i, j));
+            }
+        }
+    };
+
+    for (iterations = 0; iterations < PG_MAX_ITERATIONS; iterations++)
+    {
+        triplets.clear();
+        b.setZero();
+        cost = 0;
+
+        // Prior on the oldest node holds the window in place
+        {
+            Eigen::Vector3d e = nodes[0].pose - prior;
+            e.z() = remainder(e.z(), 2.0 * M_PI);
+            const Eigen::Matrix3d& W = nodes[0].priorInfo;
+            addBlock(0, 0, W);
+            b.segment<3>(0) += W * e;
+            cost += e.dot(W * e);
+        }
+
+        // Odometry between consecutive nodes
+        for (int k = 1; k < n; k++)
+        {
+            const Eigen::Vector3d& a = nodes[k - 1].pose;
+            const Eigen::Vector3d& p = nodes[k].pose;
+            double c = cos(a.z()), s = sin(a.z());
+            Eigen::Vector2d d = p.head<2>() - a.head<2>();
+
+            Eigen::Vector3d e(c * d.x() + s * d.y(), -s * d.x() + c * d.y(), p.z() - a.z());
+            e -= nodes[k].odometry;
+            e.z() = remainder(e.z(), 2.0 * M_PI);
+
+            Eigen::Matrix3d Ja, Jp;
+            Ja << -c, -s, -s * d.x() + c * d.y(),
+                   s, -c, -c * d.x() - s * d.y(),
+                   0,  0, -1;
+            Jp << c, s, 0,
+                 -s, c, 0,
+                  0, 0, 1;
+
+            const Eigen::Matrix3d& W = nodes[k].odometryInfo;
+            addBlock(k - 1, k - 1, Ja.transpose() * W * Ja);
+            addBlock(k - 1, k, Ja.transpose() * W * Jp);
+            addBlock(k, k - 1, Jp.transpose() * W * Ja);
+            addBlock(k, k, Jp.transpose() * W * Jp);
+            b.segment<3>(3 * (k - 1)) += Ja.transpose() * W * e;
+            b.segment<3>(3 * k) += Jp.transpose() * W * e;
+            cost += e.dot(W * e);
+        }
+
+        // Ranges only touch the position of their node
+        for (const RangeFactor& factor : ranges)
+        {
+            int k = static_cast<int>(factor.nodeId - firstId);
+            if (k < 0 || k >= n) continue;
+
+            Eigen::Vector2d delta = nodes[k].pose.head<2>() - factor.anchor;
+            double predicted = std::max(delta.norm(), 1e-6);
+            double e = predicted - factor.range;
+            Eigen::Vector3d J(delta.x() / predicted, delta.y() / predicted, 0);
+
+            addBlock(k, k, J * factor.info * J.transpose());
+            b.segment<3>(3 * k) += J * factor.info * e;
+            cost += e * e * factor.info;
+        }
+
+        // A little damping keeps unobserved directions solvable
+        for (int i = 0; i < 3 * n; i++)
+        {
+            triplets.emplace_back(i, i, 1e-9);
+        }
+
+        Eigen::SparseMatrix<double> H(3 * n, 3 * n);
+        H.setFromTriplets(triplets.begin(), triplets.end());
+
+        if (iterations == 0) solver.analyzePattern(H);
+        solver.factorize(H);
+        bFactorised = solver.info() == Eigen::Success;
+        if (!bFactorised) break;
+
+        Eigen::VectorXd dx = solver.solve(-b);
+        for (int k = 0; k < n; k++)
+        {
+            nodes[k].pose += dx.segment<3>(3 * k);
+        }
+        if (dx.lpNorm<Eigen::Infinity>() < 1e-6)
+        {
+            iterations++;
+            break;
+        }
+    }
+
+    // Marginal covariance of the newest node is its block of the inverse information matrix,
+    // from the last linearisation. Without a factorisation the correction carries no weight.
+    newestCov = Eigen::Matrix3d::Identity() * 1e6;
+    if (bFactorised)
+    {
+        Eigen::MatrixXd E = Eigen::MatrixXd::Zero(3 * n, 3);
+        E.bottomRows<3>().setIdentity();
+        newestCov = solver.solve(E).bottomRows<3>();
+        newestCov = 0.5 * (newestCov + newestCov.transpose());
+    }
+    return cost;
+}
+
+void PoseGraph::render()
+{
+    if (!isRunning()) return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const Node& node : m_Nodes)
+    {
+        ViewPort::GetInstance().RenderTexture(ViewPort::GetInstance().circleTexture, node.pose.head(2), {0.015, 0.015}, 0.0, BLUE, 150);
+    }
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <math.h>
+#include "SplinePath.hpp"
+
+void SplinePath::clear()
+{
+    m_Waypoints.clear();
+    m_SegmentSamples.clear();
+    segmentStart.clear();
+    points.clear();
+    distance.clear();
+    m_Length = 0;
+}
+
+void SplinePath::build(const std::vector<Eigen::Vector2d>& waypoints)
+{
+    clear();
+    if (waypoints.size() < 2) return;
+
+    m_Waypoints = waypoints;
+    const size_t segments = m_Waypoints.size();
+    m_SegmentSamples.reserve(segments);
+    points.reserve(segments + 1);
+
+    for (size_t i = 0; i < segments; i++)
+    {
+        m_SegmentSamples.push_back(m_SampleSegment(i, points));
+    }
+
+    // Close the loop with a copy of the first sample
+    points.push_back(points.front());
+    m_UpdateTables(0);
+}
+
+bool SplinePath::splice(const std::vector<Eigen::Vector2d>& waypoints, size_t firstSegment, size_t oldSegments, size_t newSegments,
+    size_t& firstSample, size_t& oldSamples, size_t& newSamples)
+{
+    // Splices that wrap past the end of the path would move the first sample, those are rebuilt in full
+    if (empty() || waypoints.size() < 4 || firstSegment + oldSegments > m_Waypoints.size() || firstSegment + newSegments > waypoints.size() ||
+        m_Waypoints.size() - oldSegments != waypoints.size() - newSegments)
+    {
+        build(waypoints);
+        return false;
+    }
+
+    m_Waypoints = waypoints;
+    firstSample = segmentStart[firstSegment];
+    oldSamples = segmentStart[firstSegment + oldSegments] - firstSample;
+
+    std::vector<Eigen::Vector2d> samples;
+    std::vector<size_t> counts;
+    for (size_t i = firstSegment; i < firstSegment + newSegments; i++)
+    {
+        counts.push_back(m_SampleSegment(i, samples));
+    }
+    newSamples = samples.size();
+
+    points.erase(points.begin() + firstSample, points.begin() + firstSample + oldSamples);
+    points.insert(points.begin() + firstSample, samples.begin(), samples.end());
+    points.back() = points.front();
+
+    m_SegmentSamples.erase(m_SegmentSamples.begin() + firstSegment, m_SegmentSamples.begin() + firstSegment + oldSegments);
+    m_SegmentSamples.insert(m_SegmentSamples.begin() + firstSegment, counts.begin(), counts.end());
+
+    // Only sums from here on, the spline itself is not evaluated outside the splice
+    m_UpdateTables(firstSample);
+    return true;
+}
+
+size_t SplinePath::m_SampleSegment(size_t segment, std::vector<Eigen::Vector2d>& out) const
+{
+    const size_t n = m_Waypoints.size();
+    double chord = (m_Waypoints[(segment + 1) % n] - m_Waypoints[segment]).norm();
+    size_t samples = std::max<size_t>(1, static_cast<size_t>(ceil(chord / SPLINE_SAMPLE_SPACING)));
+    for (size_t k = 0; k < samples; k++)
+    {
+        out.push_back(evaluate(segment, static_cast<double>(k) / samples));
+    }
+    return samples;
+}
+
+void SplinePath::m_UpdateTables(size_t fromSample)
+{
+    segmentStart.resize(m_SegmentSamples.size() + 1);
+    segmentStart[0] = 0;
+    for (size_t i = 0; i < m_SegmentSamples.size(); i++)
+    {
+        segmentStart[i + 1] = segmentStart[i] + m_SegmentSamples[i];
+    }
+
+    distance.resize(points.size());
+    if (fromSample == 0) distance[0] = 0;
+    for (size_t i = std::max<size_t>(fromSample, 1); i < points.size(); i++)
+    {
+        distance[i] = distance[i - 1] + (points[i] - points[i - 1]).norm();
+    }
+    m_Length = distance.back();
+}
+
+Eigen::Vector2d SplinePath::evaluate(size_t segment, double t) const
+{
+    const size_t n = m_Waypoints.size();
+    const Eigen::Vector2d& p0 = m_Waypoints[(segment + n - 1) % n];
+    const Eigen::Vector2d& p1 = m_Waypoints[segment % n];
+    const Eigen::Vector2d& p2 = m_Waypoints[(segment + 1) % n];
+    const Eigen::Vector2d& p3 = m_Waypoints[(segment + 2) % n];
+
+    // Cubic Hermite form with Catmull-Rom tangents
+    Eigen::Vector2d m1 = 0.5 * (p2 - p0);
+    Eigen::Vector2d m2 = 0.5 * (p3 - p1);
+    double t2 = t * t, t3 = t2 * t;
+    return (2 * t3 - 3 * t2 + 1) * p1 + (t3 - 2 * t2 + t) * m1 + (-2 * t3 + 3 * t2) * p2 + (t3 - t2) * m2;
+}
+
+Eigen::Vector2d SplinePath::pointAt(double s) const
+{
+    if (empty()) return Eigen::Vector2d::Zero();
+    if (m_Length <= 0) return points.front();
+
+    s = fmod(s, m_Length);
+    if (s < 0) s += m_Length;
+
+    size_t lower = sampleAt(s);
+    size_t upper = lower + 1;
+
+    double span = distance[upper] - distance[lower];
+    double a = (span > 0) ? (s - distance[lower]) / span : 0.0;
+    return points[lower] + a * (points[upper] - points[lower]);
+}
+
+size_t SplinePath::sampleAt(double s) const
+{
+    if (empty() || m_Length <= 0) return 0;
+
+    s = fmod(s, m_Length);
+    if (s < 0) s += m_Length;
+
+    size_t upper = static_cast<size_t>(std::upper_bound(distance.begin(), distance.end(), s) - distance.begin());
+    upper = std::clamp<size_t>(upper, 1, points.size() - 1);
+    return upper - 1;
+}
+
+size_t SplinePath::closestSample(const Eigen::Vector2d& pos, size_t hint) const
+{
+    if (empty()) return 0;
+
+    // The last sample repeats the first, so the loop has one less distinct sample
+    const size_t n = points.size() - 1;
+    size_t best = hint % n;
+    double bestDist = (points[best] - pos).squaredNorm();
+    size_t sinceBest = 0;
+    for (size_t k = 1; k < n && sinceBest < SPLINE_SEARCH_WINDOW; k++)
+    {
+        size_t i = (hint + k) % n;
+        double dist = (points[i] - pos).squaredNorm();
+        if (dist <= bestDist)
+        {
+            bestDist = dist;
+            best = i;
+            sinceBest = 0;
+        }
+        else
+        {
+            sinceBest++;
+        }
+    }
+
+    if (bestDist > SPLINE_LOST_DISTANCE * SPLINE_LOST_DISTANCE) return closestSample(pos);
+    return best;
+}
+
+size_t SplinePath::closestSample(const Eigen::Vector2d& pos) const
+{
+    if (empty()) return 0;
+
+    size_t best = 0;
+    double bestDist = (points[0] - pos).squaredNorm();
+    for (size_t i = 1; i + 1 < points.size(); i++)
+    {
+        double dist = (points[i] - pos).squaredNorm();
+        if (dist < bestDist)
+        {
+            bestDist = dist;
+            best = i;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <math.h>
+#include "VelocityProfile.hpp"
+
+// Samples in the loop, the spline repeats the first sample at the end.
+// Step lengths are taken from the points rather than the distance table, the table is a running sum so
+// its differences change in the last bits after a splice and would stop the passes from settling early.
+static size_t loopSize(const SplinePath& spline)
+{
+    return spline.empty() ? 0 : spline.points.size() - 1;
+}
+
+void VelocityProfile::build(const SplinePath& spline)
+{
+    const size_t n = loopSize(spline);
+    speedLimit.resize(n);
+    forward.resize(n);
+    speed.resize(n);
+    if (n == 0) return;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        speedLimit[i] = m_Limit(spline, i);
+        forward[i] = speedLimit[i];
+        speed[i] = speedLimit[i];
+    }
+
+    // Two laps so the passes settle across the wrap from wherever they start
+    for (size_t k = 0; k < 2 * n; k++) m_Forward(spline, k % n);
+    for (size_t k = 0; k < 2 * n; k++) m_Backward(spline, (2 * n - 1 - k) % n);
+    lastUpdateSamples = n;
+}
+
+void VelocityProfile::splice(const SplinePath& spline, size_t firstSample, size_t oldSamples, size_t newSamples)
+{
+    const size_t n = loopSize(spline);
+    if (n == 0 || speed.size() + newSamples != n + oldSamples || firstSample + oldSamples > speed.size())
+    {
+        build(spline);
+        return;
+    }
+
+    // New samples start at the old values, the passes below overwrite them
+    auto spliceVector = [&](std::vector<double>& values)
+    {
+        values.erase(values.begin() + firstSample, values.begin() + firstSample + oldSamples);
+        values.insert(values.begin() + firstSample, newSamples, 0.0);
+    };
+    spliceVector(speedLimit);
+    spliceVector(forward);
+    spliceVector(speed);
+
+    // The curvature at a sample uses its neighbours, so the samples either side are refreshed too
+    size_t first = (firstSample + n - 1) % n;
+    size_t count = std::min(newSamples + 2, n);
+    for (size_t k = 0; k < count; k++)
+    {
+        speedLimit[(first + k) % n] = m_Limit(spline, (first + k) % n);
+    }
+
+    // Forward through the changed samples then on until the old profile is met
+    size_t visited = 0;
+    size_t k = 0;
+    for (; k < n; k++)
+    {
+        bool bChanged = m_Forward(spline, (first + k) % n);
+        visited++;
+        if (k >= count && !bChanged) break;
+    }
+    size_t last = (first + std::min(k, n - 1)) % n;
+
+    // Backward from the end of the forward changes, through the splice and on until nothing changes
+    size_t span = std::min(k + 1, n);
+    for (size_t j = 0; j < n; j++)
+    {
+        bool bChanged = m_Backward(spline, (last + n - j) % n);
+        visited++;
+        if (j >= span && !bChanged) break;
+    }
+    lastUpdateSamples = visited;
+}
+
+double VelocityProfile::m_Limit(const SplinePath& spline, size_t i) const
+{
+    const size_t n = loopSize(spline);
+    const Eigen::Vector2d& a = spline.points[(i + n - 1) % n];
+    const Eigen::Vector2d& b = spline.points[i];
+    const Eigen::Vector2d& c = spline.points[(i + 1) % n];
+
+    // Curvature of the circle through three neighbouring samples
+    Eigen::Vector2d ab = b - a, bc = c - b;
+    double denominator = ab.norm() * bc.norm() * (c - a).norm();
+    double curvature = (denominator > 1e-12) ? fabs(2.0 * (ab.x() * bc.y() - ab.y() * bc.x())) / denominator : 0.0;
+
+    double limit = maxSpeed;
+    if (curvature > 1e-9) limit = std::min(limit, sqrt(maxLateralAccel / curvature));
+
+    // The outer wheel turns faster than the centre by 1 + k * w / 2
+    limit = std::min(limit, maxWheelSpeed / (1.0 + curvature * kinematics->trackWidth / 2.0));
+    return limit;
+}
+
+bool VelocityProfile::m_Forward(const SplinePath& spline, size_t i)
+{
+    const size_t n = loopSize(spline);
+    size_t previous = (i + n - 1) % n;
+    double ds = (spline.points[previous + 1] - spline.points[previous]).norm();
+
+    double v = std::min(speedLimit[i], sqrt(forward[previous] * forward[previous] + 2.0 * maxAccel * ds));
+    bool bChanged = v != forward[i];
+    forward[i] = v;
+    return bChanged;
+}
+
+bool VelocityProfile::m_Backward(const SplinePath& spline, size_t i)
+{
+    const size_t n = loopSize(spline);
+    size_t next = (i + 1) % n;
+    double ds = (spline.points[i + 1] - spline.points[i]).norm();
+
+    double v = std::min(forward[i], sqrt(speed[next] * speed[next] + 2.0 * maxDecel * ds));
+    bool bChanged = v != speed[i];
+    speed[i] = v;
+    return bChanged;
+}
@@ -147,6 +147,7 @@ void SerialInterface::dispatchPacketEvent(PacketType* packet, int eventCode)
 {
     SDL_Event event;
     event.type = SDL_EVENT_USER;
+    event.user.timestamp = SDL_GetTicksNS(); // Receive time, used to measure the inbound latency
     event.user.code = eventCode;
     event.user.data1 = packet;
     event.user.data2 = NULL;
@@ -192,6 +193,9 @@ void SerialInterface::m_SerialTask()
                 std::lock_guard<std::mutex> lock(m_Mutex);
                 m_WritePacket();
                 m_NewCommandPacket = false;
+
+                m_CommandDelayNS = SDL_GetTicksNS() - m_CommandQueuedNS;
+                m_NewCommandDelay = true;
             }
         }
     }
@@ -222,4 +226,12 @@ void SerialInterface::SetCommandVel(float velA, float velB)
     std::lock_guard<std::mutex> lock(m_Mutex);
     m_NewCommandPacket = true;
     m_LatestCommandPacket = {PACKET_HEADER, COMMAND_PACKET_ID, 0x00, velA, velB};
+    m_CommandQueuedNS = SDL_GetTicksNS();
+}
+
+bool SerialInterface::PopCommandDelay(double& delay)
+{
+    if (!m_NewCommandDelay.exchange(false)) return false;
+    delay = m_CommandDelayNS / 1e9 + TransmissionTime(sizeof(RobotCommandPacket));
+    return true;
 }
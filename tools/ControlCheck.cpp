@@ -0,0 +1,134 @@
+// Checks the control thread plumbing: the SeqLock snapshot and the fixed rate executor
+// Usage: ControlCheck [writes] [seconds]
+// A writer stores snapshots as fast as it can while a reader checks every load for a torn copy. Then the
+// executor runs at 50 Hz with one tick made to overrun, and every tick has to land on the original release
+// grid with the missed releases counted as overruns. Exits with 1 on a torn read or a timing failure.
+
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Localization/ControlExecutor.hpp"
+#include "Localization/SeqLock.hpp"
+
+#define CHECK_DEFAULT_WRITES 5000000
+#define CHECK_DEFAULT_SECONDS 4.0
+#define CHECK_RATE 50.0 // Hz
+#define CHECK_OVERRUN_TICK 100
+#define CHECK_OVERRUN_MS 45 // Over two periods, so two releases are missed
+#define CHECK_GRID_TOLERANCE 0.005 // s, wake up jitter allowed, a tick that slipped a release is a whole period off
+
+// Every field holds the same value, a torn copy mixes two writes
+struct Snapshot
+{
+    double values[6];
+    uint64_t sequence;
+};
+
+static bool checkSeqLock(uint64_t writes)
+{
+    SeqLock<Snapshot> lock;
+    std::atomic_bool bRunning = true;
+    std::atomic<uint64_t> reads = 0, torn = 0;
+
+    std::thread reader([&]()
+    {
+        while (bRunning)
+        {
+            Snapshot snapshot = lock.load();
+            for (double value : snapshot.values)
+            {
+                if (value != static_cast<double>(snapshot.sequence)) { torn++; break; }
+            }
+            reads++;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t n = 1; n <= writes; n++)
+    {
+        Snapshot snapshot;
+        std::fill(std::begin(snapshot.values), std::end(snapshot.values), static_cast<double>(n));
+        snapshot.sequence = n;
+        lock.store(snapshot);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    bRunning = false;
+    reader.join();
+
+    printf("SeqLock: %llu writes in %.1f ms, %llu reads, %llu torn\n",
+        static_cast<unsigned long long>(writes), ms, static_cast<unsigned long long>(reads.load()), static_cast<unsigned long long>(torn.load()));
+    return torn == 0;
+}
+
+static bool checkExecutor(double seconds)
+{
+    ControlExecutor executor;
+    std::vector<double> times;
+    times.reserve(static_cast<size_t>(seconds * CHECK_RATE * 2) + 16);
+
+    executor.start(CHECK_RATE, [&](double now)
+    {
+        times.push_back(now);
+        if (times.size() == CHECK_OVERRUN_TICK) std::this_thread::sleep_for(std::chrono::milliseconds(CHECK_OVERRUN_MS));
+    });
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    executor.stop();
+    ControlStats stats = executor.stats();
+
+    if (times.size() <= CHECK_OVERRUN_TICK + 1)
+    {
+        printf("CONTROL ERROR: Only %zu ticks ran\n", times.size());
+        return false;
+    }
+
+    // Releases are whole periods after the first one, each tick is off by the wake up jitter only
+    double period = 1.0 / CHECK_RATE;
+    double worstOffGrid = 0;
+    uint64_t skipped = 0;
+    double lastRelease = 0;
+    for (size_t i = 1; i < times.size(); i++)
+    {
+        double releases = (times[i] - times[0]) / period;
+        worstOffGrid = std::max(worstOffGrid, fabs(releases - round(releases)) * period);
+        skipped += static_cast<uint64_t>(std::max(0.0, round(releases) - lastRelease - 1));
+        lastRelease = round(releases);
+    }
+
+    printf("Executor: %llu ticks, %llu overruns, %llu releases skipped\n",
+        static_cast<unsigned long long>(stats.ticks), static_cast<unsigned long long>(stats.overruns), static_cast<unsigned long long>(skipped));
+    printf("  Jitter mean %.1f sd %.1f max %.1f us, exec mean %.1f max %.1f us\n", stats.meanJitter, stats.sdJitter, stats.maxJitter, stats.meanExec, stats.maxExec);
+    printf("  Around the overrun: %.2f ms, %.2f ms, worst offset from the grid %.3f ms\n",
+        (times[CHECK_OVERRUN_TICK] - times[CHECK_OVERRUN_TICK - 1]) * 1e3, (times[CHECK_OVERRUN_TICK + 1] - times[CHECK_OVERRUN_TICK]) * 1e3, worstOffGrid * 1e3);
+
+    bool bPass = true;
+    if (worstOffGrid > CHECK_GRID_TOLERANCE)
+    {
+        printf("CONTROL ERROR: A tick drifted %.3f ms off the release grid\n", worstOffGrid * 1e3);
+        bPass = false;
+    }
+    if (stats.overruns < 2 || stats.overruns != skipped)
+    {
+        printf("CONTROL ERROR: %llu overruns counted for %llu skipped releases\n",
+            static_cast<unsigned long long>(stats.overruns), static_cast<unsigned long long>(skipped));
+        bPass = false;
+    }
+    return bPass;
+}
+
+int main(int argc, char const *argv[])
+{
+    uint64_t writes = CHECK_DEFAULT_WRITES;
+    double seconds = CHECK_DEFAULT_SECONDS;
+    if (argc > 1) writes = std::max(atoll(argv[1]), 1LL);
+    if (argc > 2) seconds = std::max(atof(argv[2]), 3.0);
+
+    bool bPass = checkSeqLock(writes);
+    bPass &= checkExecutor(seconds);
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+// Benchmark of the EKF against the UKF on simulated encoder and range data
+// Usage: KalmanBench [runs] [steps]
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Localization/DiffDriveModel.hpp"
+#include "Localization/OdomKalmanFilter.hpp"
+#include "Localization/OdomUnscentedKalmanFilter.hpp"
+
+#define BENCH_WHEEL_RADIUS 0.03
+#define BENCH_CHASSIS_WIDTH 0.173
+#define BENCH_DT 0.02
+#define BENCH_RANGE_STDDEV 0.05
+#define BENCH_ENCODER_STDDEV 0.02
+#define BENCH_TIMING_ITERATIONS 1000000
+
+struct Scenario
+{
+    const char* name;
+    std::vector<Eigen::Vector2d> anchors;
+    Eigen::Vector3d start;
+    double forwardVel;
+    double turnRate;
+};
+
+struct Sample
+{
+    Eigen::Vector3d truth;
+    Eigen::Vector2d encoder;
+    int landmark;
+    double range;
+};
+
+struct ErrorStats
+{
+    double sqPos = 0;
+    double sqTheta = 0;
+    double maxPos = 0;
+    double nees = 0;
+    size_t count = 0;
+
+    void add(const Eigen::Vector3d& estimate, const Eigen::Matrix3d& P, const Eigen::Vector3d& truth)
+    {
+        Eigen::Vector3d error = estimate - truth;
+        error.z() = remainder(error.z(), 2.0 * M_PI);
+
+        double ePos = error.head<2>().norm();
+        double eTheta = error.z();
+        nees += error.dot(P.ldlt().solve(error));
+        sqPos += ePos * ePos;
+        sqTheta += eTheta * eTheta;
+        maxPos = (ePos > maxPos) ? ePos : maxPos;
+        count++;
+    }
+};
+
+// Drive a circle at constant wheel speeds, encoders slip and ranges are noisy
+static std::vector<Sample> simulate(const Scenario& scenario, int steps, std::mt19937& gen)
+{
+    std::normal_distribution<double> rangeNoise(0, BENCH_RANGE_STDDEV);
+    std::normal_distribution<double> encoderNoise(0, BENCH_ENCODER_STDDEV);
+
+    double omegaL = (scenario.forwardVel - scenario.turnRate * BENCH_CHASSIS_WIDTH / 2.0) / BENCH_WHEEL_RADIUS;
+    double omegaR = (scenario.forwardVel + scenario.turnRate * BENCH_CHASSIS_WIDTH / 2.0) / BENCH_WHEEL_RADIUS;
+
+    std::vector<Sample> samples(steps);
+    Eigen::Vector3d truth = scenario.start;
+    Eigen::Vector2d encoder = {0, 0};
+
+    for (int i = 0; i < steps; i++)
+    {
+        double dEncL = omegaL * BENCH_DT;
+        double dEncR = omegaR * BENCH_DT;
+
+        truth = DiffDriveModel::motion(truth, dEncL * BENCH_WHEEL_RADIUS, dEncR * BENCH_WHEEL_RADIUS, BENCH_CHASSIS_WIDTH);
+        encoder += Eigen::Vector2d(dEncL * (1.0 + encoderNoise(gen)), dEncR * (1.0 + encoderNoise(gen)));
+
+        Sample& sample = samples[i];
+        sample.truth = truth;
+        sample.encoder = encoder;
+        sample.landmark = i % static_cast<int>(scenario.anchors.size());
+        sample.range = (truth.head<2>() - scenario.anchors[sample.landmark]).norm() + rangeNoise(gen);
+    }
+    return samples;
+}
+
+template <typename Filter>
+static void runFilter(Filter& filter, const Scenario& scenario, const std::vector<Sample>& samples, ErrorStats& stats)
+{
+    AnchorTable anchors;
+    for (const Eigen::Vector2d& anchor : scenario.anchors) anchors.add(anchor);
+
+    filter.setAnchors(anchors);
+    filter.setPoseEstimate(scenario.start);
+    filter.P = Eigen::Matrix3d::Identity() * 1e-4;
+
+    for (const Sample& sample : samples)
+    {
+        filter.predict(sample.encoder, BENCH_DT);
+        filter.updateLandmark(sample.landmark, scenario.anchors[sample.landmark], sample.range);
+        stats.add(filter.x, filter.P, sample.truth);
+    }
+}
+
+// Average cost of one predict and one update in nanoseconds
+template <typename Filter>
+static void timeFilter(const char* name)
+{
+    Filter filter({0, -0.5, 0}, 1e-5, BENCH_RANGE_STDDEV * BENCH_RANGE_STDDEV);
+    AnchorTable anchors;
+    anchors.add({-0.725, 0});
+    anchors.add({0.725, 0});
+    filter.setAnchors(anchors);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_TIMING_ITERATIONS; i++)
+    {
+        filter.predict({i * 0.01, i * 0.011}, BENCH_DT);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_TIMING_ITERATIONS; i++)
+    {
+        filter.updateLandmark(0, anchors.position(0), 0.8 + 1e-3 * (i % 7));
+        filter.P = Eigen::Matrix3d::Identity() * 1e-2; // Keep the covariance from collapsing
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double predictNs = std::chrono::duration<double, std::nano>(mid - start).count() / BENCH_TIMING_ITERATIONS;
+    double updateNs = std::chrono::duration<double, std::nano>(end - mid).count() / BENCH_TIMING_ITERATIONS;
+    printf("%-6s predict: %8.1f ns   update: %8.1f ns   (x: %.3f)\n", name, predictNs, updateNs, filter.x.x());
+}
+
+static void printStats(const char* name, const ErrorStats& stats)
+{
+    printf("  %-6s pos RMSE: %.4f m   theta RMSE: %.4f rad   max pos error: %.4f m   mean NEES: %.2f\n",
+        name, sqrt(stats.sqPos / stats.count), sqrt(stats.sqTheta / stats.count), stats.maxPos, stats.nees / stats.count);
+}
+
+int main(int argc, char const *argv[])
+{
+    int runs = (argc > 1) ? atoi(argv[1]) : 100;
+    int steps = (argc > 2) ? atoi(argv[2]) : 3000;
+
+    const Scenario scenarios[] =
+    {
+        {"Centre loop", {{-0.725, 0}, {0.725, 0}}, {0.5, -0.5, M_PI_2}, 0.1, 0.2},
+        {"Anchor pass", {{-0.725, 0}, {0.725, 0}}, {-0.425, 0, M_PI_2}, 0.1, 0.333},
+        {"Six anchors", {{-1, -1}, {0, -1.2}, {1, -1}, {1, 1}, {0, 1.2}, {-1, 1}}, {0.5, -0.5, M_PI_2}, 0.1, 0.2},
+    };
+
+    printf("Cost per call (%d iterations)\n", BENCH_TIMING_ITERATIONS);
+    timeFilter<OdomKalmanFilter>("EKF");
+    timeFilter<OdomUnscentedKalmanFilter>("UKF");
+
+    printf("\nAccuracy (%d runs x %d steps)\n", runs, steps);
+    std::mt19937 gen(300);
+    for (const Scenario& scenario : scenarios)
+    {
+        ErrorStats ekfStats;
+        ErrorStats ukfStats;
+
+        for (int run = 0; run < runs; run++)
+        {
+            std::vector<Sample> samples = simulate(scenario, steps, gen);
+
+            OdomKalmanFilter ekf(scenario.start, 1e-5, BENCH_RANGE_STDDEV * BENCH_RANGE_STDDEV);
+            OdomUnscentedKalmanFilter ukf(scenario.start, 1e-5, BENCH_RANGE_STDDEV * BENCH_RANGE_STDDEV);
+
+            runFilter(ekf, scenario, samples, ekfStats);
+            runFilter(ukf, scenario, samples, ukfStats);
+        }
+
+        printf("%s\n", scenario.name);
+        printStats("EKF", ekfStats);
+        printStats("UKF", ukfStats);
+    }
+    return 0;
+}
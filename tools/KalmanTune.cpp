@@ -0,0 +1,234 @@
+// Tunes the EKF process and measurement noise by replaying recorded packet logs through the filter the app runs
+// Usage: KalmanTune <log> [log...] [--score nis|reference] [--q min max] [--r min max] [--grid n] [--threads n] [--out file]
+// nis scores how far the mean NIS is from 1, reference scores how well each range is predicted against the
+// measured anchor ranges, so neither mode depends on a run with a fixed noise
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Localization/LogReplay.hpp"
+#include "Localization/FilterTuning.hpp"
+
+#define TUNE_DEFAULT_Q_MIN 1e-8
+#define TUNE_DEFAULT_Q_MAX 1e-2
+#define TUNE_DEFAULT_R_MIN 1e-4
+#define TUNE_DEFAULT_R_MAX 1.0
+#define TUNE_DEFAULT_GRID 12 // Candidates per axis, per search pass
+#define TUNE_REFINE_PASSES 2 // Finer grids around the best candidate after the first pass
+#define TUNE_REJECT_WEIGHT 10.0 // NIS score penalty per fraction of ranges rejected by the gate
+
+enum ScoreMode { SCORE_NIS, SCORE_REFERENCE };
+
+struct Candidate
+{
+    double processNoise = 0;
+    double measurementNoise = 0;
+    double meanNis = 0;
+    double rejected = 0; // Fraction of ranges rejected
+    double rmse = 0;     // Range prediction error against the measured ranges (m)
+    double score = 0;
+};
+
+struct TuningContext
+{
+    std::vector<LogSegment> segments;
+    ScoreMode mode = SCORE_NIS;
+};
+
+// Replays every segment with the candidate noise and scores it, this is the unit of parallel work
+static void evaluate(const TuningContext& context, Candidate& candidate)
+{
+    RtsSmoother<3> steps;
+    std::vector<double> residuals;
+    size_t accepted = 0, rejected = 0, errorCount = 0;
+    double totalNis = 0, sqError = 0;
+
+    for (const LogSegment& segment : context.segments)
+    {
+        // Ranges are predicted before their own update, every range counts whether or not the gate takes it
+        residuals.clear();
+        OdomVelocityKalmanFilter filter({0, 0, 0}, candidate.processNoise, candidate.measurementNoise);
+        replaySegment(segment, filter, steps, nullptr, (context.mode == SCORE_REFERENCE) ? &residuals : nullptr);
+
+        accepted += filter.consistency.totalAccepted;
+        rejected += filter.consistency.totalRejected;
+        totalNis += filter.consistency.totalNis;
+        for (double residual : residuals) sqError += residual * residual;
+        errorCount += residuals.size();
+    }
+
+    candidate.meanNis = (accepted > 0) ? totalNis / accepted : 0.0;
+    candidate.rejected = (accepted + rejected > 0) ? static_cast<double>(rejected) / (accepted + rejected) : 1.0;
+    candidate.rmse = (errorCount > 0) ? sqrt(sqError / errorCount) : INFINITY;
+
+    if (context.mode == SCORE_REFERENCE)
+    {
+        candidate.score = candidate.rmse;
+    }
+    else
+    {
+        // A consistent filter has a mean NIS of 1 for a range, the log treats too high and too low alike
+        candidate.score = (candidate.meanNis > 0) ? fabs(log(candidate.meanNis)) + TUNE_REJECT_WEIGHT * candidate.rejected : INFINITY;
+    }
+}
+
+// Runs fn(i) for i in [0, count) on a pool of threads taking indices from a shared counter
+template <typename Fn>
+static void parallelFor(size_t count, unsigned int threadCount, Fn fn)
+{
+    std::atomic<size_t> next = 0;
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < std::min<size_t>(threadCount, count); i++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+}
+
+// Log spaced grid over [min, max] on both axes
+static std::vector<Candidate> makeGrid(double qMin, double qMax, double rMin, double rMax, int n)
+{
+    std::vector<Candidate> candidates;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            double a = (n > 1) ? static_cast<double>(i) / (n - 1) : 0.5;
+            double b = (n > 1) ? static_cast<double>(j) / (n - 1) : 0.5;
+
+            Candidate candidate;
+            candidate.processNoise = qMin * pow(qMax / qMin, a);
+            candidate.measurementNoise = rMin * pow(rMax / rMin, b);
+            candidates.push_back(candidate);
+        }
+    }
+    return candidates;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> paths;
+    std::string outPath = TUNING_DEFAULT_FILE;
+    double qMin = TUNE_DEFAULT_Q_MIN, qMax = TUNE_DEFAULT_Q_MAX;
+    double rMin = TUNE_DEFAULT_R_MIN, rMax = TUNE_DEFAULT_R_MAX;
+    int gridSize = TUNE_DEFAULT_GRID;
+    unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    TuningContext context;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--score") == 0 && i + 1 < argc)
+        {
+            context.mode = (strcmp(argv[++i], "reference") == 0) ? SCORE_REFERENCE : SCORE_NIS;
+        }
+        else if (strcmp(argv[i], "--q") == 0 && i + 2 < argc)
+        {
+            qMin = atof(argv[i + 1]);
+            qMax = atof(argv[i + 2]);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--r") == 0 && i + 2 < argc)
+        {
+            rMin = atof(argv[i + 1]);
+            rMax = atof(argv[i + 2]);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+        {
+            gridSize = std::max(atoi(argv[++i]), 2);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = std::max(atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty() || qMin <= 0 || qMax < qMin || rMin <= 0 || rMax < rMin)
+    {
+        printf("Usage: KalmanTune <log> [log...] [--score nis|reference] [--q min max] [--r min max] [--grid n] [--threads n] [--out file]\n");
+        return 1;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<LogFile> logs(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (logs[i].load(paths[i])) splitSegments(logs[i], context.segments);
+    }
+    if (context.segments.empty())
+    {
+        printf("TUNE ERROR: No usable log segments\n");
+        return 1;
+    }
+
+    // Coarse grid over the whole range, then finer grids spanning one step either side of the best
+    Candidate best;
+    best.score = INFINITY;
+    size_t evaluated = 0;
+    double qLo = qMin, qHi = qMax, rLo = rMin, rHi = rMax;
+
+    for (int pass = 0; pass <= TUNE_REFINE_PASSES; pass++)
+    {
+        std::vector<Candidate> candidates = makeGrid(qLo, qHi, rLo, rHi, gridSize);
+        parallelFor(candidates.size(), threadCount, [&](size_t i) { evaluate(context, candidates[i]); });
+        evaluated += candidates.size();
+
+        for (const Candidate& candidate : candidates)
+        {
+            if (candidate.score < best.score) best = candidate;
+        }
+        printf("Pass %d: Q %.3g R %.3g | mean NIS %.3f | rejected %.2f%% | score %.4f", pass,
+            best.processNoise, best.measurementNoise, best.meanNis, best.rejected * 100.0, best.score);
+        if (context.mode == SCORE_REFERENCE) printf(" | range RMSE %.4f m", best.rmse);
+        printf("\n");
+
+        double qStep = pow(qHi / qLo, 1.0 / (gridSize - 1));
+        double rStep = pow(rHi / rLo, 1.0 / (gridSize - 1));
+        qLo = best.processNoise / qStep;
+        qHi = best.processNoise * qStep;
+        rLo = best.measurementNoise / rStep;
+        rHi = best.measurementNoise * rStep;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    printf("%zu candidates over %zu segments in %.2f s on %u threads\n", evaluated, context.segments.size(), elapsed, threadCount);
+    if (context.mode == SCORE_NIS)
+    {
+        printf("Note: a mean NIS of 1 is reached along a curve of Q and R, check the result with --score reference\n");
+    }
+    printf("Note: Q and R are the pose noise of the app's velocity filter, its wheel speed noise keeps the defaults\n");
+
+    FilterTuning tuning;
+    tuning.processNoise = best.processNoise;
+    tuning.measurementNoise = best.measurementNoise;
+    tuning.score = best.score;
+    return tuning.save(outPath) ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// Smoothed trajectories from recorded packet logs, EKF forward pass then an RTS backward pass
+// Usage: LogSmoother <log> [log...] [--out file.csv] [--threads n] [--start x y theta]
+// Logs are split into independent segments at gaps and robot resets, which are smoothed in parallel
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Localization/LogReplay.hpp"
+
+#define SMOOTH_PROCESS_NOISE 1e-5
+#define SMOOTH_MEASUREMENT_NOISE 0.01
+#define SMOOTH_MIN_STEPS 10 // Shorter segments are dropped
+
+struct SegmentResult
+{
+    RtsSmoother<3> smoother;
+    size_t accepted = 0;
+    size_t rejected = 0;
+    bool bValid = false;
+};
+
+// Forward EKF over the segment recording every step, then the backward pass
+static void smoothSegment(const LogSegment& segment, const Eigen::Vector3d* start, SegmentResult& result)
+{
+    OdomVelocityKalmanFilter filter({0, 0, 0}, SMOOTH_PROCESS_NOISE, SMOOTH_MEASUREMENT_NOISE);
+    replaySegment(segment, filter, result.smoother, start);
+
+    result.accepted = filter.consistency.totalAccepted;
+    result.rejected = filter.consistency.totalRejected;
+    result.bValid = result.smoother.size() >= SMOOTH_MIN_STEPS;
+    if (result.bValid) result.smoother.smooth();
+}
+
+static bool writeTrajectories(const std::string& path, const std::vector<SegmentResult>& results)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        printf("SMOOTHER ERROR: Unable to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    file << "segment,time,x,y,theta,filtered_x,filtered_y,filtered_theta,std_x,std_y,std_theta\n";
+    char line[256];
+    for (size_t s = 0; s < results.size(); s++)
+    {
+        if (!results[s].bValid) continue;
+        for (const RtsSmoother<3>::Step& step : results[s].smoother.steps)
+        {
+            snprintf(line, sizeof(line), "%zu,%.6f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f\n", s, step.time,
+                step.xSmooth.x(), step.xSmooth.y(), step.xSmooth.z(), step.x.x(), step.x.y(), step.x.z(),
+                sqrt(step.PSmooth(0, 0)), sqrt(step.PSmooth(1, 1)), sqrt(step.PSmooth(2, 2)));
+            file << line;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> paths;
+    std::string outPath = "smoothed.csv";
+    unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    Eigen::Vector3d start(0, 0, 0);
+    bool bHaveStart = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = std::max(atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "--start") == 0 && i + 3 < argc)
+        {
+            start = {atof(argv[i + 1]), atof(argv[i + 2]), atof(argv[i + 3])};
+            bHaveStart = true;
+            i += 3;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty())
+    {
+        printf("Usage: LogSmoother <log> [log...] [--out file.csv] [--threads n] [--start x y theta]\n");
+        return 1;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<LogFile> logs(paths.size());
+    std::vector<LogSegment> segments;
+    double duration = 0;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (!logs[i].load(paths[i])) continue;
+        duration += logs[i].duration();
+        splitSegments(logs[i], segments);
+    }
+
+    // Segments are handed out to the workers one at a time, long and short segments balance out
+    std::vector<SegmentResult> results(segments.size());
+    std::atomic<size_t> nextSegment = 0;
+    auto worker = [&]()
+    {
+        for (size_t i = nextSegment++; i < segments.size(); i = nextSegment++)
+        {
+            smoothSegment(segments[i], bHaveStart ? &start : nullptr, results[i]);
+        }
+    };
+
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, std::max<size_t>(segments.size(), 1)));
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    size_t steps = 0, valid = 0, accepted = 0, rejected = 0;
+    double correction = 0;
+    for (const SegmentResult& result : results)
+    {
+        if (!result.bValid) continue;
+        for (const RtsSmoother<3>::Step& step : result.smoother.steps)
+        {
+            correction += (step.xSmooth.head<2>() - step.x.head<2>()).norm();
+        }
+        steps += result.smoother.size();
+        accepted += result.accepted;
+        rejected += result.rejected;
+        valid++;
+    }
+
+    printf("%zu logs, %.1f s recorded, %zu/%zu segments smoothed, %zu steps\n", logs.size(), duration, valid, segments.size(), steps);
+    printf("Ranges: %zu accepted, %zu rejected | Mean smoothing correction: %.4f m\n", accepted, rejected, (steps > 0) ? correction / steps : 0.0);
+    printf("Processed in %.3f s on %u threads\n", elapsed, threadCount);
+
+    return writeTrajectories(outPath, results) ? 0 : 1;
+}
@@ -0,0 +1,350 @@
+// Monte Carlo accuracy and throughput harness for the EKF and the constant position filter
+// Usage: MonteCarlo [trials] [steps] [--threads n] [--seed s] [--save file] [--compare file]
+// Every trial draws its own anchor layout and trajectory from a seed derived from the trial index,
+// so results do not depend on the thread count. --compare exits with 1 on an accuracy or speed regression.
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Localization/DiffDriveModel.hpp"
+#include "Localization/LandmarkContainer.hpp"
+#include "Localization/OdomKalmanFilter.hpp"
+#include "Localization/ConstPosKalmanFilter.hpp"
+
+#define MC_DEFAULT_TRIALS 2000
+#define MC_DEFAULT_STEPS 1500
+#define MC_DEFAULT_SEED 300
+#define MC_DT 0.02
+#define MC_AREA_SIZE 3.0 // Side of the square the robot and anchors are placed in (m)
+#define MC_MIN_ANCHORS 2
+#define MC_MAX_ANCHORS 6
+#define MC_MIN_ANCHOR_SPACING 0.5
+#define MC_RANGE_STDDEV 0.05
+#define MC_ENCODER_STDDEV 0.02 // Fractional wheel slip per step
+#define MC_INITIAL_POS_STDDEV 0.1
+#define MC_INITIAL_THETA_STDDEV 0.2
+#define MC_PROCESS_NOISE 1e-5
+#define MC_DIVERGED_ERROR 0.5 // Final position error counted as a divergence (m)
+#define MC_RMSE_TOLERANCE 0.02 // Allowed relative increase in RMSE against a saved baseline
+#define MC_SPEED_TOLERANCE 0.15 // Allowed relative drop in throughput, timings are noisy
+
+struct Trial
+{
+    std::vector<Eigen::Vector2d> anchors;
+    std::vector<Eigen::Vector3d> truth;
+    std::vector<Eigen::Vector2d> encoder;
+    std::vector<Eigen::VectorXd> ranges; // Every anchor, every step
+    Eigen::Vector3d initialEstimate;
+};
+
+struct FilterStats
+{
+    double sqPos = 0;
+    double sqTheta = 0;
+    double nees = 0;
+    double nis = 0;
+    size_t nisCount = 0;
+    size_t count = 0;
+    size_t diverged = 0;
+    size_t steps = 0;
+    double seconds = 0; // Time spent inside the filter calls
+
+    void add(const FilterStats& other)
+    {
+        sqPos += other.sqPos;
+        sqTheta += other.sqTheta;
+        nees += other.nees;
+        nis += other.nis;
+        nisCount += other.nisCount;
+        count += other.count;
+        diverged += other.diverged;
+        steps += other.steps;
+        seconds += other.seconds;
+    }
+
+    double posRmse() const { return (count > 0) ? sqrt(sqPos / count) : 0.0; }
+    double thetaRmse() const { return (count > 0) ? sqrt(sqTheta / count) : 0.0; }
+    double meanNees() const { return (count > 0) ? nees / count : 0.0; }
+    double meanNis() const { return (nisCount > 0) ? nis / nisCount : 0.0; }
+    double stepsPerSecond() const { return (seconds > 0) ? steps / seconds : 0.0; }
+};
+
+// Random anchors, then piecewise constant wheel speeds that steer back towards the centre near the edge
+static Trial simulate(int steps, std::mt19937& gen)
+{
+    std::uniform_real_distribution<double> area(-MC_AREA_SIZE / 2.0, MC_AREA_SIZE / 2.0);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    std::uniform_real_distribution<double> speed(0.05, 0.2);
+    std::uniform_real_distribution<double> turnRate(-1.0, 1.0);
+    std::uniform_real_distribution<double> segmentTime(1.0, 3.0);
+    std::uniform_int_distribution<int> anchorCount(MC_MIN_ANCHORS, MC_MAX_ANCHORS);
+    std::normal_distribution<double> noise(0, 1);
+
+    Trial trial;
+    int n = anchorCount(gen);
+    while (static_cast<int>(trial.anchors.size()) < n)
+    {
+        Eigen::Vector2d anchor(area(gen), area(gen));
+        bool bSpaced = true;
+        for (const Eigen::Vector2d& other : trial.anchors)
+        {
+            bSpaced &= (anchor - other).norm() > MC_MIN_ANCHOR_SPACING;
+        }
+        if (bSpaced) trial.anchors.push_back(anchor);
+    }
+
+    LandmarkContainer landmarks(trial.anchors);
+    const KinematicParams& kinematics = KinematicParams::GetShared();
+
+    Eigen::Vector3d truth(area(gen) / 2.0, area(gen) / 2.0, heading(gen));
+    trial.initialEstimate = truth + Eigen::Vector3d(noise(gen) * MC_INITIAL_POS_STDDEV, noise(gen) * MC_INITIAL_POS_STDDEV, noise(gen) * MC_INITIAL_THETA_STDDEV);
+
+    Eigen::Vector2d encoder(0, 0);
+    double v = speed(gen), omega = turnRate(gen);
+    double segmentLeft = segmentTime(gen);
+
+    trial.truth.reserve(steps);
+    trial.encoder.reserve(steps);
+    trial.ranges.reserve(steps);
+
+    for (int i = 0; i < steps; i++)
+    {
+        segmentLeft -= MC_DT;
+        if (segmentLeft <= 0)
+        {
+            v = speed(gen);
+            omega = turnRate(gen);
+            segmentLeft = segmentTime(gen);
+        }
+        if (truth.head<2>().norm() > MC_AREA_SIZE / 2.0)
+        {
+            double toCentre = atan2(-truth.y(), -truth.x());
+            omega = std::clamp(2.0 * remainder(toCentre - truth.z(), 2.0 * M_PI), -2.0, 2.0);
+        }
+
+        double dEncL = (v - omega * kinematics.trackWidth / 2.0) / kinematics.wheelRadiusL * MC_DT;
+        double dEncR = (v + omega * kinematics.trackWidth / 2.0) / kinematics.wheelRadiusR * MC_DT;
+        truth = DiffDriveModel::motion(truth, dEncL * kinematics.wheelRadiusL, dEncR * kinematics.wheelRadiusR, kinematics.trackWidth);
+        encoder += Eigen::Vector2d(dEncL * (1.0 + MC_ENCODER_STDDEV * noise(gen)), dEncR * (1.0 + MC_ENCODER_STDDEV * noise(gen)));
+
+        landmarks.simulateRange(truth.head<2>(), MC_RANGE_STDDEV, gen);
+        const AnchorTable& anchors = landmarks.getAnchors();
+
+        trial.truth.push_back(truth);
+        trial.encoder.push_back(encoder);
+        trial.ranges.push_back(Eigen::Map<const Eigen::VectorXd>(anchors.range.data(), static_cast<Eigen::Index>(anchors.size())));
+    }
+    return trial;
+}
+
+// One range per step in turn, as the robot reports them
+static void runOdomFilter(const Trial& trial, FilterStats& stats)
+{
+    AnchorTable anchors;
+    for (const Eigen::Vector2d& anchor : trial.anchors) anchors.add(anchor);
+
+    OdomKalmanFilter filter(trial.initialEstimate, MC_PROCESS_NOISE, MC_RANGE_STDDEV * MC_RANGE_STDDEV);
+    filter.setAnchors(anchors);
+    filter.P = Eigen::Vector3d(MC_INITIAL_POS_STDDEV * MC_INITIAL_POS_STDDEV, MC_INITIAL_POS_STDDEV * MC_INITIAL_POS_STDDEV, MC_INITIAL_THETA_STDDEV * MC_INITIAL_THETA_STDDEV).asDiagonal();
+
+    const size_t steps = trial.truth.size();
+    std::vector<Eigen::Vector3d> estimates(steps);
+    std::vector<Eigen::Matrix3d> covariances(steps);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; i++)
+    {
+        int landmark = static_cast<int>(i % trial.anchors.size());
+        filter.predict(trial.encoder[i], MC_DT);
+        filter.updateLandmark(landmark, trial.anchors[landmark], trial.ranges[i](landmark));
+        estimates[i] = filter.x;
+        covariances[i] = filter.P;
+    }
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.steps += steps;
+
+    for (size_t i = 0; i < steps; i++)
+    {
+        Eigen::Vector3d error = estimates[i] - trial.truth[i];
+        error.z() = remainder(error.z(), 2.0 * M_PI);
+        stats.sqPos += error.head<2>().squaredNorm();
+        stats.sqTheta += error.z() * error.z();
+        stats.nees += error.dot(covariances[i].ldlt().solve(error));
+        stats.count++;
+    }
+    stats.nis += filter.consistency.totalNis;
+    stats.nisCount += filter.consistency.totalAccepted;
+    if ((estimates.back() - trial.truth.back()).head<2>().norm() > MC_DIVERGED_ERROR) stats.diverged++;
+}
+
+// Every range each step, the filter has no motion model
+static void runConstPosFilter(const Trial& trial, FilterStats& stats)
+{
+    AnchorTable anchors;
+    for (const Eigen::Vector2d& anchor : trial.anchors) anchors.add(anchor);
+
+    ConstPosKalmanFilter filter(trial.initialEstimate.head<2>(), MC_PROCESS_NOISE, MC_RANGE_STDDEV * MC_RANGE_STDDEV);
+    filter.setAnchors(anchors);
+    filter.P = Eigen::Matrix2d::Identity() * MC_INITIAL_POS_STDDEV * MC_INITIAL_POS_STDDEV;
+
+    const size_t steps = trial.truth.size();
+    std::vector<Eigen::Vector2d> estimates(steps);
+    std::vector<Eigen::Matrix2d> covariances(steps);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; i++)
+    {
+        filter.predict({0, 0}, MC_DT);
+        filter.update(trial.ranges[i], MC_DT);
+        estimates[i] = filter.x;
+        covariances[i] = filter.P;
+    }
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.steps += steps;
+
+    for (size_t i = 0; i < steps; i++)
+    {
+        Eigen::Vector2d error = estimates[i] - trial.truth[i].head<2>();
+        stats.sqPos += error.squaredNorm();
+        stats.nees += error.dot(covariances[i].ldlt().solve(error));
+        stats.count++;
+    }
+    if ((estimates.back() - trial.truth.back().head<2>()).norm() > MC_DIVERGED_ERROR) stats.diverged++;
+}
+
+static void printStats(const char* name, const FilterStats& stats, int trials, int dof)
+{
+    printf("  %-8s pos RMSE: %.4f m", name, stats.posRmse());
+    if (dof == 3) printf("   theta RMSE: %.4f rad   mean NIS: %.2f", stats.thetaRmse(), stats.meanNis());
+    printf("   mean NEES: %.2f (%d DOF)   diverged: %.2f%%   %.2f M steps/s\n",
+        stats.meanNees(), dof, 100.0 * stats.diverged / std::max(trials, 1), stats.stepsPerSecond() / 1e6);
+}
+
+static bool saveBaseline(const std::string& path, const FilterStats& odom, const FilterStats& constPos)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        printf("MONTECARLO ERROR: Unable to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    file.precision(9);
+    file << "odomPosRmse " << odom.posRmse() << "\n";
+    file << "odomStepsPerSecond " << odom.stepsPerSecond() << "\n";
+    file << "constPosPosRmse " << constPos.posRmse() << "\n";
+    file << "constPosStepsPerSecond " << constPos.stepsPerSecond() << "\n";
+    return true;
+}
+
+// Returns false if accuracy or throughput regressed past the tolerances
+static bool compareBaseline(const std::string& path, const FilterStats& odom, const FilterStats& constPos)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        printf("MONTECARLO ERROR: Unable to open baseline %s\n", path.c_str());
+        return false;
+    }
+
+    std::string key;
+    double value;
+    bool bPass = true;
+    while (file >> key >> value)
+    {
+        double current = 0;
+        bool bLowerIsBetter = true;
+        if (key == "odomPosRmse") current = odom.posRmse();
+        else if (key == "constPosPosRmse") current = constPos.posRmse();
+        else if (key == "odomStepsPerSecond") { current = odom.stepsPerSecond(); bLowerIsBetter = false; }
+        else if (key == "constPosStepsPerSecond") { current = constPos.stepsPerSecond(); bLowerIsBetter = false; }
+        else continue;
+
+        bool bRegressed = bLowerIsBetter ? current > value * (1.0 + MC_RMSE_TOLERANCE) : current < value * (1.0 - MC_SPEED_TOLERANCE);
+        printf("  %-24s baseline %12.6g   current %12.6g   %s\n", key.c_str(), value, current, bRegressed ? "REGRESSED" : "ok");
+        bPass &= !bRegressed;
+    }
+    return bPass;
+}
+
+int main(int argc, char const *argv[])
+{
+    int trials = MC_DEFAULT_TRIALS;
+    int steps = MC_DEFAULT_STEPS;
+    unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    unsigned int seed = MC_DEFAULT_SEED;
+    std::string savePath, comparePath;
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) savePath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) comparePath = argv[++i];
+        else if (positional == 0) { trials = std::max(atoi(argv[i]), 1); positional++; }
+        else if (positional == 1) { steps = std::max(atoi(argv[i]), 1); positional++; }
+    }
+
+    FilterStats odomTotal, constPosTotal;
+    std::mutex statsMutex;
+    std::atomic<int> nextTrial = 0;
+
+    // Each worker keeps its own totals and merges them once at the end
+    auto worker = [&]()
+    {
+        FilterStats odom, constPos;
+        for (int trial = nextTrial++; trial < trials; trial = nextTrial++)
+        {
+            std::mt19937 gen(seed + static_cast<unsigned int>(trial));
+            Trial data = simulate(steps, gen);
+            runOdomFilter(data, odom);
+            runConstPosFilter(data, constPos);
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        odomTotal.add(odom);
+        constPosTotal.add(constPos);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < std::min<unsigned int>(threadCount, static_cast<unsigned int>(trials)); i++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%d trials x %d steps on %zu threads in %.2f s (seed %u)\n", trials, steps, workers.size(), elapsed, seed);
+    printStats("EKF", odomTotal, trials, 3);
+    printStats("ConstPos", constPosTotal, trials, 2);
+    printf("  Throughput is per core, filter calls only\n");
+
+    if (!savePath.empty() && !saveBaseline(savePath, odomTotal, constPosTotal)) return 1;
+    if (!comparePath.empty())
+    {
+        printf("\nBaseline comparison\n");
+        if (!compareBaseline(comparePath, odomTotal, constPosTotal))
+        {
+            printf("MONTECARLO ERROR: Regression against %s\n", comparePath.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Checks incremental D* Lite repairs against a fresh search on the same grid
+// Usage: PlannerCheck [map size m] [--seed s]
+// A planner is kept alive through obstacle edits on its path, erasures while the robot moves, a wall that
+// forces the restart fallback and a walled in goal. After each step the cost to go from the robot must match
+// a planner that searched the edited grid from scratch, and the repair may not cost much more than that
+// search did. An update with nothing changed must not search or extract the path again.
+// Exits with 1 on a mismatch, a repair slower than the fresh search or a busy idle update.
+
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Localization/OccupancyGrid.hpp"
+#include "Localization/GridPlanner.hpp"
+
+#define CHECK_DEFAULT_SIZE 20.0 // m, 2000 x 2000 cells at the default resolution
+#define CHECK_DEFAULT_SEED 3
+#define CHECK_OBSTACLES 400
+#define CHECK_OBSTACLE_RADIUS 0.15 // m
+#define CHECK_EDITS 5
+#define CHECK_COST_TOLERANCE 1e-4 // Relative, equal cost routes can sum in a different order
+#define CHECK_MAX_REPAIR_RATIO 1.6 // Repair expansions against the fresh search, the restart share plus the search itself
+#define CHECK_IDLE_MS 1.0 // An update with nothing to do
+
+struct Settled
+{
+    double ms = 0;
+    size_t expansions = 0;
+    int frames = 0;
+};
+
+// Runs updates at the frame budget until the search settles
+static Settled settle(GridPlanner& planner, const Eigen::Vector2d& start)
+{
+    Settled result;
+    do
+    {
+        planner.update(start);
+        result.ms += planner.lastPlanTime;
+        result.expansions += planner.lastExpansions;
+        result.frames++;
+    } while (planner.bSearching);
+    return result;
+}
+
+static bool check(const char* step, GridPlanner& planner, const OccupancyGrid& grid, const Eigen::Vector2d& start, const Eigen::Vector2d& goal)
+{
+    Settled repair = settle(planner, start);
+
+    GridPlanner fresh(grid);
+    fresh.bEnabled = true;
+    fresh.maxExpansions = 1 << 30;
+    fresh.setGoal(goal);
+    fresh.update(start);
+
+    float cost = planner.startCost(), freshCost = fresh.startCost();
+    bool bMatch = (isinf(cost) || isinf(freshCost)) ? (isinf(cost) && isinf(freshCost))
+        : fabs(cost - freshCost) <= CHECK_COST_TOLERANCE * std::max(1.0f, freshCost);
+
+    // One frame of budget is always allowed, small repairs can overshoot a small fresh search
+    bool bCheap = repair.expansions <= CHECK_MAX_REPAIR_RATIO * fresh.lastExpansions + planner.maxExpansions;
+    printf("  %-12s repair %8.2f ms, %8zu expansions, %3d frames | fresh %8.2f ms, %8zu expansions | cost %.2f / %.2f%s%s\n",
+        step, repair.ms, repair.expansions, repair.frames, fresh.lastPlanTime, fresh.lastExpansions, cost, freshCost,
+        bMatch ? "" : " MISMATCH", bCheap ? "" : " SLOW");
+    if (!bCheap) printf("PLANNER ERROR: Repair took %zu expansions against %zu for a fresh search\n", repair.expansions, fresh.lastExpansions);
+    return bMatch && bCheap && planner.bPathFound == fresh.bPathFound;
+}
+
+int main(int argc, char const *argv[])
+{
+    double size = CHECK_DEFAULT_SIZE;
+    unsigned int seed = CHECK_DEFAULT_SEED;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else size = std::max(atof(argv[i]), 2.0);
+    }
+
+    OccupancyGrid grid({0, 0}, {size, size});
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> position(-0.475 * size, 0.475 * size);
+    for (int i = 0; i < CHECK_OBSTACLES; i++)
+    {
+        grid.paint({position(gen), position(gen)}, CHECK_OBSTACLE_RADIUS, true);
+    }
+
+    Eigen::Vector2d start(-0.48 * size, -0.48 * size), goal(0.48 * size, 0.48 * size);
+    grid.paint(start, 0.2, false);
+    grid.paint(goal, 0.2, false);
+    printf("%d x %d cells, %d obstacles (seed %u)\n", grid.width, grid.height, CHECK_OBSTACLES, seed);
+
+    GridPlanner planner(grid);
+    planner.bEnabled = true;
+    planner.setGoal(goal);
+    bool bPass = check("initial", planner, grid, start, goal);
+
+    // Block the path a little ahead of the robot each time
+    for (int k = 0; k < CHECK_EDITS && bPass && planner.path.size() > 1; k++)
+    {
+        size_t i = std::min<size_t>(planner.path.size() - 2, 1 + k * 3);
+        planner.onGridChanged(grid.paint(0.5 * (planner.path[i] + planner.path[i + 1]), 0.1, true));
+        bPass &= check("block", planner, grid, start, goal);
+    }
+
+    // Clear around the path while the robot drives along it, the start moves and km grows
+    for (int k = 0; k < CHECK_EDITS && bPass && planner.path.size() > 1; k++)
+    {
+        start += (planner.path[1] - start).normalized() * 0.05;
+        planner.onGridChanged(grid.paint(planner.path[std::min<size_t>(planner.path.size() - 1, 3)], 0.3, false));
+        bPass &= check("move", planner, grid, start, goal);
+    }
+
+    // Nothing changed, the settled search and the path are kept as they are
+    if (bPass)
+    {
+        Settled idle = settle(planner, start);
+        printf("  %-12s update %8.3f ms, %8zu expansions\n", "idle", idle.ms, idle.expansions);
+        if (idle.expansions > 0 || idle.ms > CHECK_IDLE_MS)
+        {
+            printf("PLANNER ERROR: An update with nothing changed took %.3f ms and %zu expansions\n", idle.ms, idle.expansions);
+            bPass = false;
+        }
+    }
+
+    // A wall across the map just ahead of the robot with a gap at the far end, the repair reopens most of the map
+    if (bPass)
+    {
+        size_t restarts = planner.restarts;
+        GridRect changed;
+        for (double x = -0.5 * size; x < 0.4 * size; x += 0.02) changed.merge(grid.paint({x, start.y() + 0.15 * size}, 0.05, true));
+        planner.onGridChanged(changed);
+        bPass &= check("wall", planner, grid, start, goal);
+        printf("  Restarts during the wall repair: %zu\n", planner.restarts - restarts);
+    }
+
+    // Nothing reaches a walled in goal, the planner has to say so rather than flood the map
+    if (bPass)
+    {
+        planner.onGridChanged(grid.paint(goal, 0.5, true));
+        bPass &= check("goal walled", planner, grid, start, goal);
+    }
+
+    if (!bPass)
+    {
+        printf("PLANNER ERROR: Repaired search does not match a fresh one\n");
+        return 1;
+    }
+    return 0;
+}
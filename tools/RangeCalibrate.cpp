@@ -0,0 +1,151 @@
+// Fits the range quality model (rxPower -> range variance) to recorded packet logs
+// Usage: RangeCalibrate <log> [log...] [--truth x y] [--out file]
+// Without --truth the residuals are taken against an EKF replay of the log
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "PacketLog.hpp"
+#include "Localization/LandmarkContainer.hpp"
+#include "Localization/OdomKalmanFilter.hpp"
+#include "Localization/RangeQualityModel.hpp"
+
+#define CAL_PROCESS_NOISE 1e-5
+#define CAL_MEASUREMENT_NOISE 0.01
+#define CAL_WARMUP_TIME 5.0 // Residuals are ignored while the replayed filter converges (s)
+
+struct CalibrationSamples
+{
+    std::vector<double> rxPower;
+    std::vector<double> residuals;
+};
+
+static bool collectSamples(const std::string& path, bool bHaveTruth, const Eigen::Vector2d& truth, CalibrationSamples& samples)
+{
+    std::vector<PacketLogRecord> records;
+    AnchorTable anchors;
+    if (!PacketLogReader::load(path, records, anchors) || records.empty())
+    {
+        printf("CALIBRATE ERROR: Unable to read %s\n", path.c_str());
+        return false;
+    }
+    if (anchors.size() == 0)
+    {
+        printf("CALIBRATE ERROR: %s has no anchor records\n", path.c_str());
+        return false;
+    }
+
+    LandmarkContainer landmarks;
+    landmarks.getAnchors() = anchors;
+
+    OdomKalmanFilter filter({truth.x(), truth.y(), 0}, CAL_PROCESS_NOISE, CAL_MEASUREMENT_NOISE);
+    filter.setAnchors(anchors);
+    filter.bGating = false;
+
+    const double startTime = records.front().timestamp;
+    double lastEncoderTime = -1;
+    size_t used = 0;
+
+    for (const PacketLogRecord& record : records)
+    {
+        EncoderDataPacket encoder;
+        LandmarkPacket landmark;
+
+        if (record.recordID == ENCODER_PACKET_ID && record.as(encoder))
+        {
+            // The first packet only sets the encoder reference
+            if (lastEncoderTime < 0)
+            {
+                filter.encoderA = encoder.encA;
+                filter.encoderB = encoder.encB;
+            }
+            filter.predict({encoder.encA, encoder.encB}, (lastEncoderTime < 0) ? 0 : record.timestamp - lastEncoderTime);
+            lastEncoderTime = record.timestamp;
+        }
+        else if (record.recordID == LANDMARK_PACKET_ID && record.as(landmark))
+        {
+            if (!landmarks.OnNewPacket(&landmark, record.timestamp)) continue;
+
+            int index = AnchorTable::indexFromId(landmark.LandmarkID);
+            Eigen::Vector2d anchorPos = anchors.position(index);
+            double range = landmarks.getLandmarkRange(index);
+
+            Eigen::Vector2d pos = bHaveTruth ? truth : Eigen::Vector2d(filter.x.head<2>());
+            if (record.timestamp - startTime > CAL_WARMUP_TIME || bHaveTruth)
+            {
+                samples.rxPower.push_back(landmark.rxPower);
+                samples.residuals.push_back(range - (pos - anchorPos).norm());
+                used++;
+            }
+
+            filter.updateLandmark(index, anchorPos, range);
+        }
+    }
+
+    printf("%s: %zu records, %zu anchors, %zu range samples\n", path.c_str(), records.size(), anchors.size(), used);
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> logs;
+    std::string outPath = RQ_DEFAULT_FILE;
+    Eigen::Vector2d truth(0, 0);
+    bool bHaveTruth = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--truth") == 0 && i + 2 < argc)
+        {
+            truth = {atof(argv[i + 1]), atof(argv[i + 2])};
+            bHaveTruth = true;
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            logs.push_back(argv[i]);
+        }
+    }
+
+    if (logs.empty())
+    {
+        printf("Usage: RangeCalibrate <log> [log...] [--truth x y] [--out file]\n");
+        return 1;
+    }
+
+    CalibrationSamples samples;
+    for (const std::string& log : logs)
+    {
+        collectSamples(log, bHaveTruth, truth, samples);
+    }
+
+    RangeQualityModel model;
+    if (!model.fit(samples.rxPower, samples.residuals))
+    {
+        printf("CALIBRATE ERROR: Not enough range samples, or no spread in rxPower, to fit the model\n");
+        return 1;
+    }
+
+    std::vector<double> sortedPower = samples.rxPower;
+    std::sort(sortedPower.begin(), sortedPower.end());
+    size_t nlosCount = std::lower_bound(sortedPower.begin(), sortedPower.end(), model.nlosPower) - sortedPower.begin();
+
+    printf("\nlog(R) = %.4f + %.5f * rxPower\n", model.logVarOffset, model.logVarSlope);
+    const double percentiles[] = {0.05, 0.5, 0.95};
+    for (double p : percentiles)
+    {
+        double power = sortedPower[static_cast<size_t>(p * (sortedPower.size() - 1))];
+        printf("  P%02d rxPower %7.2f dBm -> range std %.4f m\n", static_cast<int>(p * 100), power, sqrt(model.variance(power)));
+    }
+    printf("  %.1f%% of ranges below the NLOS power threshold (%.1f dBm)\n", 100.0 * nlosCount / sortedPower.size(), model.nlosPower);
+
+    return model.save(outPath) ? 0 : 1;
+}
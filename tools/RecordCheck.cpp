@@ -0,0 +1,192 @@
+// Checks the route recorder decimation and the open path levels used to draw a recording
+// Usage: RecordCheck [laps] [--seed s]
+// Drives laps of a rounded rectangle at the encoder rate with a spin on the spot at one corner, feeding the
+// pose to PathRecorder. The recording has to stay close to the driven track, keep gaps no longer than the
+// spacing on straights, keep corners denser than straights and keep no more than the spin point while
+// spinning. The drawing levels of the recording have to stay within their tolerance, and a long straight
+// then has to fill the buffer and stop the recording.
+// Exits with 1 on any failure.
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Localization/PathLod.hpp"
+#include "Localization/PathRecorder.hpp"
+
+#define CHECK_DEFAULT_LAPS 3
+#define CHECK_DEFAULT_SEED 1
+#define CHECK_DT 0.02 // s, encoder packet period
+#define CHECK_SPEED 0.2 // m/s
+#define CHECK_SPIN_RATE 1.0 // rad/s
+#define CHECK_SIDE 2.0 // m, straight between corners
+#define CHECK_CORNER_RADIUS 0.15 // m, tight enough for the heading threshold to beat the spacing
+#define CHECK_HEADING_NOISE 0.002 // rad, per pose
+#define CHECK_MAX_DEVIATION 0.01 // m, driven track from the recorded polyline
+
+struct Leg
+{
+    double length; // m, or rad for a spin
+    double curvature; // 1/m
+    bool bSpin;
+};
+
+static double segmentDistance(const Eigen::Vector2d& p, const Eigen::Vector2d& a, const Eigen::Vector2d& b)
+{
+    Eigen::Vector2d ab = b - a;
+    double length2 = ab.squaredNorm();
+    double t = (length2 > 1e-18) ? std::clamp((p - a).dot(ab) / length2, 0.0, 1.0) : 0.0;
+    return (p - (a + t * ab)).norm();
+}
+
+static double polylineDistance(const Eigen::Vector2d& p, const std::vector<Eigen::Vector2d>& line, const std::vector<int>& indices)
+{
+    double best = INFINITY;
+    for (size_t k = 1; k < indices.size(); k++) best = std::min(best, segmentDistance(p, line[indices[k - 1]], line[indices[k]]));
+    return best;
+}
+
+int main(int argc, char const *argv[])
+{
+    int laps = CHECK_DEFAULT_LAPS;
+    unsigned int seed = CHECK_DEFAULT_SEED;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else laps = std::max(atoi(argv[i]), 1);
+    }
+
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> headingNoise(0.0, CHECK_HEADING_NOISE);
+
+    std::vector<Leg> lap;
+    for (int corner = 0; corner < 4; corner++)
+    {
+        lap.push_back({CHECK_SIDE, 0, false});
+        lap.push_back({0.5 * M_PI * CHECK_CORNER_RADIUS, 1.0 / CHECK_CORNER_RADIUS, false});
+        if (corner == 1) lap.push_back({2.0 * M_PI, 0, true});
+    }
+
+    PathRecorder recorder;
+    recorder.start();
+    Eigen::Vector3d pose = Eigen::Vector3d::Zero();
+    std::vector<Eigen::Vector2d> track = {pose.head<2>()};
+    recorder.addPose(pose);
+
+    size_t spinAdded = 0; // Most points kept by one spin
+    double straightLength = 0, cornerLength = 0;
+    size_t straightPoints = 0, cornerPoints = 0;
+    for (int l = 0; l < laps; l++)
+    {
+        for (const Leg& leg : lap)
+        {
+            size_t before = recorder.points().size();
+            double rate = leg.bSpin ? CHECK_SPIN_RATE : CHECK_SPEED;
+            int steps = static_cast<int>(ceil(leg.length / (rate * CHECK_DT)));
+            for (int k = 0; k < steps; k++)
+            {
+                double v = leg.bSpin ? 0.0 : CHECK_SPEED;
+                double omega = leg.bSpin ? CHECK_SPIN_RATE : CHECK_SPEED * leg.curvature;
+                pose.head<2>() += v * CHECK_DT * Eigen::Vector2d(cos(pose.z()), sin(pose.z()));
+                pose.z() += omega * CHECK_DT;
+                track.push_back(pose.head<2>());
+
+                Eigen::Vector3d measured = pose;
+                measured.z() += headingNoise(gen);
+                recorder.addPose(measured);
+            }
+
+            size_t added = recorder.points().size() - before;
+            if (leg.bSpin) spinAdded = std::max(spinAdded, added);
+            else if (leg.curvature == 0) { straightLength += leg.length; straightPoints += added; }
+            else { cornerLength += leg.length; cornerPoints += added; }
+        }
+    }
+    recorder.stop();
+
+    const std::vector<Eigen::Vector2d>& points = recorder.points();
+    std::vector<int> all(points.size());
+    for (size_t i = 0; i < points.size(); i++) all[i] = static_cast<int>(i);
+
+    double deviation = 0;
+    for (const Eigen::Vector2d& p : track) deviation = std::max(deviation, polylineDistance(p, points, all));
+
+    double longestGap = 0;
+    for (size_t i = 1; i < points.size(); i++) longestGap = std::max(longestGap, (points[i] - points[i - 1]).norm());
+
+    double straightSpacing = straightLength / std::max<size_t>(straightPoints, 1);
+    double cornerSpacing = cornerLength / std::max<size_t>(cornerPoints, 1);
+    printf("%d laps, %zu poses, %zu points kept (seed %u)\n", laps, recorder.samples, points.size(), seed);
+    printf("  Deviation %.4f m, longest gap %.4f m, spacing %.3f m on straights, %.3f m on corners, at most %zu added by a spin\n",
+        deviation, longestGap, straightSpacing, cornerSpacing, spinAdded);
+
+    bool bPass = true;
+    if (deviation > CHECK_MAX_DEVIATION)
+    {
+        printf("RECORD ERROR: The recording strays %.4f m from the driven track\n", deviation);
+        bPass = false;
+    }
+    if (longestGap > recorder.spacing + CHECK_SPEED * CHECK_DT + 1e-9)
+    {
+        printf("RECORD ERROR: A gap of %.4f m is longer than the spacing allows\n", longestGap);
+        bPass = false;
+    }
+    if (cornerSpacing >= straightSpacing)
+    {
+        printf("RECORD ERROR: Corners are no denser than straights\n");
+        bPass = false;
+    }
+    // The spin starts a corner, so the point where it happens may be kept but nothing more
+    if (spinAdded > 1)
+    {
+        printf("RECORD ERROR: Spinning on the spot added %zu points\n", spinAdded);
+        bPass = false;
+    }
+
+    // Every level drawn for the recording is within its tolerance of every point, ends included
+    PathLod lod;
+    lod.build(points, false);
+    double worstExcess = 0;
+    for (size_t level = 1; level < lod.levelCount(); level++)
+    {
+        double tolerance = lod.levelTolerance(level);
+        const std::vector<int>& kept = lod.level(tolerance);
+        if (kept.front() != 0 || kept.back() != static_cast<int>(points.size()) - 1)
+        {
+            printf("RECORD ERROR: Level %zu does not keep both ends of the route\n", level);
+            bPass = false;
+        }
+        for (const Eigen::Vector2d& p : points) worstExcess = std::max(worstExcess, polylineDistance(p, points, kept) - tolerance);
+    }
+    printf("  %zu drawing levels, coarsest keeps %zu points, worst excess over tolerance %.2e m\n",
+        lod.levelCount(), lod.level(INFINITY).size(), std::max(worstExcess, 0.0));
+    if (worstExcess > 1e-9)
+    {
+        printf("RECORD ERROR: A drawing level strays %.2e m past its tolerance\n", worstExcess);
+        bPass = false;
+    }
+
+    // A drive longer than the buffer stops the recording with the buffer full
+    recorder.start();
+    Eigen::Vector3d straight = Eigen::Vector3d::Zero();
+    const double step = CHECK_SPEED * CHECK_DT;
+    size_t fillSamples = static_cast<size_t>((recorder.capacity() + 10) * (recorder.spacing + step) / step);
+    for (size_t k = 0; k < fillSamples && recorder.isRecording(); k++)
+    {
+        straight.x() += step;
+        recorder.addPose(straight);
+    }
+    printf("  Long drive: %zu points of %zu, %s\n", recorder.points().size(), recorder.capacity(), recorder.isRecording() ? "still recording" : "stopped");
+    if (recorder.isRecording() || recorder.points().size() != recorder.capacity())
+    {
+        printf("RECORD ERROR: A full buffer did not stop the recording\n");
+        bPass = false;
+    }
+
+    return bPass ? 0 : 1;
+}
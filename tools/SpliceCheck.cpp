@@ -0,0 +1,133 @@
+// Checks the incremental spline and speed profile splice against a full rebuild
+// Usage: SpliceCheck [edits] [waypoints] [--seed s]
+// Applies random moves and removals through SplinePath::splice and VelocityProfile::splice, the same calls
+// PathController makes, and compares every sample with a fresh build after each edit. Exits with 1 on a mismatch.
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Localization/SplinePath.hpp"
+#include "Localization/VelocityProfile.hpp"
+
+#define SPLICE_DEFAULT_EDITS 300
+#define SPLICE_DEFAULT_WAYPOINTS 2000
+#define SPLICE_DEFAULT_SEED 1
+#define SPLICE_MOVE_STEP 0.05 // m, largest waypoint move per edit
+#define SPLICE_TOLERANCE 1e-9
+
+struct Difference
+{
+    double point = 0;
+    double distance = 0;
+    double speed = 0;
+    bool bSizeMismatch = false;
+
+    double worst() const { return std::max({point, distance, speed}); }
+};
+
+static Difference compare(const SplinePath& spline, const VelocityProfile& profile, const std::vector<Eigen::Vector2d>& waypoints)
+{
+    SplinePath reference;
+    reference.build(waypoints);
+    VelocityProfile referenceProfile;
+    referenceProfile.build(reference);
+
+    Difference diff;
+    if (reference.points.size() != spline.points.size() || referenceProfile.speed.size() != profile.speed.size())
+    {
+        diff.bSizeMismatch = true;
+        return diff;
+    }
+
+    for (size_t i = 0; i < reference.points.size(); i++)
+    {
+        diff.point = std::max(diff.point, (reference.points[i] - spline.points[i]).norm());
+        diff.distance = std::max(diff.distance, fabs(reference.distance[i] - spline.distance[i]));
+    }
+    for (size_t i = 0; i < referenceProfile.speed.size(); i++)
+    {
+        diff.speed = std::max(diff.speed, fabs(referenceProfile.speed[i] - profile.speed[i]));
+    }
+    return diff;
+}
+
+int main(int argc, char const *argv[])
+{
+    int edits = SPLICE_DEFAULT_EDITS;
+    int count = SPLICE_DEFAULT_WAYPOINTS;
+    unsigned int seed = SPLICE_DEFAULT_SEED;
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else if (positional == 0) { edits = std::max(atoi(argv[i]), 1); positional++; }
+        else if (positional == 1) { count = std::max(atoi(argv[i]), 8); positional++; }
+    }
+
+    // Wavy ellipse, tight enough in places for the curvature limit to matter
+    std::vector<Eigen::Vector2d> waypoints;
+    for (int i = 0; i < count; i++)
+    {
+        double a = 2.0 * M_PI * i / count;
+        waypoints.push_back({cos(a) * 3.0 + 0.05 * sin(a * 40.0), 2.0 * sin(a)});
+    }
+
+    SplinePath spline;
+    VelocityProfile profile;
+    spline.build(waypoints);
+    profile.build(spline);
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> step(-SPLICE_MOVE_STEP, SPLICE_MOVE_STEP);
+    Difference worst;
+    size_t visited = 0, fallbacks = 0;
+    double spliceMs = 0;
+
+    for (int e = 0; e < edits; e++)
+    {
+        // Interior edits only, PathController rebuilds for anything touching the ends of the loop
+        int index = 2 + static_cast<int>(gen() % (waypoints.size() - 4));
+        bool bRemove = (e % 5 == 0) && waypoints.size() > 8;
+
+        auto start = std::chrono::steady_clock::now();
+        if (bRemove) waypoints.erase(waypoints.begin() + index);
+        else waypoints[index] += Eigen::Vector2d(step(gen), step(gen));
+
+        size_t firstSample, oldSamples, newSamples;
+        if (spline.splice(waypoints, static_cast<size_t>(index - 2), 4, bRemove ? 3 : 4, firstSample, oldSamples, newSamples))
+        {
+            profile.splice(spline, firstSample, oldSamples, newSamples);
+        }
+        else
+        {
+            profile.build(spline);
+            fallbacks++;
+        }
+        spliceMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        visited += profile.lastUpdateSamples;
+
+        Difference diff = compare(spline, profile, waypoints);
+        if (diff.bSizeMismatch || diff.worst() > SPLICE_TOLERANCE)
+        {
+            printf("SPLICE ERROR: Edit %d (%s waypoint %d) differs from a full build: %s, point %.2e, distance %.2e, speed %.2e\n",
+                e, bRemove ? "remove" : "move", index, diff.bSizeMismatch ? "sample count" : "values", diff.point, diff.distance, diff.speed);
+            return 1;
+        }
+        worst.point = std::max(worst.point, diff.point);
+        worst.distance = std::max(worst.distance, diff.distance);
+        worst.speed = std::max(worst.speed, diff.speed);
+    }
+
+    printf("%d edits on %zu waypoints, %zu samples (seed %u)\n", edits, waypoints.size(), spline.points.size(), seed);
+    printf("  Max difference: point %.2e m, distance %.2e m, speed %.2e m/s\n", worst.point, worst.distance, worst.speed);
+    printf("  Splice: %.3f ms, %.0f samples visited on average, %zu full rebuilds\n", spliceMs / edits, static_cast<double>(visited) / edits, fallbacks);
+    return 0;
+}